@@ -9,12 +9,15 @@
 #include "Foundation.h"
 #include "Game.h"
 
+#include <winrt/Windows.Graphics.Display.h>
+
 using namespace winrt;
 
 using namespace Windows;
 using namespace Windows::ApplicationModel::Core;
 using namespace Windows::Foundation;
 using namespace Windows::Foundation::Numerics;
+using namespace Windows::Graphics::Display;
 using namespace Windows::System;
 using namespace Windows::UI;
 using namespace Windows::UI::Core;
@@ -28,7 +31,9 @@ struct App : implements<App, IFrameworkViewSource, IFrameworkView>
     SpriteVisual m_root{ nullptr };
 
     std::unique_ptr<Game> m_game;
+    Compositing::CardRendering m_cardRendering = Compositing::CardRendering::Shapes;
     ContainerVisual m_content{ nullptr };
+    std::chrono::steady_clock::time_point m_launchTime = std::chrono::steady_clock::now();
 
     IFrameworkView CreateView()
     {
@@ -78,14 +83,42 @@ struct App : implements<App, IFrameworkViewSource, IFrameworkView>
         m_content.Scale({ scale, scale, 1.0f });
         m_root.Children().InsertAtTop(m_content);
         
-        m_game = std::make_unique<Game>(m_compositor, m_content.Size());
-        m_content.Children().InsertAtTop(m_game->Root());
+        CreateGame(window);
 
         window.PointerPressed({ this, &App::OnPointerPressed });
         window.PointerMoved({ this, &App::OnPointerMoved });
         window.PointerReleased({ this, &App::OnPointerReleased });
         window.SizeChanged({ this, &App::OnSizeChanged });
         window.KeyUp({ this, &App::OnKeyUp });
+        DisplayInformation::GetForCurrentView().DpiChanged({ this, &App::OnDpiChanged });
+
+        // A commit batch completes once everything above has been committed,
+        // which is as close as we can get to the first frame.
+        auto batch = m_compositor.CreateScopedBatch(CompositionBatchTypes::Commit);
+        batch.Completed([launchTime = m_launchTime, resources = m_game->Resources()](auto&& ...)
+            {
+                std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - launchTime;
+                std::wstringstream debugMessage;
+                debugMessage << L"First frame " << elapsed.count() << L"ms after launch, "
+                    << resources.Geometries << L" geometries, "
+                    << resources.Brushes << L" brushes, "
+                    << resources.Shapes << L" shapes" << std::endl;
+                OutputDebugStringW(debugMessage.str().c_str());
+            });
+        batch.End();
+    }
+
+    // Replaces the game with a new one that draws cards the current way.
+    void CreateGame(CoreWindow const& window)
+    {
+        if (m_game)
+        {
+            m_game->SaveReplay();
+        }
+        m_content.Children().RemoveAll();
+        m_game = std::make_unique<Game>(m_compositor, m_content.Size(), m_cardRendering);
+        m_content.Children().InsertAtTop(m_game->Root());
+        m_game->OnScaleChanged(ComputeRasterizationScale(window));
     }
 
     float ComputeScaleFactor(float2 const windowSize, float2 const contentSize)
@@ -102,6 +135,14 @@ struct App : implements<App, IFrameworkViewSource, IFrameworkView>
         return scaleFactor;
     }
 
+    // Screen pixels per unit of content, what the card atlas is drawn for.
+    float ComputeRasterizationScale(CoreWindow const& window)
+    {
+        float2 const windowSize = { window.Bounds().Width, window.Bounds().Height };
+        auto pixelsPerViewPixel = (float)DisplayInformation::GetForCurrentView().RawPixelsPerViewPixel();
+        return ComputeScaleFactor(windowSize, m_content.Size()) * pixelsPerViewPixel;
+    }
+
     float4x4 ComputeContentTransform(float2 const windowSize, float2 const contentSize)
     {
         auto result = float4x4::identity();
@@ -157,6 +198,12 @@ struct App : implements<App, IFrameworkViewSource, IFrameworkView>
         auto scale = ComputeScaleFactor(windowSize, m_content.Size());
         m_content.Scale({ scale, scale, 1.0f });
         m_game->OnSizeChanged(m_content.Size());
+        m_game->OnScaleChanged(ComputeRasterizationScale(window));
+    }
+
+    void OnDpiChanged(DisplayInformation const&, IInspectable const&)
+    {
+        m_game->OnScaleChanged(ComputeRasterizationScale(CoreWindow::GetForCurrentThread()));
     }
 
     void App::OnKeyUp(CoreWindow const& window, KeyEventArgs const& args)
@@ -199,10 +246,35 @@ struct App : implements<App, IFrameworkViewSource, IFrameworkView>
 
             m_game->LayoutInfo(layout);
         }
+        else if (key == VirtualKey::L && isControlDown)
+        {
+            // Switch the piles between nested and flat item containers.
+            auto layout = m_game->LayoutInfo();
+            layout.PileMode = layout.PileMode == Layout::PileMode::Nested ? Layout::PileMode::Flat : Layout::PileMode::Nested;
+            m_game->LayoutInfo(layout);
+        }
+        else if (key == VirtualKey::R && isControlDown)
+        {
+            // Switch the cards between shapes and the atlas, in a new game.
+            m_cardRendering = m_cardRendering == Compositing::CardRendering::Shapes ? Compositing::CardRendering::Atlas : Compositing::CardRendering::Shapes;
+            CreateGame(window);
+        }
         else if (key == VirtualKey::N && isControlDown)
         {
             m_game->NewGame();
         }
+        else if (key == VirtualKey::Z && isControlDown)
+        {
+            m_game->Undo();
+        }
+        else if (key == VirtualKey::Y && isControlDown)
+        {
+            m_game->Redo();
+        }
+        else if (key == VirtualKey::S && isControlDown)
+        {
+            m_game->DisplayIsGameWinnableMessage();
+        }
     }
 
     void PrintTree(CoreWindow const& window)
@@ -210,6 +282,9 @@ struct App : implements<App, IFrameworkViewSource, IFrameworkView>
         std::wstringstream stringStream;
         stringStream << L"Window Size: " << window.Bounds().Width << L", " << window.Bounds().Height << std::endl;
         Debug::PrintTree(m_root, stringStream, 0);
+        Debug::TreeSize treeSize;
+        Debug::MeasureTree(m_root, 0, treeSize);
+        stringStream << treeSize.Visuals << L" visuals, " << treeSize.Depth << L" levels deep" << std::endl;
         Debug::OutputDebugStringStream(stringStream);
     }
 };
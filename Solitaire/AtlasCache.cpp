@@ -0,0 +1,112 @@
+﻿#include "pch.h"
+#include "AtlasCache.h"
+
+#include <winrt/Windows.Graphics.h>
+#include <winrt/Windows.Graphics.DirectX.h>
+#include <winrt/Microsoft.Graphics.Canvas.h>
+#include <winrt/Microsoft.Graphics.Canvas.UI.Composition.h>
+
+using namespace winrt;
+
+using namespace Windows::Foundation::Numerics;
+using namespace Windows::Graphics;
+using namespace Windows::Graphics::DirectX;
+using namespace Windows::UI;
+using namespace Windows::UI::Composition;
+
+using namespace Microsoft::Graphics::Canvas;
+using namespace Microsoft::Graphics::Canvas::UI::Composition;
+
+AtlasCache::AtlasCache(
+    ::Compositor const& compositor,
+    Layout::CardOutlines const& outlines) : m_atlas(outlines)
+{
+    m_compositor = compositor;
+    m_device = CanvasDevice::GetSharedDevice();
+    m_graphicsDevice = CanvasComposition::CreateCompositionGraphicsDevice(m_compositor, m_device);
+    m_surface = m_graphicsDevice.CreateDrawingSurface(
+        { 1, 1 },
+        DirectXPixelFormat::B8G8R8A8UIntNormalized,
+        DirectXAlphaMode::Premultiplied);
+    m_brushes.resize(Raster::AtlasCellCount, nullptr);
+
+    // The surface's contents are lost along with the device.
+    m_deviceReplaced = m_graphicsDevice.RenderingDeviceReplaced(auto_revoke, [this](auto&&...)
+        {
+            if (m_atlasScale > 0)
+            {
+                Draw();
+            }
+        });
+}
+
+CompositionSurfaceBrush AtlasCache::GetBrush(int cell)
+{
+    auto& brush = m_brushes[cell];
+    if (!brush)
+    {
+        brush = m_compositor.CreateSurfaceBrush(m_surface);
+        brush.Stretch(CompositionStretch::None);
+        brush.HorizontalAlignmentRatio(0);
+        brush.VerticalAlignmentRatio(0);
+        if (m_atlasScale > 0)
+        {
+            PlaceBrush(cell);
+        }
+    }
+    return brush;
+}
+
+void AtlasCache::RasterizationScale(float scale)
+{
+    auto atlasScale = Raster::AtlasScaleFor(scale);
+    if (atlasScale == m_atlasScale)
+    {
+        return;
+    }
+
+    m_atlasScale = atlasScale;
+    m_atlas.Render(m_atlasScale, m_image);
+    Draw();
+    for (auto i = 0; i < Raster::AtlasCellCount; i++)
+    {
+        if (m_brushes[i])
+        {
+            PlaceBrush(i);
+        }
+    }
+}
+
+Compositing::ResourceCounts AtlasCache::Resources() const
+{
+    Compositing::ResourceCounts resources;
+    resources.Brushes = (uint64_t)std::count_if(m_brushes.begin(), m_brushes.end(), [](auto const& brush) { return brush != nullptr; });
+    resources.Surfaces = 1;
+    resources.SurfaceBytes = m_image.Pixels.size();
+    return resources;
+}
+
+void AtlasCache::Draw()
+{
+    CanvasComposition::Resize(m_surface, { m_image.Width, m_image.Height });
+    auto bitmap = CanvasBitmap::CreateFromBytes(
+        m_device,
+        m_image.Pixels,
+        m_image.Width,
+        m_image.Height,
+        DirectXPixelFormat::B8G8R8A8UIntNormalized);
+    auto session = CanvasComposition::CreateDrawingSession(m_surface);
+    session.Clear(Colors::Transparent());
+    session.DrawImage(bitmap);
+    session.Close();
+}
+
+// Maps the cell's pixels onto the card, so at the atlas scale one pixel of
+// the atlas lands on one pixel of the screen.
+void AtlasCache::PlaceBrush(int cell)
+{
+    auto bounds = Raster::CardAtlas::Cell(cell, m_atlasScale);
+    m_brushes[cell].TransformMatrix(
+        make_float3x2_translation(-(float)bounds.X, -(float)bounds.Y) *
+        make_float3x2_scale(1.0f / m_atlasScale));
+}
\ No newline at end of file
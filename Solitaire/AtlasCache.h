@@ -0,0 +1,37 @@
+#pragma once
+#include <winrt/Microsoft.Graphics.Canvas.h>
+#include "CardAtlas.h"
+#include "Compositing.h"
+
+// Holds the card atlas on a composition surface and the brushes that show
+// each card from it. The atlas is drawn on the CPU at the atlas scale for
+// the scale the cards are shown at, and drawn again only when that changes.
+class AtlasCache
+{
+public:
+    // The outlines have to outlive the cache.
+    AtlasCache(winrt::Windows::UI::Composition::Compositor const& compositor, Layout::CardOutlines const& outlines);
+    ~AtlasCache() {}
+
+    // Shared by every visual showing that cell.
+    winrt::Windows::UI::Composition::CompositionSurfaceBrush GetBrush(int cell);
+    void RasterizationScale(float scale);
+
+    Compositing::ResourceCounts Resources() const;
+
+private:
+    void Draw();
+    void PlaceBrush(int cell);
+
+private:
+    winrt::Windows::UI::Composition::Compositor m_compositor{ nullptr };
+    winrt::Microsoft::Graphics::Canvas::CanvasDevice m_device{ nullptr };
+    winrt::Windows::UI::Composition::CompositionGraphicsDevice m_graphicsDevice{ nullptr };
+    winrt::Windows::UI::Composition::CompositionDrawingSurface m_surface{ nullptr };
+    winrt::Windows::UI::Composition::CompositionGraphicsDevice::RenderingDeviceReplaced_revoker m_deviceReplaced;
+    std::vector<winrt::Windows::UI::Composition::CompositionSurfaceBrush> m_brushes;
+    Raster::CardAtlas m_atlas;
+    Raster::Image m_image;
+    // Zero until the scale is known and the atlas drawn.
+    float m_atlasScale = 0;
+};
\ No newline at end of file
@@ -1,4 +1,6 @@
 ﻿#pragma once
+#include <cstdint>
+#include <string>
 
 enum class Face
 {
@@ -17,6 +19,8 @@ enum class Face
     King = 13
 };
 
+constexpr int FaceCount = 13;
+
 enum class Suit
 {
     Diamond = 0,
@@ -25,81 +29,85 @@ enum class Suit
     Club = 3
 };
 
+constexpr int SuitCount = 4;
+
+// A card packs into a single byte: the face in the upper six bits and the
+// suit in the lower two. Values run from 4 (A♦) to 55 (K♣), so a zero byte
+// never names a real card.
 struct Card
 {
-    Card() : m_face(Face::Ace), m_suit(Suit::Diamond) {}
-    Card(Face face, Suit suit) : m_face(face), m_suit(suit) {}
-    ~Card() {}
+    constexpr Card() : m_value(Pack(Face::Ace, Suit::Diamond)) {}
+    constexpr Card(::Face face, ::Suit suit) : m_value(Pack(face, suit)) {}
+    ~Card() = default;
+
+    // Index into a fresh pack (the order Pack builds its cards in), 0 - 51.
+    static constexpr Card FromIndex(int index) { return Card((uint8_t)(index + 4)); }
 
-    Face Face() { return m_face; }
-    Suit Suit() { return m_suit; }
-    winrt::hstring ToString()
+    constexpr ::Face Face() const { return (::Face)(m_value >> 2); }
+    constexpr ::Suit Suit() const { return (::Suit)(m_value & 0x3); }
+    constexpr int Index() const { return m_value - 4; }
+    constexpr uint8_t Value() const { return m_value; }
+    std::wstring ToString() const { return std::wstring(FaceText(Face())) + SuitText(Suit()); }
+    constexpr bool IsRed() const { return (m_value & 0x1) == 0; }
+
+    // How a face and a suit are written on a card.
+    static constexpr wchar_t const* FaceText(::Face face)
     {
-        winrt::hstring result;
-        switch (m_face)
+        switch (face)
         {
         case Face::Ace:
-            result = L"A";
-            break;
+            return L"A";
         case Face::Two:
-            result = L"2";
-            break;
+            return L"2";
         case Face::Three:
-            result = L"3";
-            break;
+            return L"3";
         case Face::Four:
-            result = L"4";
-            break;
+            return L"4";
         case Face::Five:
-            result = L"5";
-            break;
+            return L"5";
         case Face::Six:
-            result = L"6";
-            break;
+            return L"6";
         case Face::Seven:
-            result = L"7";
-            break;
+            return L"7";
         case Face::Eight:
-            result = L"8";
-            break;
+            return L"8";
         case Face::Nine:
-            result = L"9";
-            break;
+            return L"9";
         case Face::Ten:
-            result = L"10";
-            break;
+            return L"10";
         case Face::Jack:
-            result = L"J";
-            break;
+            return L"J";
         case Face::Queen:
-            result = L"Q";
-            break;
+            return L"Q";
         case Face::King:
-            result = L"K";
-            break;
+            return L"K";
         }
-        switch (m_suit)
+        return L"";
+    }
+    static constexpr wchar_t const* SuitText(::Suit suit)
+    {
+        switch (suit)
         {
         case Suit::Diamond:
-            result = result + L"♦";
-            break;
+            return L"♦";
         case Suit::Spade:
-            result = result + L"♠";
-            break;
+            return L"♠";
         case Suit::Heart:
-            result = result + L"♥";
-            break;
+            return L"♥";
         case Suit::Club:
-            result = result + L"♣";
-            break;
+            return L"♣";
         }
-        return result;
+        return L"";
     }
-    bool IsRed() { return (int)m_suit % 2 == 0; }
 
-    bool operator==(const Card& other) { return m_face == other.m_face && m_suit == other.m_suit; }
+    constexpr bool operator==(const Card& other) const { return m_value == other.m_value; }
+    constexpr bool operator!=(const Card& other) const { return m_value != other.m_value; }
 
 private:
-    ::Face m_face;
-    ::Suit m_suit;
-};
\ No newline at end of file
+    explicit constexpr Card(uint8_t value) : m_value(value) {}
+    static constexpr uint8_t Pack(::Face face, ::Suit suit) { return (uint8_t)(((int)face << 2) | (int)suit); }
+
+    uint8_t m_value;
+};
+
+static_assert(sizeof(Card) == 1, "Cards are expected to pack into a single byte");
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "CardAtlas.h"
+#include "PileLayout.h"
+
+namespace Raster
+{
+    constexpr float FrameRadius = 10;
+    constexpr float FrameThickness = 2;
+    constexpr float TextInset = 5;
+
+    float AtlasScaleFor(float scale)
+    {
+        for (auto atlasScale : AtlasScales)
+        {
+            if (atlasScale >= scale)
+            {
+                return atlasScale;
+            }
+        }
+        return *std::rbegin(AtlasScales);
+    }
+
+    AtlasCell CardAtlas::Cell(int index, float scale)
+    {
+        AtlasCell cell;
+        cell.Width = (int)std::ceil(Layout::CardWidth * scale);
+        cell.Height = (int)std::ceil(Layout::CardHeight * scale);
+        cell.X = (index % AtlasColumns) * (cell.Width + 2 * AtlasGutter) + AtlasGutter;
+        cell.Y = (index / AtlasColumns) * (cell.Height + 2 * AtlasGutter) + AtlasGutter;
+        return cell;
+    }
+
+    void CardAtlas::Size(float scale, int& width, int& height)
+    {
+        auto cell = Cell(0, scale);
+        auto rows = (AtlasCellCount + AtlasColumns - 1) / AtlasColumns;
+        width = AtlasColumns * (cell.Width + 2 * AtlasGutter);
+        height = rows * (cell.Height + 2 * AtlasGutter);
+    }
+
+    void CardAtlas::Render(float scale, Image& image)
+    {
+        int width;
+        int height;
+        Size(scale, width, height);
+        image.Resize(width, height);
+
+        // Every face has the same frame, so it's drawn once and copied.
+        Image frame;
+        RenderFrame(scale, frame);
+        auto rowSize = (size_t)frame.Width * 4;
+
+        for (auto i = 0; i < AtlasBackCell; i++)
+        {
+            auto card = Card::FromIndex(i);
+            auto cell = Cell(i, scale);
+            for (auto y = 0; y < cell.Height; y++)
+            {
+                std::memcpy(
+                    &image.Pixels[((size_t)(cell.Y + y) * image.Width + cell.X) * 4],
+                    &frame.Pixels[y * rowSize],
+                    rowSize);
+            }
+
+            auto face = (int)card.Face() - 1;
+            m_rasterizer.Transform(scale, { cell.X + TextInset * scale, (float)cell.Y });
+            m_rasterizer.AddPath(m_outlines.Faces[face]);
+            m_rasterizer.Transform(scale, { cell.X + (TextInset + m_outlines.FaceAdvances[face]) * scale, (float)cell.Y });
+            m_rasterizer.AddPath(m_outlines.Suits[(int)card.Suit()]);
+            m_rasterizer.Fill(image, card.IsRed() ? Colors::Crimson : Colors::Black);
+        }
+
+        RenderBack(Cell(AtlasBackCell, scale), scale, image);
+    }
+
+    void CardAtlas::RenderFrame(float scale, Image& frame)
+    {
+        auto cell = Cell(0, scale);
+        frame.Resize(cell.Width, cell.Height);
+        m_rasterizer.Transform(scale, {});
+
+        Layout::Rect const bounds{ 0, 0, Layout::CardWidth, Layout::CardHeight };
+        m_rasterizer.AddRoundedRectangle(bounds, FrameRadius);
+        m_rasterizer.Fill(frame, Colors::White);
+
+        auto half = FrameThickness / 2;
+        m_rasterizer.AddRoundedRectangleStroke({ half, half, Layout::CardWidth - FrameThickness, Layout::CardHeight - FrameThickness }, FrameRadius - half, FrameThickness);
+        m_rasterizer.Fill(frame, Colors::Gray);
+    }
+
+    void CardAtlas::RenderBack(AtlasCell const& cell, float scale, Image& image)
+    {
+        m_rasterizer.Transform(scale, { (float)cell.X, (float)cell.Y });
+
+        Layout::Rect const bounds{ 0, 0, Layout::CardWidth, Layout::CardHeight };
+        m_rasterizer.AddRoundedRectangle(bounds, FrameRadius);
+        m_rasterizer.Fill(image, Colors::Blue);
+
+        auto half = FrameThickness / 2;
+        m_rasterizer.AddRoundedRectangleStroke({ half, half, Layout::CardWidth - FrameThickness, Layout::CardHeight - FrameThickness }, FrameRadius - half, FrameThickness);
+        m_rasterizer.Fill(image, Colors::Gray);
+
+        m_rasterizer.AddRoundedRectangleStroke({ 6, 6, Layout::CardWidth - 12, Layout::CardHeight - 12 }, 6, 5);
+        m_rasterizer.Fill(image, Colors::White);
+    }
+}
\ No newline at end of file
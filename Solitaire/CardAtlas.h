@@ -0,0 +1,65 @@
+#pragma once
+#include "Card.h"
+#include "GlyphCache.h"
+#include "Rasterizer.h"
+
+// Every card face and the back drawn once into one image, for drawing cards
+// as sprites that sample it instead of as shapes. The atlas is drawn at one
+// of a few scales and only redrawn when the scale the cards are shown at
+// moves to another.
+namespace Raster
+{
+    // A cell for each card, in Card::Index order, then one for the back.
+    constexpr int AtlasCellCount = 53;
+    constexpr int AtlasBackCell = 52;
+    constexpr int AtlasColumns = 8;
+    // Transparent pixels around every cell, so sampling near a card's edge
+    // doesn't pick up its neighbor.
+    constexpr int AtlasGutter = 1;
+    constexpr float AtlasScales[] = { 0.5f, 0.75f, 1.0f, 1.5f, 2.0f };
+
+    // The smallest atlas scale at or above the scale, or the largest.
+    float AtlasScaleFor(float scale);
+
+    // A card's rectangle in the atlas, in pixels.
+    struct AtlasCell
+    {
+        int X = 0;
+        int Y = 0;
+        int Width = 0;
+        int Height = 0;
+    };
+
+    // Same colors as the shapes ShapeCache builds.
+    namespace Colors
+    {
+        constexpr Color Black{ 0, 0, 0 };
+        constexpr Color Blue{ 0, 0, 255 };
+        constexpr Color Crimson{ 220, 20, 60 };
+        constexpr Color Gray{ 128, 128, 128 };
+        constexpr Color White{ 255, 255, 255 };
+    }
+
+    class CardAtlas
+    {
+    public:
+        CardAtlas(Layout::CardOutlines const& outlines) : m_outlines(outlines) {}
+
+        static AtlasCell Cell(int index, float scale);
+        static int CellOf(Card card) { return card.Index(); }
+        static void Size(float scale, int& width, int& height);
+
+        // Draws the cards as ShapeCache's shapes would look at the scale. A
+        // sprite can't draw past its bounds, so the outlines are drawn just
+        // inside them rather than centered on the edge.
+        void Render(float scale, Image& image);
+
+    private:
+        void RenderFrame(float scale, Image& frame);
+        void RenderBack(AtlasCell const& cell, float scale, Image& image);
+
+    private:
+        Layout::CardOutlines const& m_outlines;
+        Rasterizer m_rasterizer;
+    };
+}
\ No newline at end of file
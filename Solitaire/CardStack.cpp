@@ -1,19 +1,16 @@
-#include "pch.h"
 #include "Card.h"
+#include "Klondike.h"
+#include "PileLayout.h"
 #include "CompositionCard.h"
-#include "ShapeCache.h"
 #include "CardStack.h"
 
-namespace winrt
-{
-    using namespace Windows::Foundation;
-    using namespace Windows::Foundation::Numerics;
-    using namespace Windows::UI::Composition;
-}
-
 void CardStack::SetLayoutOptions(float verticalOffset)
 {
-    m_verticalOffset = verticalOffset;
+    if (m_verticalOffset != verticalOffset)
+    {
+        m_verticalOffset = verticalOffset;
+        InvalidateLayout();
+    }
 }
 
 bool CardStack::CanSplit(int index)
@@ -24,12 +21,7 @@ bool CardStack::CanSplit(int index)
     }
 
     auto card = m_cards[index];
-    if (!card->IsFaceUp())
-    {
-        return false;
-    }
-
-    return true;
+    return Klondike::CanPickUpFromColumn(index, m_cards.size(), (*m_cardTable)[card].IsFaceUp());
 }
 
 bool CardStack::CanTake(int index)
@@ -37,7 +29,7 @@ bool CardStack::CanTake(int index)
     return false;
 }
 
-bool CardStack::CanAdd(Pile::CardList const& cards)
+bool CardStack::CanAdd(CardSpan cards)
 {
     if (cards.empty())
     {
@@ -49,43 +41,38 @@ bool CardStack::CanAdd(Pile::CardList const& cards)
         return false;
     }
 
-    auto card = cards.front();
-    auto cardValue = card->Value();
+    auto cardValue = CardOf(cards.front());
     if (m_cards.empty())
     {
-        return cardValue.Face() == Face::King;
+        return Klondike::CanStartColumn(cardValue);
     }
 
     auto lastCard = m_cards.back();
-    if (!lastCard->IsFaceUp())
-    {
-        return false;
-    }
-
-    auto lastCardValue = lastCard->Value();
-    if (cardValue.IsRed() == lastCardValue.IsRed())
+    if (!(*m_cardTable)[lastCard].IsFaceUp())
     {
         return false;
     }
 
-    return (int)cardValue.Face() == (int)lastCardValue.Face() - 1;
+    return Klondike::CanStackOn(cardValue, CardOf(lastCard));
 }
 
-winrt::float3 CardStack::ComputeOffset(int index, int totalCards)
+Compositing::Vector3 CardStack::ComputeOffset(int index, int totalCards)
 {
-    return { 0, index == 0 ? 0 : m_verticalOffset, 0 };
+    auto offset = Layout::ColumnOffset(index, m_verticalOffset);
+    return { offset.X, offset.Y, 0 };
 }
 
-winrt::float3 CardStack::ComputeBaseSpaceOffset(int index, int totalCards)
+Compositing::Vector3 CardStack::ComputeBaseSpaceOffset(int index, int totalCards)
 {
-    return { 0, index * m_verticalOffset, 0 };
+    auto offset = Layout::ColumnBaseSpaceOffset(index, m_verticalOffset);
+    return { offset.X, offset.Y, 0 };
 }
 
 void CardStack::OnRemovalCompleted(Pile::RemovalOperation operation)
 {
     if (!m_cards.empty())
     {
-        auto card = m_cards.back();
-        card->AnimateIsFaceUp(true, std::chrono::milliseconds(250), std::chrono::milliseconds(0));
+        auto& card = (*m_cardTable)[m_cards.back()];
+        card.AnimateIsFaceUp(true, std::chrono::milliseconds(250), std::chrono::milliseconds(0));
     }
 }
\ No newline at end of file
@@ -1,23 +1,20 @@
 #pragma once
 #include "Pile.h"
 
-class ShapeCache;
-class CompositionCard;
-
 class CardStack : public Pile
 {
 public:
-    CardStack(std::shared_ptr<ShapeCache> const& shapeCache, std::vector<std::shared_ptr<CompositionCard>> cards) : Pile(shapeCache, cards) { m_background.Comment(L"CardStack Root"); }
+    CardStack(std::shared_ptr<Compositing::Compositor> const& compositor, std::shared_ptr<ItemContainerPool> const& itemContainerPool, std::shared_ptr<CardTable> const& cardTable, CardSpan cards = {}) : Pile(compositor, itemContainerPool, cardTable, cards) { m_background->Comment(L"CardStack Root"); }
 
     void SetLayoutOptions(float verticalOffset);
 
     virtual bool CanSplit(int index) override;
     virtual bool CanTake(int index) override;
-    virtual bool CanAdd(Pile::CardList const& cards) override;
+    virtual bool CanAdd(CardSpan cards) override;
 
 protected:
-    virtual winrt::Windows::Foundation::Numerics::float3 ComputeOffset(int index, int totalCards) override;
-    virtual winrt::Windows::Foundation::Numerics::float3 ComputeBaseSpaceOffset(int index, int totalCards) override;
+    virtual Compositing::Vector3 ComputeOffset(int index, int totalCards) override;
+    virtual Compositing::Vector3 ComputeBaseSpaceOffset(int index, int totalCards) override;
     virtual void OnRemovalCompleted(Pile::RemovalOperation operation) override;
 
 private:
@@ -0,0 +1,15 @@
+#include "Card.h"
+#include "CompositionCard.h"
+#include "CardTable.h"
+
+CardTable::CardTable(std::shared_ptr<Compositing::Compositor> const& compositor)
+{
+    for (size_t i = 0; i < CardHandleCount; i++)
+    {
+        m_cards[i] = std::make_unique<CompositionCard>(CardOf((CardHandle)i), compositor);
+    }
+}
+
+CardTable::~CardTable()
+{
+}
\ No newline at end of file
@@ -0,0 +1,132 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include "Card.h"
+#include "Compositing.h"
+
+class CompositionCard;
+
+// The piles, deck and game pass cards around as one byte handles rather than
+// shared pointers. A handle is the card's index in a fresh pack, so it never
+// changes for the life of the game and names the same CompositionCard in the
+// game's CardTable.
+using CardHandle = uint8_t;
+constexpr size_t CardHandleCount = 52;
+
+constexpr CardHandle HandleOf(Card card) { return (CardHandle)card.Index(); }
+constexpr Card CardOf(CardHandle handle) { return Card::FromIndex(handle); }
+
+// A read only run of handles, in place of std::span.
+class CardSpan
+{
+public:
+    using const_iterator = CardHandle const*;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    constexpr CardSpan() {}
+    constexpr CardSpan(CardHandle const* data, size_t size) : m_data(data), m_size(size) {}
+
+    CardHandle const* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    const_iterator begin() const { return m_data; }
+    const_iterator end() const { return m_data + m_size; }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+    CardHandle operator[](size_t index) const { assert(index < m_size); return m_data[index]; }
+    CardHandle front() const { assert(m_size > 0); return m_data[0]; }
+    CardHandle back() const { assert(m_size > 0); return m_data[m_size - 1]; }
+    CardSpan subspan(size_t offset, size_t count) const { assert(offset + count <= m_size); return { m_data + offset, count }; }
+    CardSpan subspan(size_t offset) const { assert(offset <= m_size); return { m_data + offset, m_size - offset }; }
+
+private:
+    CardHandle const* m_data = nullptr;
+    size_t m_size = 0;
+};
+
+// Up to a whole pack of handles, held inline so lists copy and return
+// without touching the heap.
+class CardHandleList
+{
+public:
+    using iterator = CardHandle*;
+    using const_iterator = CardHandle const*;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    CardHandleList() {}
+    CardHandleList(std::initializer_list<CardHandle> handles)
+    {
+        for (auto handle : handles)
+        {
+            push_back(handle);
+        }
+    }
+    explicit CardHandleList(CardSpan handles)
+    {
+        for (auto handle : handles)
+        {
+            push_back(handle);
+        }
+    }
+
+    operator CardSpan() const { return { m_handles.data(), m_size }; }
+
+    CardHandle const* data() const { return m_handles.data(); }
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    iterator begin() { return m_handles.data(); }
+    iterator end() { return m_handles.data() + m_size; }
+    const_iterator begin() const { return m_handles.data(); }
+    const_iterator end() const { return m_handles.data() + m_size; }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+    CardHandle operator[](size_t index) const { assert(index < m_size); return m_handles[index]; }
+    CardHandle front() const { assert(m_size > 0); return m_handles[0]; }
+    CardHandle back() const { assert(m_size > 0); return m_handles[m_size - 1]; }
+
+    void clear() { m_size = 0; }
+    void push_back(CardHandle handle)
+    {
+        assert(m_size < CardHandleCount);
+        m_handles[m_size++] = handle;
+    }
+    void insert(const_iterator position, CardHandle handle)
+    {
+        assert(m_size < CardHandleCount);
+        auto index = position - begin();
+        std::copy_backward(begin() + index, end(), end() + 1);
+        m_handles[index] = handle;
+        m_size++;
+    }
+    void erase(const_iterator position) { erase(position, position + 1); }
+    void erase(const_iterator first, const_iterator last)
+    {
+        auto index = first - begin();
+        auto count = last - first;
+        std::copy(begin() + index + count, end(), begin() + index);
+        m_size -= (uint8_t)count;
+    }
+
+private:
+    std::array<CardHandle, CardHandleCount> m_handles;
+    uint8_t m_size = 0;
+};
+
+// The 52 cards of a game, indexed by handle.
+class CardTable
+{
+public:
+    CardTable(std::shared_ptr<Compositing::Compositor> const& compositor);
+    ~CardTable();
+
+    CompositionCard& operator[](CardHandle handle) { return *m_cards[handle]; }
+
+private:
+    std::array<std::unique_ptr<CompositionCard>, CardHandleCount> m_cards;
+};
\ No newline at end of file
@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <cassert>
+#include "Compositing.h"
+
+namespace Compositing
+{
+    void Visual::InsertAtTop(VisualPtr const& child)
+    {
+        assert(!child->Parent());
+        m_children.push_back(child);
+        child->m_parent = weak_from_this();
+        m_counts.Inserts++;
+        OnInsertAtTop(*child);
+    }
+
+    void Visual::InsertAbove(VisualPtr const& child, VisualPtr const& sibling)
+    {
+        assert(!child->Parent());
+        auto position = std::find(m_children.begin(), m_children.end(), sibling);
+        assert(position != m_children.end());
+        m_children.insert(position + 1, child);
+        child->m_parent = weak_from_this();
+        m_counts.Inserts++;
+        OnInsertAbove(*child, *sibling);
+    }
+
+    void Visual::Remove(VisualPtr const& child)
+    {
+        auto position = std::find(m_children.begin(), m_children.end(), child);
+        if (position == m_children.end())
+        {
+            return;
+        }
+        // Keep the child alive until the backend has seen it go.
+        auto removed = std::move(*position);
+        m_children.erase(position);
+        removed->m_parent.reset();
+        m_counts.Removes++;
+        OnRemove(*removed);
+    }
+
+    void Visual::RemoveAll()
+    {
+        auto children = std::move(m_children);
+        m_children.clear();
+        for (auto& child : children)
+        {
+            child->m_parent.reset();
+        }
+        m_counts.Removes++;
+        OnRemoveAll();
+    }
+
+    void Visual::ParentForTransform(VisualPtr const& visual)
+    {
+        m_parentForTransform = visual;
+        m_counts.PropertySets++;
+        OnParentForTransform(visual.get());
+    }
+
+    void Visual::Comment(wchar_t const* comment)
+    {
+        m_counts.PropertySets++;
+        OnComment(comment);
+    }
+
+    void Visual::Animate(AnimatableProperty property, std::initializer_list<KeyFrame> keyFrames, TimeSpan duration, TimeSpan delayTime)
+    {
+        assert(keyFrames.size() > 0);
+        auto value = (keyFrames.end() - 1)->Value;
+        switch (property)
+        {
+        case AnimatableProperty::OffsetX:
+            m_offset.X = value;
+            break;
+        case AnimatableProperty::OffsetZ:
+            m_offset.Z = value;
+            break;
+        case AnimatableProperty::RotationAngleInDegrees:
+            m_rotationAngle = value;
+            break;
+        }
+        m_counts.Animations++;
+        OnAnimate(property, keyFrames, duration, delayTime);
+    }
+
+    VisualPtr Compositor::CreateContainerVisual()
+    {
+        m_counts.Creates++;
+        return OnCreateContainerVisual();
+    }
+
+    VisualPtr Compositor::CreateShapeVisual(ShapeType shapeType)
+    {
+        m_counts.Creates++;
+        return OnCreateShapeVisual(shapeType);
+    }
+
+    VisualPtr Compositor::CreateCardFaceVisual(::Card card)
+    {
+        m_counts.Creates++;
+        return OnCreateCardFaceVisual(card);
+    }
+
+    void Compositor::BeginBatch()
+    {
+        OnBeginBatch();
+    }
+
+    void Compositor::EndBatch(std::function<void()> completed)
+    {
+        OnEndBatch(std::move(completed));
+    }
+}
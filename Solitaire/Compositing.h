@@ -0,0 +1,237 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+#include "Card.h"
+
+// A thin layer over the parts of Windows.UI.Composition the game uses, so the
+// piles, cards and game logic can run against the real compositor or against
+// an in-memory visual tree with nothing rendered.
+//
+// Visual keeps the tree and its properties itself and hands each change on to
+// the backend through the On... hooks. Every create, insert, remove, property
+// set and animation is counted, so the compositor work behind a user action
+// can be measured headless.
+namespace Compositing
+{
+    struct Vector2
+    {
+        float X = 0;
+        float Y = 0;
+    };
+
+    struct Vector3
+    {
+        float X = 0;
+        float Y = 0;
+        float Z = 0;
+    };
+
+    inline bool operator==(Vector3 const& left, Vector3 const& right)
+    {
+        return left.X == right.X && left.Y == right.Y && left.Z == right.Z;
+    }
+
+    inline bool operator!=(Vector3 const& left, Vector3 const& right)
+    {
+        return !(left == right);
+    }
+
+    // Same representation as winrt::Windows::Foundation::TimeSpan.
+    using TimeSpan = std::chrono::duration<int64_t, std::ratio<1, 10000000>>;
+
+    enum class ShapeType
+    {
+        Back,
+        Empty
+    };
+
+    // How a backend that draws puts cards on screen: as vector shapes, or as
+    // sprites sampling a card atlas drawn ahead of time.
+    enum class CardRendering
+    {
+        Shapes,
+        Atlas
+    };
+
+    enum class Property
+    {
+        Offset,
+        Size,
+        RelativeOffsetAdjustment,
+        RelativeSizeAdjustment,
+        AnchorPoint,
+        CenterPoint,
+        RotationAxis,
+        RotationAngleInDegrees,
+        IsBackfaceVisible
+    };
+
+    enum class AnimatableProperty
+    {
+        OffsetX,
+        OffsetZ,
+        RotationAngleInDegrees
+    };
+
+    struct KeyFrame
+    {
+        float Progress;
+        float Value;
+    };
+
+    struct OperationCounts
+    {
+        uint64_t Creates = 0;
+        uint64_t Inserts = 0;
+        uint64_t Removes = 0;
+        uint64_t PropertySets = 0;
+        uint64_t Animations = 0;
+
+        uint64_t Total() const { return Creates + Inserts + Removes + PropertySets + Animations; }
+        OperationCounts operator-(OperationCounts const& other) const
+        {
+            return
+            {
+                Creates - other.Creates,
+                Inserts - other.Inserts,
+                Removes - other.Removes,
+                PropertySets - other.PropertySets,
+                Animations - other.Animations
+            };
+        }
+    };
+
+    // Composition objects the backend holds on to to draw the visuals, other
+    // than the visuals themselves. Ones shared between visuals count once.
+    struct ResourceCounts
+    {
+        uint64_t Geometries = 0;
+        uint64_t Brushes = 0;
+        uint64_t Shapes = 0;
+        uint64_t Surfaces = 0;
+        uint64_t SurfaceBytes = 0;
+
+        uint64_t Total() const { return Geometries + Brushes + Shapes + Surfaces; }
+    };
+
+    class Visual;
+    using VisualPtr = std::shared_ptr<Visual>;
+
+    class Visual : public std::enable_shared_from_this<Visual>
+    {
+    public:
+        Visual(OperationCounts& counts) : m_counts(counts) {}
+        virtual ~Visual() {}
+
+        // Children are kept bottom to top.
+        VisualPtr Parent() const { return m_parent.lock(); }
+        std::vector<VisualPtr> const& Children() const { return m_children; }
+        void InsertAtTop(VisualPtr const& child);
+        void InsertAbove(VisualPtr const& child, VisualPtr const& sibling);
+        void Remove(VisualPtr const& child);
+        void RemoveAll();
+
+        Vector3 Offset() const { return m_offset; }
+        void Offset(Vector3 offset) { Set(m_offset, offset, Property::Offset); }
+        Vector2 Size() const { return m_size; }
+        void Size(Vector2 size) { Set(m_size, size, Property::Size); }
+        Vector3 RelativeOffsetAdjustment() const { return m_relativeOffset; }
+        void RelativeOffsetAdjustment(Vector3 adjustment) { Set(m_relativeOffset, adjustment, Property::RelativeOffsetAdjustment); }
+        Vector2 RelativeSizeAdjustment() const { return m_relativeSize; }
+        void RelativeSizeAdjustment(Vector2 adjustment) { Set(m_relativeSize, adjustment, Property::RelativeSizeAdjustment); }
+        Vector2 AnchorPoint() const { return m_anchorPoint; }
+        void AnchorPoint(Vector2 anchorPoint) { Set(m_anchorPoint, anchorPoint, Property::AnchorPoint); }
+        Vector3 CenterPoint() const { return m_centerPoint; }
+        void CenterPoint(Vector3 centerPoint) { Set(m_centerPoint, centerPoint, Property::CenterPoint); }
+        Vector3 RotationAxis() const { return m_rotationAxis; }
+        void RotationAxis(Vector3 axis) { Set(m_rotationAxis, axis, Property::RotationAxis); }
+        float RotationAngleInDegrees() const { return m_rotationAngle; }
+        void RotationAngleInDegrees(float angle) { Set(m_rotationAngle, angle, Property::RotationAngleInDegrees); }
+        bool IsBackfaceVisible() const { return m_isBackfaceVisible; }
+        void IsBackfaceVisible(bool isVisible) { Set(m_isBackfaceVisible, isVisible, Property::IsBackfaceVisible); }
+
+        VisualPtr ParentForTransform() const { return m_parentForTransform.lock(); }
+        void ParentForTransform(VisualPtr const& visual);
+        void Comment(wchar_t const* comment);
+
+        // Key frames run from progress 0 to 1. Once started the property
+        // reads as the last key frame's value.
+        void Animate(AnimatableProperty property, std::initializer_list<KeyFrame> keyFrames, TimeSpan duration, TimeSpan delayTime);
+
+    protected:
+        virtual void OnInsertAtTop(Visual&) {}
+        virtual void OnInsertAbove(Visual&, Visual&) {}
+        virtual void OnRemove(Visual&) {}
+        virtual void OnRemoveAll() {}
+        virtual void OnPropertyChanged(Property) {}
+        virtual void OnParentForTransform(Visual*) {}
+        virtual void OnComment(wchar_t const*) {}
+        virtual void OnAnimate(AnimatableProperty, std::initializer_list<KeyFrame>, TimeSpan, TimeSpan) {}
+
+    private:
+        template <typename T>
+        void Set(T& field, T value, Property property)
+        {
+            field = value;
+            m_counts.PropertySets++;
+            OnPropertyChanged(property);
+        }
+
+    private:
+        OperationCounts& m_counts;
+        std::weak_ptr<Visual> m_parent;
+        std::weak_ptr<Visual> m_parentForTransform;
+        std::vector<VisualPtr> m_children;
+        Vector3 m_offset;
+        Vector2 m_size;
+        Vector3 m_relativeOffset;
+        Vector2 m_relativeSize;
+        Vector2 m_anchorPoint;
+        Vector3 m_centerPoint;
+        Vector3 m_rotationAxis{ 0, 0, 1 };
+        float m_rotationAngle = 0;
+        bool m_isBackfaceVisible = true;
+    };
+
+    class Compositor
+    {
+    public:
+        virtual ~Compositor() {}
+
+        VisualPtr CreateContainerVisual();
+        // Hosts one of the shared shapes, sized by the caller.
+        VisualPtr CreateShapeVisual(ShapeType shapeType);
+        // The face of a card, its outline with the rank and suit in the corner.
+        VisualPtr CreateCardFaceVisual(::Card card);
+
+        // Animations started between BeginBatch and EndBatch call completed
+        // once all of them have finished.
+        void BeginBatch();
+        void EndBatch(std::function<void()> completed);
+
+        // Height of the rank and suit text on a card face.
+        virtual float TextHeight() = 0;
+
+        OperationCounts const& Counts() const { return m_counts; }
+        // Nothing for a compositor that doesn't draw.
+        virtual ResourceCounts Resources() const { return {}; }
+        // The scale the visuals end up shown at, in pixels per unit, for a
+        // backend that draws ahead of time.
+        virtual void RasterizationScale(float) {}
+
+    protected:
+        virtual VisualPtr OnCreateContainerVisual() = 0;
+        virtual VisualPtr OnCreateShapeVisual(ShapeType shapeType) = 0;
+        virtual VisualPtr OnCreateCardFaceVisual(::Card card) = 0;
+        virtual void OnBeginBatch() = 0;
+        virtual void OnEndBatch(std::function<void()> completed) = 0;
+
+    protected:
+        // Visuals count into this, so the compositor has to outlive them.
+        OperationCounts m_counts;
+    };
+}
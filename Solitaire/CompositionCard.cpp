@@ -1,104 +1,91 @@
-#include "pch.h"
 #include "Card.h"
-#include "ShapeCache.h"
+#include "PileLayout.h"
 #include "CompositionCard.h"
 
-namespace winrt
-{
-    using namespace Windows;
-    using namespace Windows::ApplicationModel::Core;
-    using namespace Windows::Foundation;
-    using namespace Windows::Foundation::Numerics;
-    using namespace Windows::UI;
-    using namespace Windows::UI::Core;
-    using namespace Windows::UI::Composition;
-}
-
-const winrt::float2 CompositionCard::CardSize = { 175, 250 };
+const Compositing::Vector2 CompositionCard::CardSize = { Layout::CardWidth, Layout::CardHeight };
 
-winrt::ShapeVisual BuildCardFront(
-    std::shared_ptr<ShapeCache> const& shapeCache,
-    winrt::hstring const& card,
-    winrt::Color const& color)
+Compositing::VisualPtr BuildCardFront(
+    std::shared_ptr<Compositing::Compositor> const& compositor,
+    Card card)
 {
-    auto compositor = shapeCache->Compositor();
-    auto shapeVisual = compositor.CreateShapeVisual();
-    auto shapeContainer = compositor.CreateContainerShape();
-    shapeVisual.Shapes().Append(shapeContainer);
-    shapeVisual.Size(CompositionCard::CardSize);
-    shapeVisual.BackfaceVisibility(winrt::CompositionBackfaceVisibility::Hidden);
-
-    auto roundedRectGeometry = compositor.CreateRoundedRectangleGeometry();
-    roundedRectGeometry.CornerRadius({ 10, 10 });
-    roundedRectGeometry.Size(CompositionCard::CardSize);
-    auto rectShape = compositor.CreateSpriteShape(roundedRectGeometry);
-    rectShape.StrokeBrush(compositor.CreateColorBrush(winrt::Colors::Gray()));
-    rectShape.FillBrush(compositor.CreateColorBrush(winrt::Colors::White()));
-    rectShape.StrokeThickness(2);
-    shapeContainer.Shapes().Append(rectShape);
-
-    auto pathGeometry = shapeCache->GetPathGeometry(card);
-    auto pathShape = compositor.CreateSpriteShape(pathGeometry);
-    pathShape.Offset({ 5, 0 });
-    pathShape.FillBrush(compositor.CreateColorBrush(color));
-    shapeContainer.Shapes().Append(pathShape);
-
-    shapeVisual.Comment(card);
+    auto shapeVisual = compositor->CreateCardFaceVisual(card);
+    shapeVisual->Size(CompositionCard::CardSize);
+    shapeVisual->IsBackfaceVisible(false);
+
+    shapeVisual->Comment(card.ToString().c_str());
 
     return shapeVisual;
 }
 
-winrt::ShapeVisual BuildCardBack(std::shared_ptr<ShapeCache> const& shapeCache)
+Compositing::VisualPtr BuildCardBack(std::shared_ptr<Compositing::Compositor> const& compositor)
 {
-    auto compositor = shapeCache->Compositor();
-    auto shapeVisual = compositor.CreateShapeVisual();
-    shapeVisual.Shapes().Append(shapeCache->GetShape(ShapeType::Back));
-    shapeVisual.Size(CompositionCard::CardSize);
-    shapeVisual.BackfaceVisibility(winrt::CompositionBackfaceVisibility::Hidden);
-    shapeVisual.RotationAxis({ 0, 1, 0 });
-    shapeVisual.RotationAngleInDegrees(180);
-    shapeVisual.CenterPoint({ CompositionCard::CardSize.x / 2.0f, CompositionCard::CardSize.y / 2.0f, 0 });
+    auto shapeVisual = compositor->CreateShapeVisual(Compositing::ShapeType::Back);
+    shapeVisual->Size(CompositionCard::CardSize);
+    shapeVisual->IsBackfaceVisible(false);
+    shapeVisual->RotationAxis({ 0, 1, 0 });
+    shapeVisual->RotationAngleInDegrees(180);
+    shapeVisual->CenterPoint({ CompositionCard::CardSize.X / 2.0f, CompositionCard::CardSize.Y / 2.0f, 0 });
 
-    shapeVisual.Comment(L"Card Back");
+    shapeVisual->Comment(L"Card Back");
 
     return shapeVisual;
 }
 
 CompositionCard::CompositionCard(
     Card card,
-    std::shared_ptr<ShapeCache> const& shapeCache)
+    std::shared_ptr<Compositing::Compositor> const& compositor)
 {
-    auto compositor = shapeCache->Compositor();
-
     m_card = card;
-    m_root = compositor.CreateContainerVisual();
-    m_root.Size(CardSize);
-    m_root.Comment(L"Card Root");
-
-    m_sidesRoot = compositor.CreateContainerVisual();
-    m_sidesRoot.RelativeSizeAdjustment({ 1, 1 });
-    m_sidesRoot.RotationAxis({ 0, 1, 0 });
-    m_sidesRoot.CenterPoint({ CardSize.x / 2.0f, CardSize.y / 2.0f, 0 });
-    m_sidesRoot.Comment(L"Card Sides");
-    m_root.Children().InsertAtTop(m_sidesRoot);
-    m_front = BuildCardFront(
-        shapeCache,
-        card.ToString(),
-        card.IsRed() ? winrt::Colors::Crimson() : winrt::Colors::Black());
-    m_sidesRoot.Children().InsertAtTop(m_front);
-    m_back = BuildCardBack(shapeCache);
-    m_sidesRoot.Children().InsertAtTop(m_back);
+    m_compositor = compositor;
 }
 
-bool CompositionCard::HitTest(winrt::float2 point)
+Compositing::VisualPtr const& CompositionCard::Root()
 {
-    winrt::float3 const offset = m_root.Offset();
-    winrt::float2 const size = m_root.Size();
+    if (!m_root)
+    {
+        m_root = m_compositor->CreateContainerVisual();
+        m_root->Size(CardSize);
+        m_root->Comment(L"Card Root");
+
+        m_sidesRoot = m_compositor->CreateContainerVisual();
+        m_sidesRoot->RelativeSizeAdjustment({ 1, 1 });
+        m_sidesRoot->RotationAxis({ 0, 1, 0 });
+        m_sidesRoot->CenterPoint({ CardSize.X / 2.0f, CardSize.Y / 2.0f, 0 });
+        m_sidesRoot->Comment(L"Card Sides");
+        m_root->InsertAtTop(m_sidesRoot);
+        m_back = BuildCardBack(m_compositor);
+        m_sidesRoot->InsertAtTop(m_back);
+        if (m_isFaceUp)
+        {
+            EnsureFront();
+        }
+        else
+        {
+            m_sidesRoot->RotationAngleInDegrees(180);
+        }
+    }
+    return m_root;
+}
 
-    if (point.x >= offset.x &&
-        point.x < offset.x + size.x &&
-        point.y >= offset.y &&
-        point.y < offset.y + size.y)
+// Both sides hide their backface, so the front can go above the back.
+void CompositionCard::EnsureFront()
+{
+    if (!m_front)
+    {
+        m_front = BuildCardFront(m_compositor, m_card);
+        m_sidesRoot->InsertAtTop(m_front);
+    }
+}
+
+bool CompositionCard::HitTest(Compositing::Vector2 point)
+{
+    auto const offset = Root()->Offset();
+    auto const size = m_root->Size();
+
+    if (point.X >= offset.X &&
+        point.X < offset.X + size.X &&
+        point.Y >= offset.Y &&
+        point.Y < offset.Y + size.Y)
     {
         return true;
     }
@@ -111,26 +98,30 @@ void CompositionCard::IsFaceUp(bool isFaceUp)
     if (m_isFaceUp != isFaceUp)
     {
         m_isFaceUp = isFaceUp;
+        if (!m_root)
+        {
+            return;
+        }
+        if (m_isFaceUp)
+        {
+            EnsureFront();
+        }
         auto rotation = m_isFaceUp ? 0 : 180;
-        m_sidesRoot.RotationAngleInDegrees(rotation);
+        m_sidesRoot->RotationAngleInDegrees(rotation);
     }
 }
 
-void CompositionCard::AnimateIsFaceUp(bool isFaceUp, winrt::TimeSpan const& duration, winrt::TimeSpan const& delayTime)
+void CompositionCard::AnimateIsFaceUp(bool isFaceUp, Compositing::TimeSpan const& duration, Compositing::TimeSpan const& delayTime)
 {
     if (m_isFaceUp != isFaceUp)
     {
+        Root();
         m_isFaceUp = isFaceUp;
-        auto rotation = m_sidesRoot.RotationAngleInDegrees() + 180;
-
-        auto compositor = m_sidesRoot.Compositor();
-        auto animation = compositor.CreateScalarKeyFrameAnimation();
-        animation.InsertKeyFrame(1, rotation);
-        animation.IterationBehavior(winrt::AnimationIterationBehavior::Count);
-        animation.IterationCount(1);
-        animation.Duration(duration);
-        animation.DelayTime(delayTime);
-
-        m_sidesRoot.StartAnimation(L"RotationAngleInDegrees", animation);
+        if (m_isFaceUp)
+        {
+            EnsureFront();
+        }
+        auto rotation = m_sidesRoot->RotationAngleInDegrees() + 180;
+        m_sidesRoot->Animate(Compositing::AnimatableProperty::RotationAngleInDegrees, { { 1, rotation } }, duration, delayTime);
     }
 }
\ No newline at end of file
@@ -1,32 +1,41 @@
 #pragma once
-
-class ShapeCache;
+#include <memory>
+#include "Card.h"
+#include "Compositing.h"
 
 class CompositionCard
 {
 public:
-    static const winrt::Windows::Foundation::Numerics::float2 CardSize;
+    static const Compositing::Vector2 CardSize;
 
     CompositionCard(
         Card card,
-        std::shared_ptr<ShapeCache> const& shapeCache);
+        std::shared_ptr<Compositing::Compositor> const& compositor);
     ~CompositionCard() {}
 
     Card Value() { return m_card; }
-    winrt::Windows::UI::Composition::Visual Root() { return m_root; }
+    // Cards start face down with no visuals. The root, sides and back are
+    // built the first time the root is asked for, and the front right
+    // before the card is first turned face up.
+    Compositing::VisualPtr const& Root();
+    bool IsRealized() const { return m_root != nullptr; }
     bool IsFaceUp() { return m_isFaceUp; }
 
-    bool HitTest(winrt::Windows::Foundation::Numerics::float2 point);
+    bool HitTest(Compositing::Vector2 point);
     void IsFaceUp(bool isFaceUp);
     void Flip() { IsFaceUp(!m_isFaceUp); }
 
-    void AnimateIsFaceUp(bool isFaceUp, winrt::Windows::Foundation::TimeSpan const& duration, winrt::Windows::Foundation::TimeSpan const& delayTime);
+    void AnimateIsFaceUp(bool isFaceUp, Compositing::TimeSpan const& duration, Compositing::TimeSpan const& delayTime);
+
+private:
+    void EnsureFront();
 
 private:
-    winrt::Windows::UI::Composition::ContainerVisual m_root{ nullptr };
-    winrt::Windows::UI::Composition::ContainerVisual m_sidesRoot{ nullptr };
-    winrt::Windows::UI::Composition::ShapeVisual m_front{ nullptr };
-    winrt::Windows::UI::Composition::ShapeVisual m_back{ nullptr };
+    std::shared_ptr<Compositing::Compositor> m_compositor;
+    Compositing::VisualPtr m_root;
+    Compositing::VisualPtr m_sidesRoot;
+    Compositing::VisualPtr m_front;
+    Compositing::VisualPtr m_back;
     Card m_card;
-    bool m_isFaceUp = true;
+    bool m_isFaceUp = false;
 };
\ No newline at end of file
@@ -0,0 +1,157 @@
+#include <algorithm>
+#include <random>
+#include "Deal.h"
+
+namespace Klondike
+{
+    static uint64_t SplitMix64(uint64_t& state)
+    {
+        auto z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    static uint64_t RotateLeft(uint64_t value, int bits)
+    {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    // xoshiro256** by Blackman and Vigna.
+    class Xoshiro256
+    {
+    public:
+        // Num1 and Num2 form the low word that seeds the first two state
+        // words, Num3 and Num4 the high word that seeds the other two.
+        Xoshiro256(ShuffleSeed seed)
+        {
+            auto low = ((uint64_t)seed.Num2 << 32) | seed.Num1;
+            auto high = ((uint64_t)seed.Num4 << 32) | seed.Num3;
+            m_state[0] = SplitMix64(low);
+            m_state[1] = SplitMix64(low);
+            m_state[2] = SplitMix64(high);
+            m_state[3] = SplitMix64(high);
+        }
+
+        uint64_t Next()
+        {
+            auto result = RotateLeft(m_state[1] * 5, 7) * 9;
+            auto t = m_state[1] << 17;
+            m_state[2] ^= m_state[0];
+            m_state[3] ^= m_state[1];
+            m_state[1] ^= m_state[2];
+            m_state[0] ^= m_state[3];
+            m_state[2] ^= t;
+            m_state[3] = RotateLeft(m_state[3], 45);
+            return result;
+        }
+
+        // Uniform in [0, bound) from the top 32 bits of each output, using
+        // Lemire's multiply and reject.
+        uint32_t Below(uint32_t bound)
+        {
+            auto product = (Next() >> 32) * bound;
+            auto low = (uint32_t)product;
+            if (low < bound)
+            {
+                auto threshold = (0u - bound) % bound;
+                while (low < threshold)
+                {
+                    product = (Next() >> 32) * bound;
+                    low = (uint32_t)product;
+                }
+            }
+            return (uint32_t)(product >> 32);
+        }
+
+    private:
+        uint64_t m_state[4];
+    };
+
+    static void ShuffleLegacy(ShuffleSeed seed, CardOrder& cards)
+    {
+        for (auto i = 0; i < (int)cards.size(); i++)
+        {
+            cards[i] = Card::FromIndex(i);
+        }
+
+        std::seed_seq rngSeed{ seed.Num1, seed.Num2, seed.Num3, seed.Num4 };
+        std::mt19937 g(rngSeed);
+        std::shuffle(cards.begin(), cards.end(), g);
+    }
+
+    // Inside-out Fisher-Yates: card i goes to a random slot j in [0, i] and
+    // whatever was there moves up to slot i. Starting from pack order this
+    // never needs the unshuffled pack written out first.
+    static void ShufflePortable(ShuffleSeed seed, CardOrder& cards)
+    {
+        Xoshiro256 random(seed);
+        cards[0] = Card::FromIndex(0);
+        for (auto i = 1u; i < cards.size(); i++)
+        {
+            auto j = random.Below(i + 1);
+            cards[i] = cards[j];
+            cards[j] = Card::FromIndex((int)i);
+        }
+    }
+
+    static void Shuffle(ShuffleSeed seed, CardOrder& cards)
+    {
+        if (seed.Version == ShuffleVersion::Legacy)
+        {
+            ShuffleLegacy(seed, cards);
+        }
+        else
+        {
+            ShufflePortable(seed, cards);
+        }
+    }
+
+    CardOrder ShuffleCards(ShuffleSeed seed)
+    {
+        CardOrder cards;
+        Shuffle(seed, cards);
+        return cards;
+    }
+
+    void ShuffleCards(ShuffleSeed const* seeds, size_t count, CardOrder* cards)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            Shuffle(seeds[i], cards[i]);
+        }
+    }
+
+    void ShuffleCards(ShuffleSeed first, size_t count, CardOrder* cards)
+    {
+        auto seed = first;
+        for (size_t i = 0; i < count; i++)
+        {
+            seed.Num1 = first.Num1 + (unsigned int)i;
+            Shuffle(seed, cards[i]);
+        }
+    }
+
+    State Deal(CardOrder const& cards)
+    {
+        State state;
+        auto cardsSoFar = 0;
+        for (auto i = 0; i < ColumnCount; i++)
+        {
+            auto numberOfCards = i + 1;
+            state.SetColumn(i, cards.data() + cardsSoFar, numberOfCards, numberOfCards - 1);
+            cardsSoFar += numberOfCards;
+        }
+
+        // The deck draws from the back, so the stock starts with the last card.
+        Card stock[TalonCapacity];
+        std::reverse_copy(cards.begin() + cardsSoFar, cards.end(), stock);
+        state.SetTalon(stock, (int)cards.size() - cardsSoFar);
+        return state;
+    }
+
+    State Deal(ShuffleSeed seed)
+    {
+        return Deal(ShuffleCards(seed));
+    }
+}
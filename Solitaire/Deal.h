@@ -0,0 +1,47 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "Card.h"
+#include "Klondike.h"
+
+namespace Klondike
+{
+    // How a seed turns into a card order. Seeds always carry the version they
+    // were made with so old games keep dealing the same way.
+    enum class ShuffleVersion : uint8_t
+    {
+        // std::seed_seq, std::mt19937 and std::shuffle. std::shuffle isn't
+        // specified exactly, so this deals differently with each standard
+        // library.
+        Legacy = 0,
+        // xoshiro256** seeded through splitmix64, driving an inside-out
+        // Fisher-Yates shuffle. Fully specified, see ShuffleCards in Deal.cpp.
+        Portable = 1,
+    };
+
+    constexpr ShuffleVersion CurrentShuffleVersion = ShuffleVersion::Portable;
+
+    struct ShuffleSeed
+    {
+        unsigned int Num1 = 0;
+        unsigned int Num2 = 0;
+        unsigned int Num3 = 0;
+        unsigned int Num4 = 0;
+        ShuffleVersion Version = CurrentShuffleVersion;
+    };
+
+    using CardOrder = std::array<Card, 52>;
+
+    // The order Pack::Shuffle leaves its cards in for the given seed.
+    CardOrder ShuffleCards(ShuffleSeed seed);
+    // Shuffles count packs into one flat buffer, cards[i] for seeds[i].
+    void ShuffleCards(ShuffleSeed const* seeds, size_t count, CardOrder* cards);
+    // Same again for the seeds { first.Num1 + i, first.Num2, first.Num3, first.Num4 }.
+    void ShuffleCards(ShuffleSeed first, size_t count, CardOrder* cards);
+
+    // Lays the cards out the way Game::DealCards does: the columns take the
+    // first 28 cards, the rest go to the stock with the last card on top.
+    State Deal(CardOrder const& cards);
+    State Deal(ShuffleSeed seed);
+}
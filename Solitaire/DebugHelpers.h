@@ -87,4 +87,28 @@ namespace Debug
             }
         }
     }
+
+    struct TreeSize
+    {
+        int Visuals = 0;
+        int Depth = 0;
+    };
+
+    // Counts the visuals under root, and how many levels deep the deepest is.
+    inline void MeasureTree(winrt::Windows::UI::Composition::Visual const& root, int level, TreeSize& size)
+    {
+        size.Visuals++;
+        if (level + 1 > size.Depth)
+        {
+            size.Depth = level + 1;
+        }
+        auto containerVisual = root.try_as<winrt::Windows::UI::Composition::ContainerVisual>();
+        if (containerVisual)
+        {
+            for (auto& child : containerVisual.Children())
+            {
+                MeasureTree(child, level + 1, size);
+            }
+        }
+    }
 }
@@ -1,62 +1,57 @@
-#include "pch.h"
 #include "Card.h"
+#include "Klondike.h"
 #include "CompositionCard.h"
-#include "ShapeCache.h"
 #include "Deck.h"
 
-using namespace winrt;
-using namespace Windows::Foundation::Numerics;
-using namespace Windows::UI::Composition;
-
-Deck::Deck(std::shared_ptr<ShapeCache> const& shapeCache, std::vector<std::shared_ptr<CompositionCard>> cards)
+Deck::Deck(std::shared_ptr<Compositing::Compositor> const& compositor, std::shared_ptr<CardTable> const& cardTable, CardSpan cards)
 {
-    m_cards = cards;
+    m_cardTable = cardTable;
+    m_cards = CardHandleList(cards);
+
+    m_background = compositor->CreateShapeVisual(Compositing::ShapeType::Empty);
+    m_background->Size(CompositionCard::CardSize);
+    m_background->Comment(L"Deck Root");
 
-    auto compositor = shapeCache->Compositor();
-    m_background = compositor.CreateShapeVisual();
-    m_background.Shapes().Append(shapeCache->GetShape(ShapeType::Empty));
-    m_background.Size(CompositionCard::CardSize);
-    m_background.Comment(L"Deck Root");
+    // Every stock card is face down at the same spot, so a single card back
+    // stands in for all of them and the cards stay out of the tree.
+    m_proxy = compositor->CreateShapeVisual(Compositing::ShapeType::Back);
+    m_proxy->Size(CompositionCard::CardSize);
+    m_proxy->Comment(L"Stock Proxy");
 }
 
-bool Deck::HitTest(float2 point)
+bool Deck::HitTest(Compositing::Vector2 point)
 {
-    float3 const offset = m_background.Offset();
-    float2 const size = m_background.Size();
-    if (point.x >= offset.x &&
-        point.x < offset.x + size.x &&
-        point.y >= offset.y &&
-        point.y < offset.y + size.y)
+    auto const offset = m_background->Offset();
+    auto const size = m_background->Size();
+    if (point.X >= offset.X &&
+        point.X < offset.X + size.X &&
+        point.Y >= offset.Y &&
+        point.Y < offset.Y + size.Y)
     {
         return true;
     }
     return false;
 }
 
-std::vector<std::shared_ptr<CompositionCard>> Deck::Draw()
+CardHandleList Deck::Draw(int count)
 {
-    // Take the top 3 cards
-    auto availableCards = 3;
-    if (m_cards.size() < 3)
+    // Take the top cards, the top one first
+    auto availableCards = count;
+    if ((int)m_cards.size() < count)
     {
-        availableCards = m_cards.size();
+        availableCards = (int)m_cards.size();
     }
 
     if (availableCards > 0)
     {
         auto start = m_cards.begin() + (m_cards.size() - availableCards);
-        auto end = m_cards.end();
-        std::vector<std::shared_ptr<CompositionCard>> tempCards(
-            std::make_move_iterator(start),
-            std::make_move_iterator(end));
-        m_cards.erase(start, end);
-
-        std::vector<std::shared_ptr<CompositionCard>> cards(tempCards.rbegin(), tempCards.rend());
-        for (auto& card : cards)
+        CardHandleList cards;
+        for (auto card = m_cards.end(); card != start; )
         {
-            m_background.Children().Remove(card->Root());
-            //card->IsFaceUp(true);
+            cards.push_back(*--card);
         }
+        m_cards.erase(start, m_cards.end());
+        UpdateProxy();
 
         return cards;
     }
@@ -64,34 +59,64 @@ std::vector<std::shared_ptr<CompositionCard>> Deck::Draw()
     return {};
 }
 
-void Deck::AddCards(std::vector<std::shared_ptr<CompositionCard>> const& cards)
+void Deck::AddCards(CardSpan cards)
 {
-    for (auto& card : cards)
+    for (auto card : cards)
     {
-        auto visual = card->Root();
-        visual.Offset({ 0, 0, 0 });
-        //visual.Parent().Children().Remove(visual);
-        m_background.Children().InsertAtTop(visual);
-        card->IsFaceUp(false);
-
+        Stow(card);
         m_cards.push_back(card);
     }
+    UpdateProxy();
+}
+
+void Deck::Clear()
+{
+    m_cards.clear();
+    UpdateProxy();
 }
 
-void Deck::ForceLayout()
+void Deck::UpdateLayout()
 {
-    m_background.Children().RemoveAll();
-    for (auto& card : m_cards)
+    m_layoutCounts.Passes++;
+    for (auto card : m_cards)
     {
-        auto visual = card->Root();
-        visual.Offset({ 0, 0, 0 });
+        m_layoutCounts.ContainersChecked++;
+        Stow(card);
+    }
+    UpdateProxy();
+}
 
-        if (visual.Parent())
-        {
-            visual.Parent().Children().Remove(visual);
-        }
+// Cards that were never shown have nothing to put away.
+void Deck::Stow(CardHandle handle)
+{
+    auto& card = (*m_cardTable)[handle];
+    card.IsFaceUp(false);
+    if (!card.IsRealized())
+    {
+        return;
+    }
+
+    auto& visual = card.Root();
+    if (auto parent = visual->Parent())
+    {
+        parent->Remove(visual);
+    }
+    if (visual->Offset() != Compositing::Vector3{ 0, 0, 0 })
+    {
+        visual->Offset({ 0, 0, 0 });
+        m_layoutCounts.OffsetsChanged++;
+    }
+}
 
-        card->IsFaceUp(false);
-        m_background.Children().InsertAtTop(visual);
+void Deck::UpdateProxy()
+{
+    auto isShown = m_proxy->Parent() != nullptr;
+    if (isShown && m_cards.empty())
+    {
+        m_background->Remove(m_proxy);
+    }
+    else if (!isShown && !m_cards.empty())
+    {
+        m_background->InsertAtTop(m_proxy);
     }
 }
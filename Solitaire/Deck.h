@@ -1,24 +1,39 @@
 #pragma once
-
-class ShapeCache;
-class CompositionCard;
+#include <memory>
+#include <vector>
+#include "Klondike.h"
+#include "CardTable.h"
+#include "Compositing.h"
+#include "PileLayout.h"
 
 class Deck
 {
 public:
-    Deck(std::shared_ptr<ShapeCache> const& shapeCache, std::vector<std::shared_ptr<CompositionCard>> cards);
+    Deck(std::shared_ptr<Compositing::Compositor> const& compositor, std::shared_ptr<CardTable> const& cardTable, CardSpan cards = {});
     ~Deck() {}
 
-    winrt::Windows::UI::Composition::Visual Base() { return m_background; }
-    const std::vector<std::shared_ptr<CompositionCard>>& Cards() const { return m_cards; }
+    Compositing::VisualPtr const& Base() { return m_background; }
+    CardSpan Cards() const { return m_cards; }
+
+    bool HitTest(Compositing::Vector2 point);
+    CardHandleList Draw() { return Draw(Klondike::CardsPerDraw); }
+    CardHandleList Draw(int count);
+    void AddCards(CardSpan cards);
+    void Clear();
+    // Turns the cards face down and takes them out of the tree, the stock
+    // is drawn by one card back for as long as it isn't empty.
+    void UpdateLayout();
+    Layout::LayoutCounts const& LayoutCounts() const { return m_layoutCounts; }
 
-    bool HitTest(winrt::Windows::Foundation::Numerics::float2 point);
-    std::vector<std::shared_ptr<CompositionCard>> Draw();
-    void AddCards(std::vector<std::shared_ptr<CompositionCard>> const& cards);
-    void ForceLayout();
+private:
+    void Stow(CardHandle handle);
+    void UpdateProxy();
 
 private:
-    winrt::Windows::UI::Composition::ShapeVisual m_background{ nullptr };
-    std::vector<std::shared_ptr<CompositionCard>> m_cards;
+    Compositing::VisualPtr m_background;
+    Compositing::VisualPtr m_proxy;
+    std::shared_ptr<CardTable> m_cardTable;
+    CardHandleList m_cards;
     float m_fanRatio = 0;
+    Layout::LayoutCounts m_layoutCounts;
 };
\ No newline at end of file
@@ -1,19 +1,10 @@
-#include"pch.h"
 #include "Card.h"
-#include "CompositionCard.h"
-#include "ShapeCache.h"
+#include "Klondike.h"
 #include "Foundation.h"
 
-namespace winrt
-{
-    using namespace Windows::Foundation;
-    using namespace Windows::Foundation::Numerics;
-    using namespace Windows::UI::Composition;
-}
-
 bool Foundation::CanSplit(int index)
 {
-    return !m_cards.empty() && index == m_cards.size() - 1;
+    return Klondike::CanPickUpFromFoundation(index, m_cards.size());
 }
 
 bool Foundation::CanTake(int index)
@@ -21,7 +12,7 @@ bool Foundation::CanTake(int index)
     return false;
 }
 
-bool Foundation::CanAdd(Pile::CardList const& cards)
+bool Foundation::CanAdd(CardSpan cards)
 {
     if (cards.size() != 1)
     {
@@ -33,29 +24,22 @@ bool Foundation::CanAdd(Pile::CardList const& cards)
         return false;
     }
 
-    auto card = cards.front();
-    auto cardValue = card->Value();
+    auto cardValue = CardOf(cards.front());
     if (m_cards.empty())
     {
-        return cardValue.Face() == Face::Ace;
+        return Klondike::CanStartFoundation(cardValue);
     }
 
     auto lastCard = m_cards.back();
-    auto lastCardValue = lastCard->Value();
-    if (cardValue.Suit() != lastCardValue.Suit())
-    {
-        return false;
-    }
-
-    return (int)cardValue.Face() == (int)lastCardValue.Face() + 1;
+    return Klondike::CanFoundOn(cardValue, CardOf(lastCard));
 }
 
-winrt::float3 Foundation::ComputeOffset(int index, int totalCards)
+Compositing::Vector3 Foundation::ComputeOffset(int index, int totalCards)
 {
     return { 0, 0, 0 };
 }
 
-winrt::float3 Foundation::ComputeBaseSpaceOffset(int index, int totalCards)
+Compositing::Vector3 Foundation::ComputeBaseSpaceOffset(int index, int totalCards)
 {
     return { 0, 0, 0 };
 }
@@ -1,20 +1,17 @@
 #pragma once
 #include "Pile.h"
 
-class ShapeCache;
-class CompositionCard;
-
 class Foundation : public Pile
 {
 public:
-    Foundation(std::shared_ptr<ShapeCache> const& shapeCache) : Pile(shapeCache) { m_background.Comment(L"Foundation Area Root"); }
+    Foundation(std::shared_ptr<Compositing::Compositor> const& compositor, std::shared_ptr<ItemContainerPool> const& itemContainerPool, std::shared_ptr<CardTable> const& cardTable) : Pile(compositor, itemContainerPool, cardTable) { m_background->Comment(L"Foundation Area Root"); }
 
     virtual bool CanSplit(int index) override;
     virtual bool CanTake(int index) override;
-    virtual bool CanAdd(Pile::CardList const& cards) override;
+    virtual bool CanAdd(CardSpan cards) override;
 
 protected:
-    virtual winrt::Windows::Foundation::Numerics::float3 ComputeOffset(int index, int totalCards) override;
-    virtual winrt::Windows::Foundation::Numerics::float3 ComputeBaseSpaceOffset(int index, int totalCards) override;
+    virtual Compositing::Vector3 ComputeOffset(int index, int totalCards) override;
+    virtual Compositing::Vector3 ComputeBaseSpaceOffset(int index, int totalCards) override;
     virtual void OnRemovalCompleted(Pile::RemovalOperation operation) override;
 };
\ No newline at end of file
@@ -6,7 +6,9 @@
 #include "Foundation.h"
 #include "Deck.h"
 #include "Pack.h"
-#include "ShapeCache.h"
+#include "ParallelSolver.h"
+#include "Replay.h"
+#include "WinRTCompositor.h"
 #include "Game.h"
 
 namespace winrt
@@ -18,127 +20,108 @@ namespace winrt
     using namespace Windows::UI::Popups;
 }
 
-template <typename PileType>
-std::pair<Pile::HitTestResult, std::shared_ptr<PileType>> HitTestPiles(
-    winrt::float2 const point,
-    std::map<HitTestZone, winrt::Rect>& zoneRects,
-    std::vector<std::shared_ptr<PileType>> const& piles,
-    HitTestZone zoneType,
-    std::initializer_list<Pile::HitTestTarget> const& desiredTargets)
+Game::Game(winrt::Compositor const& compositor, winrt::float2 const hostSize, Compositing::CardRendering cardRendering)
 {
-    // The point is in window space
-    // Convert from window space to container space (Play Area, Foundation, etc)
-    auto containerPoint = point;
-    auto containerHitTestRect = zoneRects[zoneType];
-    containerPoint.x -= containerHitTestRect.X;
-    containerPoint.y -= containerHitTestRect.Y;
-    for (auto& pile : piles)
-    {
-        // The point is in container space
-        // Convert from container space to local space for the pile
-        auto localPoint = containerPoint;
-        localPoint.x -= pile->Base().Offset().x;
-        localPoint.y -= pile->Base().Offset().y;
-        auto result = pile->HitTest(localPoint);
-        for (auto& target : desiredTargets)
-        {
-            if (result.Target == target)
-            {
-                return { result, pile };
-            }
-        }
-    }
-
-    return { Pile::HitTestResult(), nullptr };
-}
-
-Game::Game(winrt::Compositor const& compositor, winrt::float2 const hostSize)
-{
-    m_compositor = compositor;
+    m_compositor = std::make_shared<Compositing::WinRTCompositor>(compositor, cardRendering);
+    m_itemContainerPool = std::make_shared<ItemContainerPool>(m_compositor);
     // Base visual tree
-    m_shapeCache = std::make_shared<ShapeCache>(m_compositor);
-    m_root = m_compositor.CreateContainerVisual();
-    m_root.RelativeSizeAdjustment({ 1, 1 });
-    m_root.Comment(L"Game Root");
-
-    m_boardLayer = m_compositor.CreateContainerVisual();
-    m_boardLayer.RelativeSizeAdjustment({ 1, 1 });
-    m_boardLayer.Comment(L"Board Layer");
-    m_root.Children().InsertAtTop(m_boardLayer);
+    m_root = m_compositor->CreateContainerVisual();
+    m_root->RelativeSizeAdjustment({ 1, 1 });
+    m_root->Comment(L"Game Root");
 
-    m_selectedLayer = m_compositor.CreateContainerVisual();
-    m_selectedLayer.RelativeSizeAdjustment({ 1, 1 });
-    m_selectedLayer.Comment(L"Selection Layer");
-    m_root.Children().InsertAtTop(m_selectedLayer);
+    m_boardLayer = m_compositor->CreateContainerVisual();
+    m_boardLayer->RelativeSizeAdjustment({ 1, 1 });
+    m_boardLayer->Comment(L"Board Layer");
+    m_root->InsertAtTop(m_boardLayer);
 
-    m_visuals = m_boardLayer.Children();
+    m_selectedLayer = m_compositor->CreateContainerVisual();
+    m_selectedLayer->RelativeSizeAdjustment({ 1, 1 });
+    m_selectedLayer->Comment(L"Selection Layer");
+    m_root->InsertAtTop(m_selectedLayer);
 
     // Get layout info
-    auto textHeight = m_shapeCache->TextHeight();
+    auto textHeight = m_compositor->TextHeight();
     m_layoutInfo.CardStackVerticalOffset = textHeight;
     const auto cardSize = CompositionCard::CardSize;
 
     // Play Area
-    auto playAreaOffsetY = cardSize.y + 25.0f;
-    m_playAreaVisual = m_compositor.CreateContainerVisual();
-    m_playAreaVisual.Offset({ 0, playAreaOffsetY, 0 });
-    m_playAreaVisual.Size({ 0, -playAreaOffsetY });
-    m_playAreaVisual.RelativeSizeAdjustment({ 1, 1 });
-    m_playAreaVisual.Comment(L"Play Area Root");
-    m_visuals.InsertAtTop(m_playAreaVisual);
+    auto playAreaOffsetY = cardSize.Y + 25.0f;
+    m_playAreaVisual = m_compositor->CreateContainerVisual();
+    m_playAreaVisual->Offset({ 0, playAreaOffsetY, 0 });
+    m_playAreaVisual->Size({ 0, -playAreaOffsetY });
+    m_playAreaVisual->RelativeSizeAdjustment({ 1, 1 });
+    m_playAreaVisual->Comment(L"Play Area Root");
+    m_boardLayer->InsertAtTop(m_playAreaVisual);
     m_zoneRects.insert({ HitTestZone::PlayArea, { 0, playAreaOffsetY, hostSize.x, hostSize.y - playAreaOffsetY } });
 
     // Deck
-    m_deckVisual = m_compositor.CreateContainerVisual();
-    m_deckVisual.Size(CompositionCard::CardSize);
-    m_deckVisual.Comment(L"Deck Area Root");
-    m_visuals.InsertAtTop(m_deckVisual);
-    m_zoneRects.insert({ HitTestZone::Deck, { 0, 0, cardSize.x, cardSize.y } });
+    m_deckVisual = m_compositor->CreateContainerVisual();
+    m_deckVisual->Size(CompositionCard::CardSize);
+    m_deckVisual->Comment(L"Deck Area Root");
+    m_boardLayer->InsertAtTop(m_deckVisual);
+    m_zoneRects.insert({ HitTestZone::Deck, { 0, 0, cardSize.X, cardSize.Y } });
 
     // Waste
-    m_wasteVisual = m_compositor.CreateContainerVisual();
-    m_wasteVisual.Size({ (2.0f * m_layoutInfo.WasteHorizontalOffset) + cardSize.x, cardSize.y });
-    m_wasteVisual.Offset({ cardSize.x + 25.0f, 0, 0 });
-    m_wasteVisual.Comment(L"Waste Area Root");
-    m_visuals.InsertAtTop(m_wasteVisual);
-    m_zoneRects.insert({ HitTestZone::Waste, { cardSize.x + 25.0f, 0, (2.0f * m_layoutInfo.WasteHorizontalOffset) + cardSize.x, cardSize.y } });
+    m_wasteVisual = m_compositor->CreateContainerVisual();
+    m_wasteVisual->Size({ (2.0f * m_layoutInfo.WasteHorizontalOffset) + cardSize.X, cardSize.Y });
+    m_wasteVisual->Offset({ cardSize.X + 25.0f, 0, 0 });
+    m_wasteVisual->Comment(L"Waste Area Root");
+    m_boardLayer->InsertAtTop(m_wasteVisual);
+    m_zoneRects.insert({ HitTestZone::Waste, { cardSize.X + 25.0f, 0, (2.0f * m_layoutInfo.WasteHorizontalOffset) + cardSize.X, cardSize.Y } });
 
     // Foundation
-    m_foundationVisual = m_compositor.CreateContainerVisual();
-    m_foundationVisual.Size({ 4.0f * cardSize.x + 3.0f * 15.0f, cardSize.y });
-    m_foundationVisual.AnchorPoint({ 1, 0 });
-    m_foundationVisual.RelativeOffsetAdjustment({ 1, 0, 0 });
-    m_foundationVisual.Comment(L"Foundations Root");
-    m_visuals.InsertAtTop(m_foundationVisual);
-    m_zoneRects.insert({ HitTestZone::Foundations, { hostSize.x - m_foundationVisual.Size().x, 0, m_foundationVisual.Size().x, m_foundationVisual.Size().y } });
+    m_foundationVisual = m_compositor->CreateContainerVisual();
+    m_foundationVisual->Size({ 4.0f * cardSize.X + 3.0f * 15.0f, cardSize.Y });
+    m_foundationVisual->AnchorPoint({ 1, 0 });
+    m_foundationVisual->RelativeOffsetAdjustment({ 1, 0, 0 });
+    m_foundationVisual->Comment(L"Foundations Root");
+    m_boardLayer->InsertAtTop(m_foundationVisual);
+    m_zoneRects.insert({ HitTestZone::Foundations, { hostSize.x - m_foundationVisual->Size().X, 0, m_foundationVisual->Size().X, m_foundationVisual->Size().Y } });
+
+    // The cards and piles last for the whole session, each new game deals
+    // the same cards into the same piles.
+    m_cardTable = std::make_shared<CardTable>(m_compositor);
+    m_pack = std::make_unique<Pack>();
+    m_stacks = ConstructStacks();
+    m_deck = ConstructDeck();
+    m_waste = ConstructWaste();
+    m_foundations = ConstructFoundations();
 
     NewGame();
 }
 
+winrt::Visual Game::Root()
+{
+    return Compositing::WinRTCompositor::Unwrap(m_root);
+}
+
 void Game::NewGame()
 {
-    m_pack = std::make_unique<Pack>(m_shapeCache);
+    SaveReplay();
+
+    BeginAction();
+    // Let go of a drag in progress before its cards are dealt again.
+    m_selectedLayer->RemoveAll();
+    m_selectedVisual = nullptr;
+    m_selectedCards.clear();
+    m_itemContainerPool->Release(m_selectedItemContainers);
+    m_selectedItemContainers.clear();
+
 #ifdef _DEBUG
     //m_pack->Shuffle({ 1318857190, 1541316502, 3202618166, 965450609 });
     m_pack->Shuffle();
 #else
     m_pack->Shuffle();
 #endif
-    auto cards = m_pack->Cards();
+    DealCards(m_pack->Cards());
+    m_state = Klondike::Deal(m_pack->CurrentSeed());
+    m_moveLog.Clear();
+    m_isHitTestIndexDirty = true;
 
-    auto [stacks, numCardsUsed] = ConstructStacks(cards);
-    m_stacks = stacks;
-    m_deck = ConstructDeck(cards, numCardsUsed);
-    m_waste = ConstructWaste();
-    m_foundations = ConstructFoundations();
-
-    m_selectedLayer.Children().RemoveAll();
-    m_selectedVisual = nullptr;
-    m_selectedCards.clear();
-    m_selectedItemContainers.clear();
     m_lastOperation = Pile::RemovalOperation();
     m_lastPile = nullptr;
     m_lastHitTest = Pile::HitTestResult();
+    EndAction(L"New game");
 }
 
 void Game::OnPointerPressed(winrt::float2 const point)
@@ -148,144 +131,129 @@ void Game::OnPointerPressed(winrt::float2 const point)
         return;
     }
 
-    for (auto& pair : m_zoneRects)
+    BeginAction();
+    auto hit = HitTestBoard(point);
+    switch (hit.IsHit() ? ZoneOf((Klondike::Location)hit.Pile) : HitTestZone::None)
+    {
+    case HitTestZone::Deck:
     {
-        auto zoneType = pair.first;
-        auto rect = pair.second;
+        auto cards = m_deck->Draw();
 
-        if (point.x >= rect.X &&
-            point.x < rect.X + rect.Width &&
-            point.y >= rect.Y &&
-            point.y < rect.Y + rect.Height)
+        if (!cards.empty())
         {
-            switch (zoneType)
-            {
-            case HitTestZone::Deck:
+            RecordMove({ Klondike::StockLocation, Klondike::WasteLocation });
+
+            // Compute difference between the two zones
+            auto deckZoneRect = m_zoneRects[HitTestZone::Deck];
+            auto wasteZoneRect = m_zoneRects[HitTestZone::Waste];
+            auto dX = wasteZoneRect.X - deckZoneRect.X;
+            auto dy = wasteZoneRect.Y - deckZoneRect.Y;
+
+            m_compositor->BeginBatch();
+
+            auto count = 0;
+            for (auto handle : cards)
             {
-                if (m_deck->HitTest(point))
-                {
-                    auto cards = m_deck->Draw();
+                auto& card = (*m_cardTable)[handle];
+                auto& visual = card.Root();
+                m_boardLayer->InsertAtTop(visual);
+
+                auto duration = std::chrono::milliseconds(250);
+                auto delayTime = std::chrono::milliseconds(50 * count);
+
+                // TODO: Sync this up with the deck visual's actual position (transform parent?)
+                visual->Animate(
+                    Compositing::AnimatableProperty::OffsetX,
+                    { { 0, 0 }, { 1, CompositionCard::CardSize.X + 25.0f + count * m_layoutInfo.WasteHorizontalOffset } },
+                    duration,
+                    delayTime);
+                visual->Animate(
+                    Compositing::AnimatableProperty::OffsetZ,
+                    { { 0, 0 }, { 0.5f, 10.0f }, { 1, 0 } },
+                    duration,
+                    delayTime);
+
+                card.AnimateIsFaceUp(true, duration, delayTime);
+
+                count++;
+            }
 
-                    if (!cards.empty())
-                    {
-                        // Compute difference between the two zones
-                        auto deckZoneRect = m_zoneRects[HitTestZone::Deck];
-                        auto wasteZoneRect = m_zoneRects[HitTestZone::Waste];
-                        auto dX = wasteZoneRect.X - deckZoneRect.X;
-                        auto dy = wasteZoneRect.Y - deckZoneRect.Y;
-
-                        auto batch = m_compositor.CreateScopedBatch(winrt::CompositionBatchTypes::Animation);
-
-                        auto count = 0;
-                        for (auto& card : cards)
-                        {
-                            auto visual = card->Root();
-                            m_visuals.InsertAtTop(visual);
-
-                            auto duration = std::chrono::milliseconds(250);
-                            auto delayTime = std::chrono::milliseconds(50 * count);
-
-                            // TODO: Sync this up with the deck visual's actual position (transform parent?)
-                            auto xAnimation = m_compositor.CreateScalarKeyFrameAnimation();
-                            xAnimation.InsertKeyFrame(0, 0);
-                            xAnimation.InsertKeyFrame(1, CompositionCard::CardSize.x + 25.0f + count * m_layoutInfo.WasteHorizontalOffset);
-                            xAnimation.IterationBehavior(winrt::AnimationIterationBehavior::Count);
-                            xAnimation.IterationCount(1);
-                            xAnimation.Duration(duration);
-                            xAnimation.DelayTime(delayTime);
-                            visual.StartAnimation(L"Offset.X", xAnimation);
-
-                            auto zAnimation = m_compositor.CreateScalarKeyFrameAnimation();
-                            zAnimation.InsertKeyFrame(0, 0);
-                            zAnimation.InsertKeyFrame(0.5f, 10.0f);
-                            zAnimation.InsertKeyFrame(1, 0);
-                            zAnimation.IterationBehavior(winrt::AnimationIterationBehavior::Count);
-                            zAnimation.IterationCount(1);
-                            zAnimation.Duration(duration);
-                            zAnimation.DelayTime(delayTime);
-                            visual.StartAnimation(L"Offset.Z", zAnimation);
-
-                            card->AnimateIsFaceUp(true, duration, delayTime);
-
-                            count++;
-                        }
-
-                        batch.Completed([=](auto&& ...)
-                            {
-                                for (auto& card : cards)
-                                {
-                                    m_visuals.Remove(card->Root());
-                                }
-                                m_waste->Discard(cards);
-                                m_isDeckAnimationRunning = false;
-                            });
-                        m_isDeckAnimationRunning = true;
-                        batch.End();
-                    }
-                    else
+            m_isDeckAnimationRunning = true;
+            m_compositor->EndBatch([=]()
+                {
+                    BeginAction();
+                    for (auto card : cards)
                     {
-                        auto wasteCards = m_waste->Flush();
-                        m_deck->AddCards(wasteCards);
+                        m_boardLayer->Remove((*m_cardTable)[card].Root());
                     }
-                }
+                    m_waste->Discard(cards);
+                    m_isDeckAnimationRunning = false;
+                    EndAction(L"Draw finished");
+                });
+        }
+        else
+        {
+            auto wasteCards = m_waste->Flush();
+            m_deck->AddCards(wasteCards);
+            if (!wasteCards.empty())
+            {
+                RecordMove({ Klondike::WasteLocation, Klondike::StockLocation });
             }
-            break;
-            case HitTestZone::PlayArea:
-            case HitTestZone::Foundations:
-            case HitTestZone::Waste:
+        }
+    }
+    break;
+    case HitTestZone::PlayArea:
+    case HitTestZone::Foundations:
+    case HitTestZone::Waste:
+    {
+        auto [foundPile, hitTestResult, hitTestZone] = HitTestPiles(point, { Pile::HitTestTarget::Card });
+        if (foundPile)
+        {
+            auto canSplit = foundPile->CanSplit(hitTestResult.CardIndex);
+            auto canTake = foundPile->CanTake(hitTestResult.CardIndex);
+
+            if (canSplit || canTake)
             {
-                auto containerHitTestRect = m_zoneRects[zoneType];
-                auto [foundPile, hitTestResult, hitTestZone] = HitTestPiles(point, { Pile::HitTestTarget::Card });
-                if (foundPile)
+                m_lastPile = foundPile;
+                if (canSplit)
                 {
-                    auto canSplit = foundPile->CanSplit(hitTestResult.CardIndex);
-                    auto canTake = foundPile->CanTake(hitTestResult.CardIndex);
-
-                    if (canSplit || canTake)
-                    {
-                        m_lastPile = foundPile;
-                        if (canSplit)
-                        {
-                            auto [containers, cards, operation] = foundPile->Split(hitTestResult.CardIndex);
-                            m_selectedItemContainers = containers;
-                            m_selectedCards = cards;
-                            m_lastOperation = operation;
-                        }
-                        else if (canTake)
-                        {
-                            auto [container, card, operation] = foundPile->Take(hitTestResult.CardIndex);
-                            m_selectedItemContainers = { container };
-                            m_selectedCards = { card };
-                            m_lastOperation = operation;
-                        }
-                        m_selectedVisual = m_selectedItemContainers.front().Root;
-                        m_lastHitTest = hitTestResult;
-                    }
+                    auto [containers, cards, operation] = foundPile->Split(hitTestResult.CardIndex);
+                    m_selectedItemContainers = containers;
+                    m_selectedCards = cards;
+                    m_lastOperation = operation;
                 }
+                else if (canTake)
+                {
+                    auto [container, card, operation] = foundPile->Take(hitTestResult.CardIndex);
+                    m_selectedItemContainers = { container };
+                    m_selectedCards = { card };
+                    m_lastOperation = operation;
+                }
+                m_selectedVisual = m_selectedItemContainers.front().Root;
+                m_lastHitTest = hitTestResult;
             }
-            break;
-            default:
-                continue;
-            }
-
-            break;
         }
     }
+    break;
+    default:
+        break;
+    }
 
     if (m_selectedVisual)
     {
-        m_selectedLayer.Children().InsertAtTop(m_selectedVisual);
-        winrt::float3 const offset = m_selectedVisual.Offset();
-        m_offset.x = offset.x - point.x;
-        m_offset.y = offset.y - point.y;
+        m_selectedLayer->InsertAtTop(m_selectedVisual);
+        auto const offset = m_selectedVisual->Offset();
+        m_offset.x = offset.X - point.x;
+        m_offset.y = offset.Y - point.y;
     }
+    EndAction(L"Press");
 }
 
 void Game::OnPointerMoved(winrt::float2 const point)
 {
     if (m_selectedVisual)
     {
-        m_selectedVisual.Offset(
+        m_selectedVisual->Offset(
             {
                 point.x + m_offset.x,
                 point.y + m_offset.y,
@@ -301,16 +269,17 @@ void Game::OnPointerReleased(winrt::float2 const point)
         return;
     }
 
+    BeginAction();
     if (m_selectedVisual)
     {
-        m_selectedLayer.Children().RemoveAll();
+        m_selectedLayer->RemoveAll();
 
         auto [foundPile, hitTestResult, hitTestZone] = HitTestPiles(point, { Pile::HitTestTarget::Card, Pile::HitTestTarget::Base });
         auto shouldBeInPile = foundPile && foundPile->CanAdd(m_selectedCards);
 
         for (auto& container : m_selectedItemContainers)
         {
-            container.Content.Children().RemoveAll();
+            container.Content->RemoveAll();
         }
 
         if (shouldBeInPile)
@@ -320,27 +289,14 @@ void Game::OnPointerReleased(winrt::float2 const point)
             if (m_lastPile)
             {
                 m_lastPile->CompleteRemoval(m_lastOperation);
+                RecordMove({ LocationOf(m_lastPile), LocationOf(foundPile), (uint8_t)m_selectedCards.size() });
             }
 
             // If we just added something to a foundation, let's check to see
             // if the player has won.
             if (hitTestZone == HitTestZone::Foundations)
             {
-                auto hasWon = true;
-                for (auto& foundation : m_foundations)
-                {
-                    auto cards = foundation->Cards();
-                    if (cards.size() != 13)
-                    {
-                        hasWon = false;
-                        break;
-                    }
-                }
-
-                if (hasWon)
-                {
-                    DisplayWinMessage();
-                }
+                CheckForWin();
             }
         }
         else if (m_lastPile)
@@ -354,75 +310,107 @@ void Game::OnPointerReleased(winrt::float2 const point)
     }
     m_selectedVisual = nullptr;
     m_selectedCards.clear();
+    m_itemContainerPool->Release(m_selectedItemContainers);
     m_selectedItemContainers.clear();
     m_lastOperation = Pile::RemovalOperation();
     m_lastPile = nullptr;
     m_lastHitTest = Pile::HitTestResult();
+    EndAction(L"Release");
+}
+
+void Game::Undo()
+{
+    if (IsAnimating() || m_selectedVisual || !m_moveLog.CanUndo())
+    {
+        return;
+    }
+
+    BeginAction();
+    auto move = m_moveLog.Undo();
+    m_state.Revert(move);
+
+    // Move the cards straight back, only the piles involved are touched.
+    auto cards = RemoveCards(move.To, move.Count);
+    if (move.Flags & Klondike::MoveFlags::RevealsCard)
+    {
+        auto& stack = m_stacks[move.From - Klondike::FirstColumn];
+        (*m_cardTable)[stack->Cards().back()].AnimateIsFaceUp(false, std::chrono::milliseconds(250), std::chrono::milliseconds(0));
+    }
+    AddCards(move.From, cards);
+    EndAction(L"Undo");
+}
+
+void Game::Redo()
+{
+    if (IsAnimating() || m_selectedVisual || !m_moveLog.CanRedo())
+    {
+        return;
+    }
+
+    BeginAction();
+    auto move = m_state.Apply(m_moveLog.Redo());
+
+    // Removing cards from a stack turns over its new top card by itself.
+    auto cards = RemoveCards(move.From, move.Count);
+    AddCards(move.To, cards);
+
+    EndAction(L"Redo");
+    if (Klondike::IsFoundation(move.To))
+    {
+        CheckForWin();
+    }
 }
 
 void Game::OnSizeChanged(winrt::float2 const size)
 {
-    auto playAreaOffsetY = m_playAreaVisual.Offset().y;
-    m_zoneRects.insert({ HitTestZone::PlayArea, { 0, playAreaOffsetY, size.x, size.y - playAreaOffsetY } });
-    m_zoneRects[HitTestZone::Foundations] = { size.x - m_foundationVisual.Size().x, 0, m_foundationVisual.Size().x, m_foundationVisual.Size().y };
+    auto playAreaOffsetY = m_playAreaVisual->Offset().Y;
+    m_zoneRects[HitTestZone::PlayArea] = { 0, playAreaOffsetY, size.x, size.y - playAreaOffsetY };
+    m_zoneRects[HitTestZone::Foundations] = { size.x - m_foundationVisual->Size().X, 0, m_foundationVisual->Size().X, m_foundationVisual->Size().Y };
+    m_isHitTestIndexDirty = true;
+}
+
+void Game::OnScaleChanged(float const scale)
+{
+    m_compositor->RasterizationScale(scale);
 }
 
-std::pair<std::vector<std::shared_ptr<CardStack>>, int> Game::ConstructStacks(Pile::CardList const& cards)
+std::vector<std::shared_ptr<CardStack>> Game::ConstructStacks()
 {
     const auto cardSize = CompositionCard::CardSize;
 
     std::vector<std::shared_ptr<CardStack>> stacks;
-    auto playAreaVisuals = m_playAreaVisual.Children();
-    playAreaVisuals.RemoveAll();
-    auto cardsSoFar = 0;
+    m_playAreaVisual->RemoveAll();
     auto numberOfStacks = 7;
     for (int i = 0; i < numberOfStacks; i++)
     {
-        auto numberOfCards = i + 1;
-
-        auto start = cards.begin() + cardsSoFar;
-        std::vector<std::shared_ptr<CompositionCard>> tempStack(start, start + numberOfCards);
-        cardsSoFar += numberOfCards;
-
-        auto stack = std::make_shared<CardStack>(m_shapeCache, tempStack);
+        auto stack = std::make_shared<CardStack>(m_compositor, m_itemContainerPool, m_cardTable);
         stack->SetLayoutOptions(m_layoutInfo.CardStackVerticalOffset);
-        stack->ForceLayout();
+        stack->SetLayoutMode(m_layoutInfo.PileMode);
         auto baseVisual = stack->Base();
 
-        baseVisual.Offset({ (float)i * (cardSize.x + 15.0f), 0, 0 });
-        playAreaVisuals.InsertAtTop(baseVisual);
+        baseVisual->Offset({ (float)i * (cardSize.X + 15.0f), 0, 0 });
+        m_playAreaVisual->InsertAtTop(baseVisual);
 
         stacks.push_back(stack);
     }
-    for (auto& stack : stacks)
-    {
-        auto cards = stack->Cards();
-        for (auto& card : cards)
-        {
-            card->IsFaceUp(false);
-        }
-        cards.back()->IsFaceUp(true);
-    }
-    return { stacks, cardsSoFar };
+    return stacks;
 }
 
-std::unique_ptr<Deck> Game::ConstructDeck(Pile::CardList const& cards, int startAt)
+std::unique_ptr<Deck> Game::ConstructDeck()
 {
-    std::vector<std::shared_ptr<CompositionCard>> deck(cards.begin() + startAt, cards.end());
-    auto result = std::make_unique<Deck>(m_shapeCache, deck);
-    result->ForceLayout();
-    m_deckVisual.Children().RemoveAll();
-    m_deckVisual.Children().InsertAtTop(result->Base());
+    auto result = std::make_unique<Deck>(m_compositor, m_cardTable);
+    m_deckVisual->RemoveAll();
+    m_deckVisual->InsertAtTop(result->Base());
     return result;
 }
 
 std::shared_ptr<Waste> Game::ConstructWaste()
 {
-    auto waste = std::make_shared<Waste>(m_shapeCache);
+    auto waste = std::make_shared<Waste>(m_compositor, m_itemContainerPool, m_cardTable);
     waste->SetLayoutOptions(m_layoutInfo.WasteHorizontalOffset);
-    waste->ForceLayout();
-    m_wasteVisual.Children().RemoveAll();
-    m_wasteVisual.Children().InsertAtTop(waste->Base());
+    waste->SetLayoutMode(m_layoutInfo.PileMode);
+    m_wasteVisual->RemoveAll();
+    m_wasteVisual->InsertAtTop(waste->Base());
     return waste;
 }
 
@@ -431,18 +419,54 @@ std::vector<std::shared_ptr<::Foundation>> Game::ConstructFoundations()
     const auto cardSize = CompositionCard::CardSize;
 
     std::vector<std::shared_ptr<::Foundation>> foundations;
-    m_foundationVisual.Children().RemoveAll();
+    m_foundationVisual->RemoveAll();
     for (int i = 0; i < 4; i++)
     {
-        auto foundation = std::make_shared<::Foundation>(m_shapeCache);
+        auto foundation = std::make_shared<::Foundation>(m_compositor, m_itemContainerPool, m_cardTable);
+        foundation->SetLayoutMode(m_layoutInfo.PileMode);
         auto visual = foundation->Base();
-        visual.Offset({ i * (cardSize.x + 15.0f), 0, 0 });
-        m_foundationVisual.Children().InsertAtTop(visual);
+        visual->Offset({ i * (cardSize.X + 15.0f), 0, 0 });
+        m_foundationVisual->InsertAtTop(visual);
         foundations.push_back(foundation);
     }
     return foundations;
 }
 
+// Clears every pile and lays the cards out for a new game. The piles, cards
+// and item containers are all left over from the last game, so nothing new
+// is built.
+void Game::DealCards(CardSpan cards)
+{
+    m_deck->Clear();
+    m_waste->Clear();
+    for (auto& foundation : m_foundations)
+    {
+        foundation->Clear();
+    }
+    for (auto& stack : m_stacks)
+    {
+        stack->Clear();
+    }
+
+    auto cardsSoFar = 0;
+    for (int i = 0; i < m_stacks.size(); i++)
+    {
+        auto numberOfCards = i + 1;
+
+        auto stackCards = cards.subspan(cardsSoFar, numberOfCards);
+        cardsSoFar += numberOfCards;
+
+        // Face first, so cards that stay face down don't build a front.
+        for (auto card : stackCards)
+        {
+            (*m_cardTable)[card].IsFaceUp(false);
+        }
+        (*m_cardTable)[stackCards.back()].IsFaceUp(true);
+        m_stacks[i]->Put(stackCards);
+    }
+    m_deck->AddCards(cards.subspan(cardsSoFar));
+}
+
 winrt::fire_and_forget Game::DisplayWinMessage()
 {
     auto dialog = winrt::MessageDialog(L"You won!");
@@ -450,48 +474,332 @@ winrt::fire_and_forget Game::DisplayWinMessage()
     NewGame();
 }
 
+winrt::fire_and_forget Game::DisplayIsGameWinnableMessage()
+{
+    auto state = m_state;
+
+    // Solving can take a while, keep it off the UI thread and put every
+    // core on it.
+    winrt::apartment_context uiThread;
+    co_await winrt::resume_background();
+    Klondike::ParallelSolver solver;
+    auto result = solver.Solve(state);
+    co_await uiThread;
+
+    std::wstringstream message;
+    switch (result.Status)
+    {
+    case Klondike::SolveStatus::Winnable:
+        message << L"This game can still be won in " << result.Moves.size() << L" moves.";
+        break;
+    case Klondike::SolveStatus::Unwinnable:
+        message << L"This game can't be won from here.";
+        break;
+    case Klondike::SolveStatus::Unknown:
+        message << L"Couldn't tell if this game can still be won.";
+        break;
+    }
+    message << std::endl << result.Nodes << L" positions searched on " << solver.ThreadCount() << L" threads (" << (uint64_t)result.NodesPerSecond() << L" per second).";
+
+    auto dialog = winrt::MessageDialog(message.str());
+    co_await dialog.ShowAsync();
+}
+
 void Game::SetNewLayout(LayoutInformation layoutInfo)
 {
+    BeginAction();
     m_layoutInfo = layoutInfo;
     m_waste->SetLayoutOptions(m_layoutInfo.WasteHorizontalOffset);
-    m_waste->ForceLayout();
+    m_waste->SetLayoutMode(m_layoutInfo.PileMode);
+    m_waste->UpdateLayout();
     for (auto& stack : m_stacks)
     {
         stack->SetLayoutOptions(m_layoutInfo.CardStackVerticalOffset);
-        stack->ForceLayout();
+        stack->SetLayoutMode(m_layoutInfo.PileMode);
+        stack->UpdateLayout();
+    }
+    for (auto& foundation : m_foundations)
+    {
+        foundation->SetLayoutMode(m_layoutInfo.PileMode);
+        foundation->UpdateLayout();
     }
     auto cardSize = CompositionCard::CardSize;
-    m_zoneRects[HitTestZone::Waste] = { cardSize.x + 25.0f, 0, (2.0f * m_layoutInfo.WasteHorizontalOffset) + cardSize.x, cardSize.y };
+    m_zoneRects[HitTestZone::Waste] = { cardSize.X + 25.0f, 0, (2.0f * m_layoutInfo.WasteHorizontalOffset) + cardSize.X, cardSize.Y };
+    m_isHitTestIndexDirty = true;
+    EndAction(L"Layout");
 }
 
-std::tuple<std::shared_ptr<Pile>, Pile::HitTestResult, HitTestZone> Game::HitTestPiles(
-    winrt::float2 const point,
-    std::initializer_list<Pile::HitTestTarget> const& desiredTargets)
+void Game::RecordMove(Klondike::Move const& move)
 {
+    WINRT_ASSERT(m_state.IsLegal(move));
+    m_moveLog.Record(m_state.Apply(move));
+}
 
+// Appends the game that just finished, won or not, to the replay file in the
+// app's local folder. Games only go on the end of a file of the current
+// version, one written by an older version is upgraded first.
+void Game::SaveReplay()
+{
+    if (m_moveLog.Size() == 0)
     {
-        auto [result, stack] = ::HitTestPiles(point, m_zoneRects, m_stacks, HitTestZone::PlayArea, desiredTargets);
-        if (result.Target != Pile::HitTestTarget::None)
+        return;
+    }
+
+    auto folder = winrt::Windows::Storage::ApplicationData::Current().LocalFolder();
+    auto path = std::wstring(folder.Path()) + L"\\games.klrp";
+
+    // The header is enough to tell whether the rest has to be read.
+    std::vector<uint8_t> existing;
+    FILE* file = nullptr;
+    if (_wfopen_s(&file, path.c_str(), L"rb") == 0 && file)
+    {
+        uint8_t chunk[4096];
+        for (size_t read; (read = fread(chunk, 1, sizeof(chunk), file)) > 0;)
         {
-            return { stack, result, HitTestZone::PlayArea };
+            existing.insert(existing.end(), chunk, chunk + read);
+            if (Klondike::ReplayFileVersion(existing.data(), existing.size()) == Klondike::ReplayVersion)
+            {
+                break;
+            }
         }
+        fclose(file);
     }
 
+    std::vector<uint8_t> buffer;
+    auto mode = L"wb";
+    if (Klondike::ReplayFileVersion(existing.data(), existing.size()) == Klondike::ReplayVersion)
     {
-        auto [result, foundation] = ::HitTestPiles(point, m_zoneRects, m_foundations, HitTestZone::Foundations, desiredTargets);
-        if (result.Target != Pile::HitTestTarget::None)
+        mode = L"ab";
+    }
+    else if (existing.empty() || !Klondike::UpgradeReplayFile(existing.data(), existing.size(), buffer))
+    {
+        // Whatever can't be read is kept out of the way, not written over.
+        if (!existing.empty())
         {
-            return { foundation, result, HitTestZone::Foundations };
+            auto oldPath = path + L".old";
+            _wremove(oldPath.c_str());
+            _wrename(path.c_str(), oldPath.c_str());
         }
+        Klondike::WriteReplayFileHeader(buffer);
+    }
+    Klondike::WriteReplayGame(buffer, m_pack->CurrentSeed(), m_moveLog.Moves(), m_moveLog.Size());
+
+    if (_wfopen_s(&file, path.c_str(), mode) != 0 || !file)
+    {
+        return;
+    }
+    fwrite(buffer.data(), 1, buffer.size(), file);
+    fclose(file);
+}
+
+Layout::LayoutCounts Game::TotalLayoutCounts()
+{
+    auto counts = m_deck->LayoutCounts();
+    counts += m_waste->LayoutCounts();
+    for (auto& stack : m_stacks)
+    {
+        counts += stack->LayoutCounts();
+    }
+    for (auto& foundation : m_foundations)
+    {
+        counts += foundation->LayoutCounts();
+    }
+    return counts;
+}
+
+void Game::BeginAction()
+{
+    m_actionStartCounts = m_compositor->Counts();
+    m_actionStartLayoutCounts = TotalLayoutCounts();
+}
+
+void Game::EndAction(wchar_t const* name)
+{
+    m_lastActionCounts = m_compositor->Counts() - m_actionStartCounts;
+    m_lastActionLayoutCounts = TotalLayoutCounts() - m_actionStartLayoutCounts;
+#ifdef _DEBUG
+    std::wstringstream debugMessage;
+    debugMessage << name << L": " << m_lastActionCounts.Creates << L" creates, ";
+    debugMessage << m_lastActionCounts.Inserts << L" inserts, ";
+    debugMessage << m_lastActionCounts.Removes << L" removes, ";
+    debugMessage << m_lastActionCounts.PropertySets << L" property sets, ";
+    debugMessage << m_lastActionCounts.Animations << L" animations, ";
+    debugMessage << m_lastActionLayoutCounts.ContainersChecked << L" containers laid out (";
+    debugMessage << m_lastActionLayoutCounts.OffsetsChanged << L" moved, ";
+    debugMessage << m_lastActionLayoutCounts.ContainersTransformed << L" transformed), ";
+    debugMessage << m_itemContainerPool->Stats().InUse << L" item containers in use (";
+    debugMessage << m_itemContainerPool->Stats().HighWater << L" at most, ";
+    debugMessage << m_itemContainerPool->Stats().Created << L" created)" << std::endl;
+    OutputDebugStringW(debugMessage.str().c_str());
+#endif
+}
+
+void Game::CheckForWin()
+{
+    if (m_state.IsWon())
+    {
+        DisplayWinMessage();
     }
+}
 
+Klondike::Location Game::LocationOf(std::shared_ptr<Pile> const& pile)
+{
+    for (auto i = 0; i < m_stacks.size(); i++)
+    {
+        if (m_stacks[i] == pile)
+        {
+            return Klondike::ColumnLocation(i);
+        }
+    }
+    for (auto i = 0; i < m_foundations.size(); i++)
     {
-        auto [result, waste] = ::HitTestPiles<Waste>(point, m_zoneRects, { m_waste }, HitTestZone::Waste, desiredTargets);
-        if (result.Target != Pile::HitTestTarget::None)
+        if (m_foundations[i] == pile)
         {
-            return { waste, result, HitTestZone::Waste };
+            return Klondike::FoundationLocation(i);
         }
     }
+    WINRT_ASSERT(m_waste == pile);
+    return Klondike::WasteLocation;
+}
 
+std::shared_ptr<Pile> Game::PileAt(Klondike::Location location)
+{
+    if (Klondike::IsColumn(location))
+    {
+        return m_stacks[location - Klondike::FirstColumn];
+    }
+    if (Klondike::IsFoundation(location))
+    {
+        return m_foundations[location - Klondike::FirstFoundation];
+    }
+    WINRT_ASSERT(location == Klondike::WasteLocation);
+    return m_waste;
+}
+
+// Cards come back in pile order, the top card last. The deck hands them out
+// in the order it deals them, which is the order the waste takes them in.
+Pile::CardList Game::RemoveCards(Klondike::Location location, int count)
+{
+    if (location == Klondike::StockLocation)
+    {
+        return m_deck->Draw(count);
+    }
+    return PileAt(location)->Remove(count);
+}
+
+void Game::AddCards(Klondike::Location location, CardSpan cards)
+{
+    if (location == Klondike::StockLocation)
+    {
+        Pile::CardList reversed;
+        for (auto card = cards.rbegin(); card != cards.rend(); card++)
+        {
+            reversed.push_back(*card);
+        }
+        m_deck->AddCards(reversed);
+        return;
+    }
+
+    for (auto card : cards)
+    {
+        (*m_cardTable)[card].IsFaceUp(true);
+    }
+
+    if (location == Klondike::WasteLocation)
+    {
+        m_waste->Discard(cards);
+    }
+    else
+    {
+        PileAt(location)->Put(cards);
+    }
+}
+
+std::tuple<std::shared_ptr<Pile>, Pile::HitTestResult, HitTestZone> Game::HitTestPiles(
+    winrt::float2 const point,
+    std::initializer_list<Pile::HitTestTarget> const& desiredTargets)
+{
+    auto hit = HitTestBoard(point);
+    if (!hit.IsHit() || hit.Pile == Klondike::StockLocation)
+    {
+        return { nullptr, Pile::HitTestResult(), HitTestZone::None };
+    }
+
+    Pile::HitTestResult result;
+    if (hit.Card == Layout::HitTestIndex::Base)
+    {
+        result.Target = Pile::HitTestTarget::Base;
+    }
+    else
+    {
+        result.Target = Pile::HitTestTarget::Card;
+        result.CardIndex = hit.Card;
+    }
+
+    for (auto& target : desiredTargets)
+    {
+        if (result.Target == target)
+        {
+            auto location = (Klondike::Location)hit.Pile;
+            return { PileAt(location), result, ZoneOf(location) };
+        }
+    }
     return { nullptr, Pile::HitTestResult(), HitTestZone::None };
+}
+
+Layout::HitTestIndex::Hit Game::HitTestBoard(winrt::float2 const point)
+{
+    UpdateHitTestIndex();
+    return m_hitTestIndex.Find({ point.x, point.y });
+}
+
+void Game::UpdateHitTestIndex()
+{
+    auto isCurrent = !m_isHitTestIndexDirty;
+    for (auto location = 0; location <= Klondike::WasteLocation && isCurrent; location++)
+    {
+        isCurrent = m_indexedPileVersions[location] == PileAt((Klondike::Location)location)->Version();
+    }
+    if (isCurrent)
+    {
+        return;
+    }
+
+    m_hitTestIndex.Clear();
+    auto deckRect = m_zoneRects[HitTestZone::Deck];
+    m_hitTestIndex.Add({ deckRect.X, deckRect.Y, deckRect.Width, deckRect.Height }, Klondike::StockLocation, Layout::HitTestIndex::Base);
+
+    auto cardSize = CompositionCard::CardSize;
+    for (auto location = 0; location <= Klondike::WasteLocation; location++)
+    {
+        // Piles sit in their zone, cards sit on their pile.
+        auto pile = PileAt((Klondike::Location)location);
+        auto zoneRect = m_zoneRects[ZoneOf((Klondike::Location)location)];
+        auto& base = pile->Base();
+        auto x = zoneRect.X + base->Offset().X;
+        auto y = zoneRect.Y + base->Offset().Y;
+        m_hitTestIndex.Add({ x, y, base->Size().X, base->Size().Y }, location, Layout::HitTestIndex::Base);
+        for (auto i = 0; i < pile->Cards().size(); i++)
+        {
+            auto offset = pile->CardOffset(i);
+            m_hitTestIndex.Add({ x + offset.X, y + offset.Y, cardSize.X, cardSize.Y }, location, i);
+        }
+        m_indexedPileVersions[location] = pile->Version();
+    }
+
+    m_hitTestIndex.Build();
+    m_isHitTestIndexDirty = false;
+}
+
+HitTestZone Game::ZoneOf(Klondike::Location location)
+{
+    if (Klondike::IsColumn(location))
+    {
+        return HitTestZone::PlayArea;
+    }
+    if (Klondike::IsFoundation(location))
+    {
+        return HitTestZone::Foundations;
+    }
+    return location == Klondike::WasteLocation ? HitTestZone::Waste : HitTestZone::Deck;
 }
\ No newline at end of file
@@ -1,10 +1,15 @@
 #pragma once
 #include "Pile.h"
+#include "Klondike.h"
+#include "MoveLog.h"
+#include "HitTestIndex.h"
+#include "ItemContainerPool.h"
 
 struct LayoutInformation
 {
     float CardStackVerticalOffset = 47.88f;
     float WasteHorizontalOffset = 65.0f;
+    Layout::PileMode PileMode = Layout::PileMode::Nested;
 };
 
 enum class HitTestZone
@@ -19,17 +24,35 @@ enum class HitTestZone
 class Game
 {
 public:
-    Game(winrt::Windows::UI::Composition::Compositor const& compositor, winrt::Windows::Foundation::Numerics::float2 const hostSize);
+    Game(
+        winrt::Windows::UI::Composition::Compositor const& compositor,
+        winrt::Windows::Foundation::Numerics::float2 const hostSize,
+        Compositing::CardRendering cardRendering = Compositing::CardRendering::Shapes);
 
-    winrt::Windows::UI::Composition::Visual Root() { return m_root; }
+    winrt::Windows::UI::Composition::Visual Root();
 
     void NewGame();
+    void Undo();
+    void Redo();
     void OnPointerPressed(winrt::Windows::Foundation::Numerics::float2 const point);
     void OnPointerMoved(winrt::Windows::Foundation::Numerics::float2 const point);
     void OnPointerReleased(winrt::Windows::Foundation::Numerics::float2 const point);
     void OnSizeChanged(winrt::Windows::Foundation::Numerics::float2 const size);
+    // Pixels on screen per unit of the game's visuals.
+    void OnScaleChanged(float const scale);
 
     bool IsAnimating() { return m_isDeckAnimationRunning; }
+    // Compositor work done by the last press, release, undo, redo, new game
+    // or the end of a draw. Dragging is one offset set per move.
+    Compositing::OperationCounts LastActionCounts() const { return m_lastActionCounts; }
+    // Pile layout work done by the same action.
+    Layout::LayoutCounts LastActionLayoutCounts() const { return m_lastActionLayoutCounts; }
+    // Composition objects behind the cards and piles built so far.
+    Compositing::ResourceCounts Resources() const { return m_compositor->Resources(); }
+    winrt::fire_and_forget DisplayIsGameWinnableMessage();
+    // Adds the game so far to the replay file, done for every game that is
+    // left, whether for a new one or when the game itself is replaced.
+    void SaveReplay();
 
     // TODO: Remove these
     LayoutInformation LayoutInfo() { return m_layoutInfo; }
@@ -39,28 +62,42 @@ public:
     }
 
 private:
-    std::pair<std::vector<std::shared_ptr<CardStack>>, int> ConstructStacks(Pile::CardList const& cards);
-    std::unique_ptr<Deck> ConstructDeck(Pile::CardList const& cards, int startAt);
+    std::vector<std::shared_ptr<CardStack>> ConstructStacks();
+    std::unique_ptr<Deck> ConstructDeck();
     std::shared_ptr<Waste> ConstructWaste();
     std::vector<std::shared_ptr<::Foundation>> ConstructFoundations();
+    void DealCards(CardSpan cards);
     winrt::fire_and_forget DisplayWinMessage();
     void SetNewLayout(LayoutInformation layoutInfo);
     std::tuple<std::shared_ptr<Pile>, Pile::HitTestResult, HitTestZone> HitTestPiles(
         winrt::Windows::Foundation::Numerics::float2 const point,
         std::initializer_list<Pile::HitTestTarget> const& desiredTargets);
+    Layout::HitTestIndex::Hit HitTestBoard(winrt::Windows::Foundation::Numerics::float2 const point);
+    void UpdateHitTestIndex();
+    HitTestZone ZoneOf(Klondike::Location location);
+    void RecordMove(Klondike::Move const& move);
+    void CheckForWin();
+    Layout::LayoutCounts TotalLayoutCounts();
+    void BeginAction();
+    void EndAction(wchar_t const* name);
+    Klondike::Location LocationOf(std::shared_ptr<Pile> const& pile);
+    std::shared_ptr<Pile> PileAt(Klondike::Location location);
+    Pile::CardList RemoveCards(Klondike::Location location, int count);
+    void AddCards(Klondike::Location location, CardSpan cards);
 
 private:
-    winrt::Windows::UI::Composition::Compositor m_compositor{ nullptr };
-    winrt::Windows::UI::Composition::ContainerVisual m_root{ nullptr };
-    winrt::Windows::UI::Composition::ContainerVisual m_boardLayer{ nullptr };
-    winrt::Windows::UI::Composition::ContainerVisual m_foundationVisual{ nullptr };
-    winrt::Windows::UI::Composition::ContainerVisual m_deckVisual{ nullptr };
-    winrt::Windows::UI::Composition::ContainerVisual m_wasteVisual{ nullptr };
-    winrt::Windows::UI::Composition::ContainerVisual m_playAreaVisual{ nullptr };
-    winrt::Windows::UI::Composition::ContainerVisual m_selectedLayer{ nullptr };
-    winrt::Windows::UI::Composition::VisualCollection m_visuals{ nullptr };
+    std::shared_ptr<Compositing::Compositor> m_compositor;
+    std::shared_ptr<ItemContainerPool> m_itemContainerPool;
+    std::shared_ptr<CardTable> m_cardTable;
+    Compositing::VisualPtr m_root;
+    Compositing::VisualPtr m_boardLayer;
+    Compositing::VisualPtr m_foundationVisual;
+    Compositing::VisualPtr m_deckVisual;
+    Compositing::VisualPtr m_wasteVisual;
+    Compositing::VisualPtr m_playAreaVisual;
+    Compositing::VisualPtr m_selectedLayer;
 
-    winrt::Windows::UI::Composition::Visual m_selectedVisual{ nullptr };
+    Compositing::VisualPtr m_selectedVisual;
     Pile::CardList m_selectedCards;
     Pile::ItemContainerList m_selectedItemContainers;
     Pile::RemovalOperation m_lastOperation;
@@ -69,13 +106,26 @@ private:
     winrt::Windows::Foundation::Numerics::float2 m_offset{};
 
     bool m_isDeckAnimationRunning = false;
+    Compositing::OperationCounts m_actionStartCounts;
+    Compositing::OperationCounts m_lastActionCounts;
+    Layout::LayoutCounts m_actionStartLayoutCounts;
+    Layout::LayoutCounts m_lastActionLayoutCounts;
     LayoutInformation m_layoutInfo{};
 
-    std::shared_ptr<ShapeCache> m_shapeCache;
     std::unique_ptr<Pack> m_pack;
     std::vector<std::shared_ptr<CardStack>> m_stacks;
     std::map<HitTestZone, winrt::Windows::Foundation::Rect> m_zoneRects;
     std::unique_ptr<Deck> m_deck;
     std::shared_ptr<Waste> m_waste;
     std::vector<std::shared_ptr<::Foundation>> m_foundations;
+
+    // The same game in the rules engine, kept in step with the piles.
+    Klondike::State m_state;
+    Klondike::MoveLog m_moveLog;
+
+    // Every pile base and card in window space, rebuilt when the layout
+    // changes or a pile's version moves on.
+    Layout::HitTestIndex m_hitTestIndex;
+    std::array<uint32_t, Klondike::WasteLocation + 1> m_indexedPileVersions{};
+    bool m_isHitTestIndexDirty = true;
 };
\ No newline at end of file
@@ -0,0 +1,308 @@
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include "GlyphCache.h"
+
+namespace Layout
+{
+    constexpr uint8_t GlyphCacheMagic[4] = { 'K', 'G', 'L', 'Y' };
+    constexpr size_t PointSize = 8;
+
+    static void WriteUInt16(std::vector<uint8_t>& buffer, uint16_t value)
+    {
+        buffer.push_back((uint8_t)value);
+        buffer.push_back((uint8_t)(value >> 8));
+    }
+
+    static void WriteFloat(std::vector<uint8_t>& buffer, float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        for (auto i = 0; i < 4; i++)
+        {
+            buffer.push_back((uint8_t)(bits >> (i * 8)));
+        }
+    }
+
+    static void WriteString(std::vector<uint8_t>& buffer, std::string const& value)
+    {
+        assert(value.size() <= UINT8_MAX);
+        buffer.push_back((uint8_t)value.size());
+        buffer.insert(buffer.end(), value.begin(), value.end());
+    }
+
+    static uint16_t ReadUInt16(uint8_t const* position)
+    {
+        return (uint16_t)(position[0] | (position[1] << 8));
+    }
+
+    static float ReadFloat(uint8_t const* position)
+    {
+        uint32_t bits = position[0] | (position[1] << 8) | (position[2] << 16) | ((uint32_t)position[3] << 24);
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    static bool ReadString(uint8_t const*& position, uint8_t const* end, std::string_view& value)
+    {
+        if (position == end || (size_t)(end - position - 1) < *position)
+        {
+            return false;
+        }
+        value = std::string_view((char const*)position + 1, *position);
+        position += 1 + *position;
+        return true;
+    }
+
+    void GlyphPath::BeginFigure(Point point)
+    {
+        Commands.push_back(PathCommand::BeginFigure);
+        Points.push_back(point);
+    }
+
+    void GlyphPath::AddLine(Point point)
+    {
+        Commands.push_back(PathCommand::AddLine);
+        Points.push_back(point);
+    }
+
+    void GlyphPath::AddQuadraticBezier(Point control, Point end)
+    {
+        Commands.push_back(PathCommand::AddQuadraticBezier);
+        Points.push_back(control);
+        Points.push_back(end);
+    }
+
+    void GlyphPath::AddCubicBezier(Point control1, Point control2, Point end)
+    {
+        Commands.push_back(PathCommand::AddCubicBezier);
+        Points.push_back(control1);
+        Points.push_back(control2);
+        Points.push_back(end);
+    }
+
+    void GlyphPath::EndFigure()
+    {
+        Commands.push_back(PathCommand::EndFigure);
+    }
+
+    void WriteGlyphCache(std::vector<uint8_t>& buffer, GlyphCacheInfo const& info, std::vector<GlyphRun> const& runs)
+    {
+        buffer.insert(buffer.end(), GlyphCacheMagic, GlyphCacheMagic + sizeof(GlyphCacheMagic));
+        buffer.push_back(GlyphCacheVersion);
+        buffer.insert(buffer.end(), GlyphCacheFileHeaderSize - sizeof(GlyphCacheMagic) - 1, 0);
+
+        WriteString(buffer, info.FontFamily);
+        WriteFloat(buffer, info.FontSize);
+        WriteFloat(buffer, info.TextHeight);
+        assert(runs.size() <= UINT16_MAX);
+        WriteUInt16(buffer, (uint16_t)runs.size());
+
+        for (auto& run : runs)
+        {
+            auto& path = run.Path;
+            assert(path.Commands.size() <= UINT16_MAX && path.Points.size() <= UINT16_MAX);
+            WriteString(buffer, run.Text);
+            WriteFloat(buffer, run.Advance);
+            WriteUInt16(buffer, (uint16_t)path.Commands.size());
+            WriteUInt16(buffer, (uint16_t)path.Points.size());
+            for (auto command : path.Commands)
+            {
+                buffer.push_back((uint8_t)command);
+            }
+            for (auto& point : path.Points)
+            {
+                WriteFloat(buffer, point.X);
+                WriteFloat(buffer, point.Y);
+            }
+        }
+    }
+
+    GlyphCacheReader::GlyphCacheReader(uint8_t const* data, size_t size) : m_position(data), m_end(data + size)
+    {
+        if (size < GlyphCacheFileHeaderSize ||
+            !std::equal(GlyphCacheMagic, GlyphCacheMagic + sizeof(GlyphCacheMagic), data) ||
+            data[sizeof(GlyphCacheMagic)] != GlyphCacheVersion)
+        {
+            return;
+        }
+
+        auto position = data + GlyphCacheFileHeaderSize;
+        if (!ReadString(position, m_end, m_fontFamily) || m_end - position < 10)
+        {
+            return;
+        }
+        m_fontSize = ReadFloat(position);
+        m_textHeight = ReadFloat(position + 4);
+        m_runCount = ReadUInt16(position + 8);
+        m_position = position + 10;
+        m_isValid = true;
+    }
+
+    bool GlyphCacheReader::Next(GlyphRunView& run)
+    {
+        if (!m_isValid || m_runsRead == m_runCount)
+        {
+            return false;
+        }
+
+        auto position = m_position;
+        if (!ReadString(position, m_end, run.Text) || m_end - position < 8)
+        {
+            m_isValid = false;
+            return false;
+        }
+        run.Advance = ReadFloat(position);
+        run.CommandCount = ReadUInt16(position + 4);
+        run.PointCount = ReadUInt16(position + 6);
+        position += 8;
+        if ((size_t)(m_end - position) < run.CommandCount + run.PointCount * PointSize)
+        {
+            m_isValid = false;
+            return false;
+        }
+        run.Commands = position;
+        run.Points = position + run.CommandCount;
+
+        m_position = run.Points + run.PointCount * PointSize;
+        m_runsRead++;
+        return true;
+    }
+
+    PathDecoder::PathDecoder(GlyphRunView const& run) :
+        m_command(run.Commands),
+        m_commandEnd(run.Commands + run.CommandCount),
+        m_point(run.Points),
+        m_pointsLeft(run.PointCount)
+    {
+    }
+
+    bool PathDecoder::Next(PathSegment& segment)
+    {
+        if (m_command == m_commandEnd || *m_command > (uint8_t)PathCommand::EndFigure)
+        {
+            return false;
+        }
+
+        auto command = (PathCommand)*m_command;
+        auto count = (size_t)PointCount(command);
+        if (count > m_pointsLeft)
+        {
+            return false;
+        }
+
+        segment.Command = command;
+        for (size_t i = 0; i < count; i++)
+        {
+            segment.Points[i] = { ReadFloat(m_point), ReadFloat(m_point + 4) };
+            m_point += PointSize;
+        }
+        m_pointsLeft -= count;
+        m_command++;
+        return true;
+    }
+
+    bool ReadCardOutlines(GlyphCacheReader& reader, CardOutlines& outlines)
+    {
+        std::string faceTexts[FaceCount];
+        std::string suitTexts[SuitCount];
+        for (auto face = 1; face <= FaceCount; face++)
+        {
+            faceTexts[face - 1] = ToUtf8(Card::FaceText((Face)face));
+        }
+        for (auto suit = 0; suit < SuitCount; suit++)
+        {
+            suitTexts[suit] = ToUtf8(Card::SuitText((Suit)suit));
+        }
+
+        outlines.Faces.assign(FaceCount, {});
+        outlines.FaceAdvances.assign(FaceCount, 0.0f);
+        outlines.Suits.assign(SuitCount, {});
+        outlines.TextHeight = reader.TextHeight();
+        bool isFound[FaceCount + SuitCount] = {};
+        GlyphRunView run;
+        while (reader.Next(run))
+        {
+            GlyphPath* path = nullptr;
+            for (auto i = 0; i < FaceCount && !path; i++)
+            {
+                if (run.Text == faceTexts[i])
+                {
+                    path = &outlines.Faces[i];
+                    outlines.FaceAdvances[i] = run.Advance;
+                    isFound[i] = true;
+                }
+            }
+            for (auto i = 0; i < SuitCount && !path; i++)
+            {
+                if (run.Text == suitTexts[i])
+                {
+                    path = &outlines.Suits[i];
+                    isFound[FaceCount + i] = true;
+                }
+            }
+            if (!path)
+            {
+                continue;
+            }
+
+            PathDecoder decoder(run);
+            PathSegment segment;
+            size_t commandCount = 0;
+            while (decoder.Next(segment))
+            {
+                auto& points = segment.Points;
+                switch (segment.Command)
+                {
+                case PathCommand::BeginFigure:
+                    path->BeginFigure(points[0]);
+                    break;
+                case PathCommand::AddLine:
+                    path->AddLine(points[0]);
+                    break;
+                case PathCommand::AddQuadraticBezier:
+                    path->AddQuadraticBezier(points[0], points[1]);
+                    break;
+                case PathCommand::AddCubicBezier:
+                    path->AddCubicBezier(points[0], points[1], points[2]);
+                    break;
+                case PathCommand::EndFigure:
+                    path->EndFigure();
+                    break;
+                }
+                commandCount++;
+            }
+            if (commandCount != run.CommandCount)
+            {
+                return false;
+            }
+        }
+        return std::all_of(std::begin(isFound), std::end(isFound), [](bool found) { return found; });
+    }
+
+    std::string ToUtf8(std::wstring_view text)
+    {
+        std::string result;
+        for (auto character : text)
+        {
+            auto codePoint = (uint32_t)character;
+            if (codePoint < 0x80)
+            {
+                result += (char)codePoint;
+            }
+            else if (codePoint < 0x800)
+            {
+                result += (char)(0xC0 | (codePoint >> 6));
+                result += (char)(0x80 | (codePoint & 0x3F));
+            }
+            else
+            {
+                result += (char)(0xE0 | (codePoint >> 12));
+                result += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+                result += (char)(0x80 | (codePoint & 0x3F));
+            }
+        }
+        return result;
+    }
+}
\ No newline at end of file
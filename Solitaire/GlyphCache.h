@@ -0,0 +1,177 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Card.h"
+#include "PileLayout.h"
+
+// Outlines of the text on the card faces, laid out ahead of time by
+// SolitaireGlyphs so the app can build its path geometry at launch without
+// creating a device or running text layout.
+//
+// A glyph cache file starts with a GlyphCacheFileHeaderSize byte header
+// ("KGLY", a version byte and three reserved bytes), followed by
+//
+//    1 byte    length of the font family name, then its UTF-8 bytes
+//    4 bytes   the font size
+//    4 bytes   the height of a line of text in that font
+//    2 bytes   number of runs
+//
+// and then each run of text as
+//
+//    1 byte    length of the text, then its UTF-8 bytes
+//    4 bytes   the advance width of the text
+//    2 bytes   number of path commands
+//    2 bytes   number of points
+//   ...        the commands, one byte each
+//   ...        the points, x then y
+//
+// Numbers are little endian, sizes and coordinates are 32-bit floats.
+// Coordinates are in pixels with y pointing down and the top of the line at
+// zero, where CanvasGeometry::CreateText puts the text of a CanvasTextLayout.
+// Paths fill by the nonzero winding rule, as text outlines do.
+//
+// There is a run for each face and each suit on its own rather than one for
+// every card, all set on the same baseline, so a card's text is its face
+// followed by its suit at the face's advance.
+namespace Layout
+{
+    constexpr size_t GlyphCacheFileHeaderSize = 8;
+    constexpr uint8_t GlyphCacheVersion = 2;
+
+    // The font the card faces are set in.
+    constexpr char CardFontFamily[] = "Segoe UI";
+    constexpr float CardFontSize = 36.0f;
+
+    enum class PathCommand : uint8_t
+    {
+        BeginFigure,
+        AddLine,
+        // A control point then the end point.
+        AddQuadraticBezier,
+        // Two control points then the end point.
+        AddCubicBezier,
+        // Closes the figure, takes no points.
+        EndFigure
+    };
+
+    constexpr int PointCount(PathCommand command)
+    {
+        switch (command)
+        {
+        case PathCommand::BeginFigure:
+        case PathCommand::AddLine:
+            return 1;
+        case PathCommand::AddQuadraticBezier:
+            return 2;
+        case PathCommand::AddCubicBezier:
+            return 3;
+        default:
+            return 0;
+        }
+    }
+
+    struct GlyphPath
+    {
+        std::vector<PathCommand> Commands;
+        std::vector<Point> Points;
+
+        void BeginFigure(Point point);
+        void AddLine(Point point);
+        void AddQuadraticBezier(Point control, Point end);
+        void AddCubicBezier(Point control1, Point control2, Point end);
+        void EndFigure();
+    };
+
+    struct GlyphRun
+    {
+        std::string Text;
+        float Advance = 0;
+        GlyphPath Path;
+    };
+
+    struct GlyphCacheInfo
+    {
+        std::string FontFamily;
+        float FontSize = 0;
+        float TextHeight = 0;
+    };
+
+    void WriteGlyphCache(std::vector<uint8_t>& buffer, GlyphCacheInfo const& info, std::vector<GlyphRun> const& runs);
+
+    // A run as stored in the file, pointing into the reader's buffer.
+    struct GlyphRunView
+    {
+        std::string_view Text;
+        float Advance = 0;
+        uint8_t const* Commands = nullptr;
+        size_t CommandCount = 0;
+        uint8_t const* Points = nullptr;
+        size_t PointCount = 0;
+    };
+
+    // Walks the runs in a glyph cache file held in memory.
+    class GlyphCacheReader
+    {
+    public:
+        GlyphCacheReader(uint8_t const* data, size_t size);
+
+        bool IsValid() const { return m_isValid; }
+        std::string_view FontFamily() const { return m_fontFamily; }
+        float FontSize() const { return m_fontSize; }
+        float TextHeight() const { return m_textHeight; }
+        size_t RunCount() const { return m_runCount; }
+        // False once every run has been read or the data turns out to be
+        // malformed.
+        bool Next(GlyphRunView& run);
+
+    private:
+        uint8_t const* m_position;
+        uint8_t const* m_end;
+        std::string_view m_fontFamily;
+        float m_fontSize = 0;
+        float m_textHeight = 0;
+        size_t m_runCount = 0;
+        size_t m_runsRead = 0;
+        bool m_isValid = false;
+    };
+
+    struct PathSegment
+    {
+        PathCommand Command = PathCommand::BeginFigure;
+        Point Points[3];
+    };
+
+    class PathDecoder
+    {
+    public:
+        PathDecoder(GlyphRunView const& run);
+
+        // False at the end of the path or on a command that doesn't decode.
+        bool Next(PathSegment& segment);
+
+    private:
+        uint8_t const* m_command;
+        uint8_t const* m_commandEnd;
+        uint8_t const* m_point;
+        size_t m_pointsLeft;
+    };
+
+    // The outlines of every face and suit, indexed by face - 1 and suit.
+    struct CardOutlines
+    {
+        std::vector<GlyphPath> Faces;
+        std::vector<float> FaceAdvances;
+        std::vector<GlyphPath> Suits;
+        float TextHeight = 0;
+    };
+
+    // False if the cache is malformed or is missing a face or suit.
+    bool ReadCardOutlines(GlyphCacheReader& reader, CardOutlines& outlines);
+
+    // Only as much UTF-8 as the text on the cards needs, nothing past the
+    // basic multilingual plane.
+    std::string ToUtf8(std::wstring_view text);
+}
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include "HitTestIndex.h"
+
+namespace Layout
+{
+    void HitTestIndex::Clear()
+    {
+        m_rects.clear();
+        m_cellStarts.clear();
+        m_cellRects.clear();
+        m_bounds = {};
+        m_columns = 0;
+        m_rows = 0;
+    }
+
+    void HitTestIndex::Add(Rect const& rect, int pile, int card)
+    {
+        assert(m_rects.size() < UINT16_MAX);
+        m_rects.push_back({ rect, (int16_t)pile, (int16_t)card });
+    }
+
+    int HitTestIndex::CellColumn(float x) const
+    {
+        return std::min(m_columns - 1, std::max(0, (int)((x - m_bounds.X) * m_inverseCellSize)));
+    }
+
+    int HitTestIndex::CellRow(float y) const
+    {
+        return std::min(m_rows - 1, std::max(0, (int)((y - m_bounds.Y) * m_inverseCellSize)));
+    }
+
+    void HitTestIndex::Build(float cellSize)
+    {
+        m_cellStarts.clear();
+        m_cellRects.clear();
+        if (m_rects.empty())
+        {
+            m_bounds = {};
+            m_columns = 0;
+            m_rows = 0;
+            return;
+        }
+
+        auto left = m_rects.front().Bounds.X;
+        auto top = m_rects.front().Bounds.Y;
+        auto right = left;
+        auto bottom = top;
+        for (auto& entry : m_rects)
+        {
+            left = std::min(left, entry.Bounds.X);
+            top = std::min(top, entry.Bounds.Y);
+            right = std::max(right, entry.Bounds.X + entry.Bounds.Width);
+            bottom = std::max(bottom, entry.Bounds.Y + entry.Bounds.Height);
+        }
+        m_bounds = { left, top, right - left, bottom - top };
+        m_inverseCellSize = 1.0f / cellSize;
+        m_columns = std::max(1, (int)std::ceil(m_bounds.Width * m_inverseCellSize));
+        m_rows = std::max(1, (int)std::ceil(m_bounds.Height * m_inverseCellSize));
+
+        // Count, then fill back to front so the last rect added, the topmost,
+        // comes first in every cell.
+        auto cellCount = m_columns * m_rows;
+        m_cellStarts.assign(cellCount + 1, 0);
+        auto forEachCell = [&](Rect const& rect, auto&& action)
+        {
+            auto lastColumn = CellColumn(rect.X + rect.Width);
+            auto lastRow = CellRow(rect.Y + rect.Height);
+            for (auto row = CellRow(rect.Y); row <= lastRow; row++)
+            {
+                for (auto column = CellColumn(rect.X); column <= lastColumn; column++)
+                {
+                    action(row * m_columns + column);
+                }
+            }
+        };
+        for (auto& entry : m_rects)
+        {
+            forEachCell(entry.Bounds, [&](int cell) { m_cellStarts[cell + 1]++; });
+        }
+        for (auto cell = 0; cell < cellCount; cell++)
+        {
+            m_cellStarts[cell + 1] += m_cellStarts[cell];
+        }
+
+        m_cellRects.resize(m_cellStarts.back());
+        std::vector<uint32_t> next(m_cellStarts.begin(), m_cellStarts.end() - 1);
+        for (auto i = (int)m_rects.size() - 1; i >= 0; i--)
+        {
+            forEachCell(m_rects[i].Bounds, [&](int cell) { m_cellRects[next[cell]++] = (uint16_t)i; });
+        }
+    }
+
+    HitTestIndex::Hit HitTestIndex::Find(Point point) const
+    {
+        if (m_cellStarts.empty() || !m_bounds.Contains(point))
+        {
+            return {};
+        }
+
+        auto cell = CellRow(point.Y) * m_columns + CellColumn(point.X);
+        for (auto i = m_cellStarts[cell]; i < m_cellStarts[cell + 1]; i++)
+        {
+            auto& entry = m_rects[m_cellRects[i]];
+            if (entry.Bounds.Contains(point))
+            {
+                return { entry.Pile, entry.Card };
+            }
+        }
+        return {};
+    }
+}
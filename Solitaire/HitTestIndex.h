@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "PileLayout.h"
+
+namespace Layout
+{
+    struct Rect
+    {
+        float X = 0;
+        float Y = 0;
+        float Width = 0;
+        float Height = 0;
+
+        constexpr bool Contains(Point point) const
+        {
+            return point.X >= X &&
+                point.X < X + Width &&
+                point.Y >= Y &&
+                point.Y < Y + Height;
+        }
+    };
+
+    // Answers "which pile and card is under this point" for the whole board.
+    //
+    // Every pile base and card is added as a rect, bottom to top. Build then
+    // buckets them into a uniform grid, each cell listing the rects that
+    // overlap it topmost first. A lookup is a single cell plus a few rect
+    // checks, bounded by how many cards can overlap one cell, no matter how
+    // many cards are on the board. Rebuild it whenever the layout or the
+    // contents of a pile change.
+    class HitTestIndex
+    {
+    public:
+        // The card index reported for a pile's base.
+        static constexpr int Base = -1;
+        static constexpr float DefaultCellSize = 64.0f;
+
+        struct Hit
+        {
+            int Pile = -1;
+            int Card = Base;
+
+            bool IsHit() const { return Pile >= 0; }
+        };
+
+        void Clear();
+        void Add(Rect const& rect, int pile, int card);
+        void Build(float cellSize = DefaultCellSize);
+
+        Hit Find(Point point) const;
+
+        size_t RectCount() const { return m_rects.size(); }
+        size_t CellCount() const { return m_cellStarts.empty() ? 0 : m_cellStarts.size() - 1; }
+
+    private:
+        struct Entry
+        {
+            Rect Bounds;
+            int16_t Pile;
+            int16_t Card;
+        };
+
+        int CellColumn(float x) const;
+        int CellRow(float y) const;
+
+        std::vector<Entry> m_rects;
+        Rect m_bounds;
+        float m_inverseCellSize = 0;
+        int m_columns = 0;
+        int m_rows = 0;
+        // Rects for cell i are m_cellRects[m_cellStarts[i], m_cellStarts[i + 1]).
+        std::vector<uint32_t> m_cellStarts;
+        std::vector<uint16_t> m_cellRects;
+    };
+}
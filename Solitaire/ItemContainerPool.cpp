@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <cassert>
+#include "PileLayout.h"
+#include "ItemContainerPool.h"
+
+ItemContainerPool::ItemContainerPool(std::shared_ptr<Compositing::Compositor> const& compositor, size_t capacity)
+{
+    m_compositor = compositor;
+    m_capacity = capacity;
+    m_free.reserve(m_capacity);
+}
+
+Pile::ItemContainer ItemContainerPool::Create()
+{
+    auto root = m_compositor->CreateContainerVisual();
+    root->Size({ Layout::CardWidth, Layout::CardHeight });
+    root->Comment(L"Item Container Root");
+    auto content = m_compositor->CreateContainerVisual();
+    content->RelativeSizeAdjustment({ 1, 1 });
+    content->Comment(L"Item Container Content");
+    root->InsertAtTop(content);
+    return { root, content };
+}
+
+Pile::ItemContainer ItemContainerPool::Acquire()
+{
+    Pile::ItemContainer container;
+    if (m_free.empty())
+    {
+        container = Create();
+        m_stats.Created++;
+    }
+    else
+    {
+        container = std::move(m_free.back());
+        m_free.pop_back();
+        m_stats.Reused++;
+    }
+
+    m_stats.InUse++;
+    m_stats.HighWater = std::max(m_stats.HighWater, m_stats.InUse);
+    m_stats.Free = m_free.size();
+    return container;
+}
+
+Pile::ItemContainerList ItemContainerPool::Acquire(size_t count)
+{
+    Pile::ItemContainerList result(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        result[i] = Acquire();
+        if (i > 0)
+        {
+            auto& previousContainer = result[i - 1];
+            previousContainer.Root->InsertAbove(result[i].Root, previousContainer.Content);
+        }
+    }
+    return result;
+}
+
+void ItemContainerPool::Reset(Pile::ItemContainer const& container)
+{
+    auto& root = container.Root;
+    if (auto parent = root->Parent())
+    {
+        parent->Remove(root);
+    }
+    if (!container.Content->Children().empty())
+    {
+        container.Content->RemoveAll();
+    }
+    // Whatever sits above the content belongs to someone else now.
+    while (root->Children().back() != container.Content)
+    {
+        root->Remove(root->Children().back());
+    }
+
+    auto offset = root->Offset();
+    if (offset.X != 0 || offset.Y != 0 || offset.Z != 0)
+    {
+        root->Offset({ 0, 0, 0 });
+    }
+    if (root->ParentForTransform())
+    {
+        root->ParentForTransform(nullptr);
+    }
+}
+
+void ItemContainerPool::Release(Pile::ItemContainer const& container)
+{
+    assert(m_stats.InUse > 0);
+    m_stats.InUse--;
+    // Dropped containers are reset too, a card may still be nested inside.
+    Reset(container);
+    if (m_free.size() < m_capacity)
+    {
+        m_free.push_back(container);
+    }
+    else
+    {
+        m_stats.Discarded++;
+    }
+    m_stats.Free = m_free.size();
+}
+
+void ItemContainerPool::Release(Pile::ItemContainerList const& containers)
+{
+    for (auto& container : containers)
+    {
+        Release(container);
+    }
+}
+
+void ItemContainerPool::Reserve(size_t count)
+{
+    count = std::min(count, m_capacity);
+    while (m_free.size() < count)
+    {
+        m_free.push_back(Create());
+        m_stats.Created++;
+    }
+    m_stats.Free = m_free.size();
+}
\ No newline at end of file
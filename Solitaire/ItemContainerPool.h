@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "Compositing.h"
+#include "Pile.h"
+
+// Recycles the pair of visuals behind each Pile::ItemContainer. Piles acquire
+// containers when cards arrive or get picked up and release them once they
+// are empty, so after the first few moves play creates no new visuals.
+//
+// A released container is reset: it's taken out of the tree, its content is
+// emptied and anything nested above it is detached, and its offset and
+// transform parent are cleared. Only up to Capacity free containers are kept,
+// anything released beyond that is dropped.
+class ItemContainerPool
+{
+public:
+    // Room for every card on the board twice over, the containers a pile
+    // holds on to plus the ones carrying a dragged run.
+    static constexpr size_t DefaultCapacity = 104;
+
+    struct Statistics
+    {
+        // Containers built because the pool had none free.
+        size_t Created = 0;
+        // Acquires served from the free list.
+        size_t Reused = 0;
+        // Releases dropped because the free list was full.
+        size_t Discarded = 0;
+        size_t InUse = 0;
+        size_t HighWater = 0;
+        size_t Free = 0;
+    };
+
+    ItemContainerPool(std::shared_ptr<Compositing::Compositor> const& compositor, size_t capacity = DefaultCapacity);
+
+    Pile::ItemContainer Acquire();
+    // Each container after the first is nested above the content of the one
+    // before it, the way a pile stacks them.
+    Pile::ItemContainerList Acquire(size_t count);
+    void Release(Pile::ItemContainer const& container);
+    void Release(Pile::ItemContainerList const& containers);
+
+    // Fills the free list up front so the first game doesn't pay for it.
+    void Reserve(size_t count);
+
+    size_t Capacity() const { return m_capacity; }
+    Statistics const& Stats() const { return m_stats; }
+
+private:
+    Pile::ItemContainer Create();
+    void Reset(Pile::ItemContainer const& container);
+
+private:
+    std::shared_ptr<Compositing::Compositor> m_compositor;
+    std::vector<Pile::ItemContainer> m_free;
+    size_t m_capacity;
+    Statistics m_stats;
+};
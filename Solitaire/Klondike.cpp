@@ -0,0 +1,531 @@
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include "Klondike.h"
+
+namespace Klondike
+{
+    // Random keys for every piece of a position. The entries for empty
+    // foundations and an empty waste are zero, so an empty state has a key of
+    // zero.
+    //
+    // A column card is keyed by the card it sits on, or none at the bottom,
+    // and whether it's face up, not by its column. The cards each one sits on
+    // are enough to put the columns back together, just not in order, so
+    // positions that only differ in the order of the columns share a key.
+    struct ZobristKeys
+    {
+        uint64_t ColumnCards[53][52][2];
+        uint64_t FoundationSizes[FoundationCount][CardsPerSuit + 1];
+        uint64_t TalonCards[TalonCapacity][52];
+        uint64_t WasteSizes[TalonCapacity + 1];
+    };
+
+    // The keys come from a fixed seed so that keys match across processes
+    // and machines.
+    static ZobristKeys MakeZobristKeys()
+    {
+        uint64_t seed = 0x4b6c6f6e64696b65ull;
+        auto next = [&seed]()
+        {
+            // splitmix64
+            uint64_t z = (seed += 0x9e3779b97f4a7c15ull);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            return z ^ (z >> 31);
+        };
+
+        ZobristKeys keys;
+        for (auto& below : keys.ColumnCards)
+        {
+            for (auto& card : below)
+            {
+                for (auto& key : card)
+                {
+                    key = next();
+                }
+            }
+        }
+        for (auto& suit : keys.FoundationSizes)
+        {
+            for (auto& key : suit)
+            {
+                key = next();
+            }
+            suit[0] = 0;
+        }
+        for (auto& position : keys.TalonCards)
+        {
+            for (auto& key : position)
+            {
+                key = next();
+            }
+        }
+        for (auto& key : keys.WasteSizes)
+        {
+            key = next();
+        }
+        keys.WasteSizes[0] = 0;
+        return keys;
+    }
+
+    static const ZobristKeys s_keys = MakeZobristKeys();
+
+    bool CanPickUpFromColumn(int index, int size, bool isFaceUp)
+    {
+        return index >= 0 && index < size && isFaceUp;
+    }
+
+    bool CanPickUpFromFoundation(int index, int size)
+    {
+        return size > 0 && index == size - 1;
+    }
+
+    bool CanTakeFromWaste(int index, int size)
+    {
+        // Only the top of the waste is in play, the rest are buried under it.
+        return size > 0 && index == size - 1;
+    }
+
+    State::State()
+    {
+        std::memset(m_columnSizes, 0, sizeof(m_columnSizes));
+        std::memset(m_hiddenCounts, 0, sizeof(m_hiddenCounts));
+        std::memset(m_foundationSizes, 0, sizeof(m_foundationSizes));
+        std::memset(m_foundationSuits, 0, sizeof(m_foundationSuits));
+        m_talonSize = 0;
+        m_wasteSize = 0;
+        m_key = 0;
+    }
+
+    void State::SetColumn(int column, Card const* cards, int count, int hiddenCount)
+    {
+        assert(count <= MaxColumnCards);
+        assert(hiddenCount < count || count == 0);
+        std::copy(cards, cards + count, m_columns[column]);
+        m_columnSizes[column] = (uint8_t)count;
+        m_hiddenCounts[column] = (uint8_t)hiddenCount;
+        m_key = ComputeKey();
+    }
+
+    // The cards are given in stock order, the next card to draw first.
+    void State::SetTalon(Card const* cards, int count)
+    {
+        assert(count <= TalonCapacity);
+        std::copy(cards, cards + count, m_talon);
+        m_talonSize = (uint8_t)count;
+        m_wasteSize = 0;
+        m_key = ComputeKey();
+    }
+
+    Card State::FoundationTop(int foundation) const
+    {
+        assert(m_foundationSizes[foundation] > 0);
+        return Card((Face)m_foundationSizes[foundation], (Suit)m_foundationSuits[foundation]);
+    }
+
+    bool State::CanSplit(int column, int index) const
+    {
+        return CanPickUpFromColumn(index, m_columnSizes[column], index >= m_hiddenCounts[column]);
+    }
+
+    bool State::CanAddToColumn(int column, Card card) const
+    {
+        auto size = m_columnSizes[column];
+        if (size == 0)
+        {
+            return CanStartColumn(card);
+        }
+
+        // The top of a non-empty column is always face up.
+        return CanStackOn(card, m_columns[column][size - 1]);
+    }
+
+    bool State::CanAddToFoundation(int foundation, Card card) const
+    {
+        if (m_foundationSizes[foundation] == 0)
+        {
+            return CanStartFoundation(card);
+        }
+
+        return CanFoundOn(card, FoundationTop(foundation));
+    }
+
+    bool State::IsLegal(Move const& move) const
+    {
+        if (move.From >= LocationCount || move.To >= LocationCount || move.From == move.To)
+        {
+            return false;
+        }
+
+        if (IsStockPlay(move))
+        {
+            if (!CanReachWasteSize(move.Count))
+            {
+                return false;
+            }
+            auto card = m_talon[move.Count - 1];
+            return IsColumn(move.To) ?
+                CanAddToColumn(move.To - FirstColumn, card) :
+                CanAddToFoundation(move.To - FirstFoundation, card);
+        }
+
+        if (move.From == StockLocation)
+        {
+            return move.To == WasteLocation && StockSize() > 0;
+        }
+
+        if (move.To == StockLocation)
+        {
+            return move.From == WasteLocation && StockSize() == 0 && m_wasteSize > 0;
+        }
+
+        if (move.To == WasteLocation)
+        {
+            return false;
+        }
+
+        // Find the card at the bottom of the run being moved.
+        Card card;
+        if (IsColumn(move.From))
+        {
+            auto column = move.From - FirstColumn;
+            auto size = m_columnSizes[column];
+            if (move.Count < 1 || move.Count > size || !CanSplit(column, size - move.Count))
+            {
+                return false;
+            }
+            card = m_columns[column][size - move.Count];
+        }
+        else if (IsFoundation(move.From))
+        {
+            auto foundation = move.From - FirstFoundation;
+            if (move.Count != 1 || m_foundationSizes[foundation] == 0)
+            {
+                return false;
+            }
+            card = FoundationTop(foundation);
+        }
+        else
+        {
+            if (move.Count != 1 || !CanTakeFromWaste(m_wasteSize - 1, m_wasteSize))
+            {
+                return false;
+            }
+            card = m_talon[m_wasteSize - 1];
+        }
+
+        if (IsColumn(move.To))
+        {
+            return CanAddToColumn(move.To - FirstColumn, card);
+        }
+
+        return move.Count == 1 && CanAddToFoundation(move.To - FirstFoundation, card);
+    }
+
+    // Draws deal the rest of the stock out three at a time, and after a
+    // recycle the next pass does the same from the start of the talon.
+    bool State::CanReachWasteSize(int wasteSize) const
+    {
+        if (wasteSize < 1 || wasteSize > m_talonSize || wasteSize == m_wasteSize)
+        {
+            return false;
+        }
+        if (wasteSize == m_talonSize || wasteSize % CardsPerDraw == 0)
+        {
+            return true;
+        }
+        return wasteSize > m_wasteSize && (wasteSize - m_wasteSize) % CardsPerDraw == 0;
+    }
+
+    Move State::Apply(Move move)
+    {
+        assert(IsLegal(move));
+        move.Flags = MoveFlags::None;
+
+        if (IsStockPlay(move))
+        {
+            move.Flags = (uint8_t)(m_wasteSize << StartWasteSizeShift);
+            SetWasteSize(move.Count);
+            Card card;
+            uint8_t flags = MoveFlags::None;
+            RemoveCards(WasteLocation, 1, &card, flags);
+            AddCards(move.To, &card, 1);
+            return move;
+        }
+
+        if (move.From == StockLocation)
+        {
+            auto count = std::min(CardsPerDraw, StockSize());
+            SetWasteSize(m_wasteSize + count);
+            move.Count = (uint8_t)count;
+            return move;
+        }
+
+        if (move.To == StockLocation)
+        {
+            move.Count = m_wasteSize;
+            SetWasteSize(0);
+            return move;
+        }
+
+        Card cards[MaxColumnCards];
+        auto count = RemoveCards(move.From, move.Count, cards, move.Flags);
+        AddCards(move.To, cards, count);
+        return move;
+    }
+
+    void State::Revert(Move const& move)
+    {
+        if (IsStockPlay(move))
+        {
+            Card card;
+            uint8_t flags = MoveFlags::None;
+            RemoveCards(move.To, 1, &card, flags);
+            AddCards(WasteLocation, &card, 1);
+            SetWasteSize(move.Flags >> StartWasteSizeShift);
+            return;
+        }
+
+        if (move.From == StockLocation)
+        {
+            SetWasteSize(m_wasteSize - move.Count);
+            return;
+        }
+
+        if (move.To == StockLocation)
+        {
+            SetWasteSize(move.Count);
+            return;
+        }
+
+        Card cards[MaxColumnCards];
+        uint8_t flags = MoveFlags::None;
+        auto count = RemoveCards(move.To, move.Count, cards, flags);
+        if (move.Flags & MoveFlags::RevealsCard)
+        {
+            auto column = move.From - FirstColumn;
+            SetHiddenCount(column, m_hiddenCounts[column] + 1);
+        }
+        AddCards(move.From, cards, count);
+    }
+
+    bool State::IsWon() const
+    {
+        for (auto size : m_foundationSizes)
+        {
+            if (size != CardsPerSuit)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    uint64_t State::ComputeKey() const
+    {
+        uint64_t key = 0;
+        for (auto column = 0; column < ColumnCount; column++)
+        {
+            for (auto i = 0; i < m_columnSizes[column]; i++)
+            {
+                key ^= ColumnCardKey(column, i);
+            }
+        }
+
+        uint8_t suitSizes[FoundationCount];
+        SuitSizes(suitSizes);
+        for (auto suit = 0; suit < FoundationCount; suit++)
+        {
+            key ^= s_keys.FoundationSizes[suit][suitSizes[suit]];
+        }
+
+        key ^= s_keys.WasteSizes[m_wasteSize];
+        for (auto i = 0; i < m_talonSize; i++)
+        {
+            key ^= s_keys.TalonCards[i][m_talon[i].Index()];
+        }
+        return key;
+    }
+
+    bool State::operator==(State const& other) const
+    {
+        if (m_key != other.m_key)
+        {
+            return false;
+        }
+
+        // Keys can collide, so confirm it with the contents. Columns can be
+        // in any order, but no two have the same bottom card.
+        for (auto column = 0; column < ColumnCount; column++)
+        {
+            auto size = m_columnSizes[column];
+            if (size == 0)
+            {
+                continue;
+            }
+
+            auto match = 0;
+            while (match < ColumnCount && (other.m_columnSizes[match] == 0 || other.m_columns[match][0] != m_columns[column][0]))
+            {
+                match++;
+            }
+            if (match == ColumnCount ||
+                other.m_columnSizes[match] != size ||
+                other.m_hiddenCounts[match] != m_hiddenCounts[column] ||
+                !std::equal(m_columns[column], m_columns[column] + size, other.m_columns[match]))
+            {
+                return false;
+            }
+        }
+        auto emptyColumns = std::count(m_columnSizes, m_columnSizes + ColumnCount, 0);
+        if (std::count(other.m_columnSizes, other.m_columnSizes + ColumnCount, 0) != emptyColumns)
+        {
+            return false;
+        }
+
+        uint8_t suitSizes[FoundationCount];
+        uint8_t otherSuitSizes[FoundationCount];
+        SuitSizes(suitSizes);
+        other.SuitSizes(otherSuitSizes);
+        if (!std::equal(suitSizes, suitSizes + FoundationCount, otherSuitSizes))
+        {
+            return false;
+        }
+
+        return m_wasteSize == other.m_wasteSize &&
+            m_talonSize == other.m_talonSize &&
+            std::equal(m_talon, m_talon + m_talonSize, other.m_talon);
+    }
+
+    int State::RemoveCards(Location location, int count, Card* cards, uint8_t& flags)
+    {
+        if (IsColumn(location))
+        {
+            auto column = location - FirstColumn;
+            auto newSize = m_columnSizes[column] - count;
+            for (auto i = newSize; i < m_columnSizes[column]; i++)
+            {
+                m_key ^= ColumnCardKey(column, i);
+                cards[i - newSize] = m_columns[column][i];
+            }
+            m_columnSizes[column] = (uint8_t)newSize;
+            if (newSize > 0 && newSize == m_hiddenCounts[column])
+            {
+                SetHiddenCount(column, newSize - 1);
+                flags |= MoveFlags::RevealsCard;
+            }
+            return count;
+        }
+
+        if (IsFoundation(location))
+        {
+            auto foundation = location - FirstFoundation;
+            auto size = m_foundationSizes[foundation];
+            auto& suitKeys = s_keys.FoundationSizes[m_foundationSuits[foundation]];
+            cards[0] = FoundationTop(foundation);
+            m_key ^= suitKeys[size] ^ suitKeys[size - 1];
+            m_foundationSizes[foundation]--;
+            return 1;
+        }
+
+        // Pull the top of the waste out of the talon and close the gap. Every
+        // card in the stock moves down a position.
+        assert(location == WasteLocation && m_wasteSize > 0);
+        cards[0] = m_talon[m_wasteSize - 1];
+        m_key ^= s_keys.TalonCards[m_wasteSize - 1][cards[0].Index()];
+        for (auto i = m_wasteSize; i < m_talonSize; i++)
+        {
+            auto card = m_talon[i];
+            m_key ^= s_keys.TalonCards[i][card.Index()] ^ s_keys.TalonCards[i - 1][card.Index()];
+            m_talon[i - 1] = card;
+        }
+        SetWasteSize(m_wasteSize - 1);
+        m_talonSize--;
+        return 1;
+    }
+
+    void State::AddCards(Location location, Card const* cards, int count)
+    {
+        if (IsColumn(location))
+        {
+            auto column = location - FirstColumn;
+            auto size = m_columnSizes[column];
+            for (auto i = 0; i < count; i++)
+            {
+                m_columns[column][size + i] = cards[i];
+                m_key ^= ColumnCardKey(column, size + i);
+            }
+            m_columnSizes[column] += (uint8_t)count;
+            return;
+        }
+
+        if (IsFoundation(location))
+        {
+            auto foundation = location - FirstFoundation;
+            auto size = m_foundationSizes[foundation];
+            if (size == 0)
+            {
+                m_foundationSuits[foundation] = (uint8_t)cards[0].Suit();
+            }
+            auto& suitKeys = s_keys.FoundationSizes[m_foundationSuits[foundation]];
+            m_key ^= suitKeys[size] ^ suitKeys[size + 1];
+            m_foundationSizes[foundation]++;
+            return;
+        }
+
+        assert(location == WasteLocation && count == 1);
+        for (auto i = m_talonSize; i > m_wasteSize; i--)
+        {
+            auto card = m_talon[i - 1];
+            m_key ^= s_keys.TalonCards[i - 1][card.Index()] ^ s_keys.TalonCards[i][card.Index()];
+            m_talon[i] = card;
+        }
+        m_talon[m_wasteSize] = cards[0];
+        m_key ^= s_keys.TalonCards[m_wasteSize][cards[0].Index()];
+        m_talonSize++;
+        SetWasteSize(m_wasteSize + 1);
+    }
+
+    // The cards between the old and new counts turn over.
+    void State::SetHiddenCount(int column, int hiddenCount)
+    {
+        auto first = std::min((int)m_hiddenCounts[column], hiddenCount);
+        auto last = std::max((int)m_hiddenCounts[column], hiddenCount);
+        for (auto i = first; i < last; i++)
+        {
+            m_key ^= ColumnCardKey(column, i);
+        }
+        m_hiddenCounts[column] = (uint8_t)hiddenCount;
+        for (auto i = first; i < last; i++)
+        {
+            m_key ^= ColumnCardKey(column, i);
+        }
+    }
+
+    uint64_t State::ColumnCardKey(int column, int index) const
+    {
+        auto below = index == 0 ? 0 : m_columns[column][index - 1].Index() + 1;
+        auto isFaceUp = index >= m_hiddenCounts[column] ? 1 : 0;
+        return s_keys.ColumnCards[below][m_columns[column][index].Index()][isFaceUp];
+    }
+
+    void State::SetWasteSize(int wasteSize)
+    {
+        m_key ^= s_keys.WasteSizes[m_wasteSize] ^ s_keys.WasteSizes[wasteSize];
+        m_wasteSize = (uint8_t)wasteSize;
+    }
+
+    // Sizes of the foundations by suit rather than by slot.
+    void State::SuitSizes(uint8_t sizes[FoundationCount]) const
+    {
+        std::fill(sizes, sizes + FoundationCount, (uint8_t)0);
+        for (auto foundation = 0; foundation < FoundationCount; foundation++)
+        {
+            if (m_foundationSizes[foundation] > 0)
+            {
+                sizes[m_foundationSuits[foundation]] = m_foundationSizes[foundation];
+            }
+        }
+    }
+}
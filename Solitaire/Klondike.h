@@ -0,0 +1,180 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <type_traits>
+#include "Card.h"
+
+// Headless Klondike rules engine. Nothing in here depends on WinRT so the
+// same rules can drive the composition piles and offline analysis tools.
+namespace Klondike
+{
+    constexpr int ColumnCount = 7;
+    constexpr int FoundationCount = 4;
+    constexpr int CardsPerSuit = 13;
+    constexpr int MaxHiddenCards = ColumnCount - 1;
+    constexpr int MaxColumnCards = MaxHiddenCards + CardsPerSuit;
+    constexpr int DealtCards = ColumnCount * (ColumnCount + 1) / 2;
+    constexpr int TalonCapacity = 52 - DealtCards;
+    constexpr int CardsPerDraw = 3;
+
+    // Compatibility tables, indexed by Card::Index. Bit j of StackTargets[i]
+    // is set when card i can be stacked on card j in a column, which is one of
+    // the two cards one face higher in the other colour. FoundationTargets
+    // works the same way for the card of the same suit one face lower.
+    constexpr uint64_t StackTargetsOf(int index)
+    {
+        auto face = index / 4 + 1;
+        if (face == (int)Face::King)
+        {
+            return 0;
+        }
+        // Red suits are even, so the other colour has the other parity.
+        auto firstTarget = face * 4 + (index + 1) % 2;
+        return (1ull << firstTarget) | (1ull << (firstTarget + 2));
+    }
+
+    constexpr uint64_t FoundationTargetsOf(int index)
+    {
+        return index < 4 ? 0 : 1ull << (index - 4);
+    }
+
+    constexpr std::array<uint64_t, 52> MakeTargetTable(uint64_t (*targetsOf)(int))
+    {
+        std::array<uint64_t, 52> table = {};
+        for (auto i = 0; i < 52; i++)
+        {
+            table[i] = targetsOf(i);
+        }
+        return table;
+    }
+
+    constexpr std::array<uint64_t, 52> StackTargets = MakeTargetTable(StackTargetsOf);
+    constexpr std::array<uint64_t, 52> FoundationTargets = MakeTargetTable(FoundationTargetsOf);
+
+    // Rules shared by the engine and the composition piles.
+    constexpr bool CanStackOn(Card card, Card target) { return (StackTargets[card.Index()] >> target.Index()) & 1; }
+    constexpr bool CanStartColumn(Card card) { return card.Face() == Face::King; }
+    constexpr bool CanFoundOn(Card card, Card target) { return (FoundationTargets[card.Index()] >> target.Index()) & 1; }
+    constexpr bool CanStartFoundation(Card card) { return card.Face() == Face::Ace; }
+    bool CanPickUpFromColumn(int index, int size, bool isFaceUp);
+    bool CanPickUpFromFoundation(int index, int size);
+    bool CanTakeFromWaste(int index, int size);
+
+    // Every place a card can live. Columns come first, then foundations,
+    // then the waste and the stock.
+    using Location = uint8_t;
+    constexpr Location FirstColumn = 0;
+    constexpr Location FirstFoundation = FirstColumn + ColumnCount;
+    constexpr Location WasteLocation = FirstFoundation + FoundationCount;
+    constexpr Location StockLocation = WasteLocation + 1;
+    constexpr Location LocationCount = StockLocation + 1;
+
+    constexpr bool IsColumn(Location location) { return location < FirstFoundation; }
+    constexpr bool IsFoundation(Location location) { return location >= FirstFoundation && location < WasteLocation; }
+    constexpr Location ColumnLocation(int column) { return (Location)(FirstColumn + column); }
+    constexpr Location FoundationLocation(int foundation) { return (Location)(FirstFoundation + foundation); }
+
+    enum MoveFlags : uint8_t
+    {
+        None = 0,
+        // Moving the cards turned over the last hidden card of the source column.
+        RevealsCard = 1
+    };
+
+    // A stock play keeps the waste size it started from in the flags above
+    // RevealsCard, for Revert.
+    constexpr int StartWasteSizeShift = 1;
+
+    // A draw is Stock -> Waste and a recycle is Waste -> Stock. Count holds the
+    // number of cards that actually moved so the move can be reverted.
+    //
+    // A stock play is Stock to a column or foundation: it draws and recycles
+    // until the waste holds Count cards, then plays the top one. Only the
+    // solvers make them, which saves a node for every draw along the way.
+    struct Move
+    {
+        Location From = StockLocation;
+        Location To = WasteLocation;
+        uint8_t Count = 0;
+        uint8_t Flags = MoveFlags::None;
+
+        bool operator==(Move const& other) const { return From == other.From && To == other.To && Count == other.Count; }
+        bool operator!=(Move const& other) const { return !(*this == other); }
+    };
+
+    static_assert(sizeof(Move) == 4, "Moves are expected to pack into four bytes");
+
+    constexpr bool IsStockPlay(Move const& move) { return move.From == StockLocation && move.To != WasteLocation; }
+
+    // The whole game as fixed size arrays, so copying a position is a memcpy.
+    //
+    // The stock and waste share the talon array. Cards [0, WasteSize) are the
+    // waste with its top card last, the rest are the stock with the next card
+    // to be drawn first. Drawing and recycling only move the split point.
+    class State
+    {
+    public:
+        State();
+
+        void SetColumn(int column, Card const* cards, int count, int hiddenCount);
+        void SetTalon(Card const* cards, int count);
+
+        int ColumnSize(int column) const { return m_columnSizes[column]; }
+        int HiddenCount(int column) const { return m_hiddenCounts[column]; }
+        Card ColumnCard(int column, int index) const { return m_columns[column][index]; }
+
+        int FoundationSize(int foundation) const { return m_foundationSizes[foundation]; }
+        Card FoundationTop(int foundation) const;
+
+        int StockSize() const { return m_talonSize - m_wasteSize; }
+        int WasteSize() const { return m_wasteSize; }
+        Card WasteCard(int index) const { return m_talon[index]; }
+        Card StockCard(int index) const { return m_talon[m_wasteSize + index]; }
+        // The waste then the stock, in the order they're drawn.
+        Card TalonCard(int index) const { return m_talon[index]; }
+        // Whether drawing and recycling can leave this many cards in the
+        // waste, other than the number there now.
+        bool CanReachWasteSize(int wasteSize) const;
+
+        bool CanSplit(int column, int index) const;
+        bool CanAddToColumn(int column, Card card) const;
+        bool CanAddToFoundation(int foundation, Card card) const;
+
+        bool IsLegal(Move const& move) const;
+        // Returns the move with its Count and Flags filled in, ready to revert.
+        Move Apply(Move move);
+        void Revert(Move const& move);
+
+        bool IsWon() const;
+
+        // Zobrist hash of the position, kept up to date by every change to the
+        // state. Positions that only differ in which foundation slot holds a
+        // suit, or in the order of the columns, share a key and compare
+        // equal. Either way the same moves are open, just from other places.
+        uint64_t Key() const { return m_key; }
+        uint64_t ComputeKey() const;
+        bool operator==(State const& other) const;
+        bool operator!=(State const& other) const { return !(*this == other); }
+
+    private:
+        int RemoveCards(Location location, int count, Card* cards, uint8_t& flags);
+        void AddCards(Location location, Card const* cards, int count);
+        void SetHiddenCount(int column, int hiddenCount);
+        uint64_t ColumnCardKey(int column, int index) const;
+        void SetWasteSize(int wasteSize);
+        void SuitSizes(uint8_t sizes[FoundationCount]) const;
+
+    private:
+        uint64_t m_key;
+        Card m_columns[ColumnCount][MaxColumnCards];
+        uint8_t m_columnSizes[ColumnCount];
+        uint8_t m_hiddenCounts[ColumnCount];
+        uint8_t m_foundationSizes[FoundationCount];
+        uint8_t m_foundationSuits[FoundationCount];
+        Card m_talon[TalonCapacity];
+        uint8_t m_talonSize;
+        uint8_t m_wasteSize;
+    };
+
+    static_assert(std::is_trivially_copyable<State>::value, "States are expected to be copyable with memcpy");
+}
@@ -0,0 +1,122 @@
+#include "MappedFile.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+bool MappedFile::Open(char const* path)
+{
+    Close();
+    m_file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE)
+    {
+        m_file = nullptr;
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_file, &size))
+    {
+        Close();
+        return false;
+    }
+    m_size = (size_t)size.QuadPart;
+    // Empty files can't be mapped, but they are still valid to open.
+    if (m_size == 0)
+    {
+        return true;
+    }
+
+    m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_mapping == nullptr)
+    {
+        Close();
+        return false;
+    }
+    m_data = (uint8_t const*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+    if (m_data == nullptr)
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (m_data != nullptr)
+    {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mapping != nullptr)
+    {
+        CloseHandle(m_mapping);
+    }
+    if (m_file != nullptr)
+    {
+        CloseHandle(m_file);
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_mapping = nullptr;
+    m_file = nullptr;
+}
+
+#else
+
+bool MappedFile::Open(char const* path)
+{
+    Close();
+    m_file = open(path, O_RDONLY);
+    if (m_file < 0)
+    {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(m_file, &info) != 0)
+    {
+        Close();
+        return false;
+    }
+    m_size = (size_t)info.st_size;
+    // Empty files can't be mapped, but they are still valid to open.
+    if (m_size == 0)
+    {
+        return true;
+    }
+
+    auto data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+    if (data == MAP_FAILED)
+    {
+        Close();
+        return false;
+    }
+    m_data = (uint8_t const*)data;
+    // Games are read front to back exactly once.
+    madvise(data, m_size, MADV_SEQUENTIAL);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (m_data != nullptr)
+    {
+        munmap((void*)m_data, m_size);
+    }
+    if (m_file >= 0)
+    {
+        close(m_file);
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_file = -1;
+}
+
+#endif
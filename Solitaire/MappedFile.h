@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Read only view of a whole file mapped into memory. Used by the command line
+// tools, the app itself never maps files.
+class MappedFile
+{
+public:
+    MappedFile() {}
+    ~MappedFile() { Close(); }
+
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    bool Open(char const* path);
+    void Close();
+
+    uint8_t const* Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+
+private:
+    uint8_t const* m_data = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+#else
+    int m_file = -1;
+#endif
+};
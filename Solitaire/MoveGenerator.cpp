@@ -0,0 +1,188 @@
+#include "MoveGenerator.h"
+
+namespace Klondike
+{
+    // How many cards off the top of a column have to move so that the bottom
+    // one lands on target, or zero if no card in the face up run fits. Runs
+    // always step down one face at a time, so the only candidate can be found
+    // from the faces alone.
+    static int RunLengthOnto(State const& state, int column, Card target)
+    {
+        auto size = state.ColumnSize(column);
+        auto hidden = state.HiddenCount(column);
+        if (size == 0)
+        {
+            return 0;
+        }
+
+        auto topFace = (int)state.ColumnCard(column, size - 1).Face();
+        auto baseFace = (int)state.ColumnCard(column, hidden).Face();
+        auto neededFace = (int)target.Face() - 1;
+        if (neededFace < topFace || neededFace > baseFace)
+        {
+            return 0;
+        }
+
+        auto length = neededFace - topFace + 1;
+        return CanStackOn(state.ColumnCard(column, size - length), target) ? length : 0;
+    }
+
+    // Only a king can start a column, and a king can only be the base of a run.
+    static int RunLengthOntoEmpty(State const& state, int column)
+    {
+        auto size = state.ColumnSize(column);
+        auto hidden = state.HiddenCount(column);
+        if (size == 0 || !CanStartColumn(state.ColumnCard(column, hidden)))
+        {
+            return 0;
+        }
+        return size - hidden;
+    }
+
+    int GenerateMoves(State const& state, Move* moves, StockMoves stockMoves)
+    {
+        auto count = 0;
+        auto add = [moves, &count](Location from, Location to, int cards)
+        {
+            moves[count++] = { from, to, (uint8_t)cards };
+        };
+
+        // Column to column moves. The ones that turn over a card go straight
+        // out, the rest wait until after the foundation and waste moves.
+        Move deferred[ColumnCount * (ColumnCount - 1)];
+        auto deferredCount = 0;
+        for (auto from = 0; from < ColumnCount; from++)
+        {
+            auto hidden = state.HiddenCount(from);
+            auto faceUpCards = state.ColumnSize(from) - hidden;
+            for (auto to = 0; to < ColumnCount; to++)
+            {
+                if (to == from)
+                {
+                    continue;
+                }
+
+                auto size = state.ColumnSize(to);
+                auto length = size == 0 ?
+                    RunLengthOntoEmpty(state, from) :
+                    RunLengthOnto(state, from, state.ColumnCard(to, size - 1));
+                if (length == 0)
+                {
+                    continue;
+                }
+
+                if (length == faceUpCards && hidden > 0)
+                {
+                    add(ColumnLocation(from), ColumnLocation(to), length);
+                }
+                else
+                {
+                    deferred[deferredCount++] = { ColumnLocation(from), ColumnLocation(to), (uint8_t)length };
+                }
+            }
+        }
+
+        auto addFoundationMoves = [&state, &add](Location from, Card card)
+        {
+            for (auto foundation = 0; foundation < FoundationCount; foundation++)
+            {
+                if (state.CanAddToFoundation(foundation, card))
+                {
+                    add(from, FoundationLocation(foundation), 1);
+                }
+            }
+        };
+
+        for (auto column = 0; column < ColumnCount; column++)
+        {
+            auto size = state.ColumnSize(column);
+            if (size > 0)
+            {
+                addFoundationMoves(ColumnLocation(column), state.ColumnCard(column, size - 1));
+            }
+        }
+
+        auto wasteSize = state.WasteSize();
+        if (wasteSize > 0)
+        {
+            auto card = state.WasteCard(wasteSize - 1);
+            addFoundationMoves(WasteLocation, card);
+            for (auto to = 0; to < ColumnCount; to++)
+            {
+                if (state.CanAddToColumn(to, card))
+                {
+                    add(WasteLocation, ColumnLocation(to), 1);
+                }
+            }
+        }
+
+        for (auto i = 0; i < deferredCount; i++)
+        {
+            moves[count++] = deferred[i];
+        }
+
+        if (stockMoves == StockMoves::Plays)
+        {
+            // The rest of this pass through the stock, then the next one.
+            auto talonSize = wasteSize + state.StockSize();
+            for (auto i = 1; i <= talonSize; i++)
+            {
+                auto size = (wasteSize + i - 1) % talonSize + 1;
+                if (!state.CanReachWasteSize(size))
+                {
+                    continue;
+                }
+
+                auto card = state.TalonCard(size - 1);
+                for (auto foundation = 0; foundation < FoundationCount; foundation++)
+                {
+                    if (state.CanAddToFoundation(foundation, card))
+                    {
+                        add(StockLocation, FoundationLocation(foundation), size);
+                    }
+                }
+                for (auto to = 0; to < ColumnCount; to++)
+                {
+                    if (state.CanAddToColumn(to, card))
+                    {
+                        add(StockLocation, ColumnLocation(to), size);
+                    }
+                }
+            }
+        }
+        else if (state.StockSize() > 0)
+        {
+            add(StockLocation, WasteLocation, 0);
+        }
+        else if (wasteSize > 0)
+        {
+            add(WasteLocation, StockLocation, 0);
+        }
+
+        for (auto from = 0; from < FoundationCount; from++)
+        {
+            if (state.FoundationSize(from) == 0)
+            {
+                continue;
+            }
+
+            auto card = state.FoundationTop(from);
+            for (auto to = 0; to < ColumnCount; to++)
+            {
+                if (state.CanAddToColumn(to, card))
+                {
+                    add(FoundationLocation(from), ColumnLocation(to), 1);
+                }
+            }
+            for (auto to = 0; to < FoundationCount; to++)
+            {
+                if (to != from && state.CanAddToFoundation(to, card))
+                {
+                    add(FoundationLocation(from), FoundationLocation(to), 1);
+                }
+            }
+        }
+
+        return count;
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "Klondike.h"
+
+namespace Klondike
+{
+    // Enough room for every legal move in any position, stock plays included.
+    constexpr int MaxMoves = 256;
+
+    enum class StockMoves
+    {
+        // A draw or a recycle, one move per turn of the stock.
+        Draws,
+        // A stock play for each card drawing can bring to the top of the
+        // waste, and each place it can go. Drawing on its own never helps:
+        // nothing else touches the talon, so a line with draws in it can
+        // always put them off until just before the next waste card it
+        // plays.
+        Plays
+    };
+
+    // Writes every legal move in the position to moves, which needs room for
+    // MaxMoves, and returns how many there are. Nothing is allocated. The
+    // moves come out roughly in order of how promising they are: moves that
+    // turn over a hidden card, then foundation moves, waste moves, the rest of
+    // the column moves, the stock, and finally moves off the foundations.
+    // Stock plays come out in the order the draws would reach them.
+    int GenerateMoves(State const& state, Move* moves, StockMoves stockMoves = StockMoves::Draws);
+}
@@ -0,0 +1,33 @@
+#include <cassert>
+#include "MoveLog.h"
+
+namespace Klondike
+{
+    void MoveLog::Record(Move const& move)
+    {
+        m_moves.resize(m_position);
+        m_moves.push_back(move);
+        m_position++;
+    }
+
+    void MoveLog::Clear()
+    {
+        m_moves.clear();
+        m_position = 0;
+    }
+
+    Move MoveLog::Undo()
+    {
+        assert(CanUndo());
+        m_position--;
+        return m_moves[m_position];
+    }
+
+    Move MoveLog::Redo()
+    {
+        assert(CanRedo());
+        auto move = m_moves[m_position];
+        m_position++;
+        return move;
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <vector>
+#include "Klondike.h"
+
+namespace Klondike
+{
+    // Unlimited undo and redo. Every entry is a four byte Move as returned by
+    // State::Apply, so it carries everything needed to revert it. Recording a
+    // new move drops anything that could have been redone.
+    class MoveLog
+    {
+    public:
+        void Record(Move const& move);
+        void Clear();
+
+        bool CanUndo() const { return m_position > 0; }
+        bool CanRedo() const { return m_position < m_moves.size(); }
+        // Returns the move to revert.
+        Move Undo();
+        // Returns the move to apply again.
+        Move Redo();
+
+        // The moves played so far, not counting any that were undone.
+        Move const* Moves() const { return m_moves.data(); }
+        size_t Size() const { return m_position; }
+
+    private:
+        std::vector<Move> m_moves;
+        size_t m_position = 0;
+    };
+}
@@ -1,8 +1,6 @@
 #include "pch.h"
 #include "Card.h"
-#include "CompositionCard.h"
 #include "Pack.h"
-#include "ShapeCache.h"
 
 using namespace winrt;
 
@@ -13,18 +11,15 @@ using namespace Windows::UI;
 using namespace Windows::UI::Core;
 using namespace Windows::UI::Composition;
 
-Pack::Pack(std::shared_ptr<ShapeCache> const& shapeCache)
+Pack::Pack()
 {
-    m_shapeCache = shapeCache;
-
     for (auto i = 0; i < (int)Face::King; i++)
     {
         auto face = (Face)(i + 1);
         for (auto j = 0; j < (int)Suit::Club + 1; j++)
         {
             auto suit = (Suit)(j);
-            auto card = Card(face, suit);
-            m_cards.push_back(std::make_shared<CompositionCard>(card, m_shapeCache));
+            m_cards.push_back(HandleOf(Card(face, suit)));
         }
     }
 }
@@ -38,14 +33,21 @@ void Pack::Shuffle()
 void Pack::Shuffle(Pack::ShuffleSeed seed)
 {
     m_currentSeed = seed;
-    std::seed_seq rngSeed{ m_currentSeed.Num1, m_currentSeed.Num2, m_currentSeed.Num3, m_currentSeed.Num4 };
-    std::mt19937 g(rngSeed);
-    std::shuffle(m_cards.begin(), m_cards.end(), g);
+
+    // The engine owns the shuffle so the solver deals the exact same game.
+    // The same 52 cards are shuffled for every game, only their order changes.
+    auto order = Klondike::ShuffleCards(m_currentSeed);
+    m_cards.clear();
+    for (auto card : order)
+    {
+        m_cards.push_back(HandleOf(card));
+    }
 
     std::wstringstream debugMessage;
     debugMessage << L"Seed used: { " << m_currentSeed.Num1 << L", ";
     debugMessage << m_currentSeed.Num2 << L", ";
     debugMessage << m_currentSeed.Num3 << L", ";
-    debugMessage << m_currentSeed.Num4 << L" }" << std::endl;
+    debugMessage << m_currentSeed.Num4 << L" } shuffle version ";
+    debugMessage << (int)m_currentSeed.Version << std::endl;
     OutputDebugStringW(debugMessage.str().c_str());
 }
\ No newline at end of file
@@ -1,28 +1,22 @@
 ﻿#pragma once
+#include "Deal.h"
+#include "CardTable.h"
 
-class ShapeCache;
-class CompositionCard;
-
+// The order of the game's cards, as handles into its CardTable.
 class Pack
 {
 public:
-    struct ShuffleSeed
-    {
-        unsigned int Num1 = 0;
-        unsigned int Num2 = 0;
-        unsigned int Num3 = 0;
-        unsigned int Num4 = 0;
-    };
+    using ShuffleSeed = Klondike::ShuffleSeed;
 
-    Pack(std::shared_ptr<ShapeCache> const& shapeCache);
+    Pack();
     ~Pack() {}
 
-    const std::vector<std::shared_ptr<CompositionCard>>& Cards() const { return m_cards; }
+    CardSpan Cards() const { return m_cards; }
+    ShuffleSeed CurrentSeed() const { return m_currentSeed; }
     void Shuffle();
     void Shuffle(ShuffleSeed seed);
     
 private:
-    std::shared_ptr<ShapeCache> m_shapeCache;
-    std::vector<std::shared_ptr<CompositionCard>> m_cards;
+    CardHandleList m_cards;
     ShuffleSeed m_currentSeed = {};
 };
\ No newline at end of file
@@ -0,0 +1,356 @@
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include "MoveGenerator.h"
+#include "ParallelSolver.h"
+
+namespace Klondike
+{
+    // Nodes each subtree searches in a round. Rounds need to be long enough
+    // that waiting for the slowest thread at the end of one is cheap.
+    constexpr uint64_t RoundNodes = 4096;
+    // Subtrees are split between rounds until there are this many, so there
+    // are plenty to steal on any thread count. It mustn't depend on the
+    // thread count or the result would.
+    constexpr size_t TargetSubtrees = 256;
+    constexpr uint32_t NoneWon = std::numeric_limits<uint32_t>::max();
+
+    ParallelSolver::ParallelSolver(SolveOptions options) : m_options(options), m_table(options.TableBytes)
+    {
+        m_threadCount = m_options.ThreadCount;
+        if (m_threadCount == 0)
+        {
+            m_threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+        for (auto i = 0u; i < m_threadCount; i++)
+        {
+            m_queues.push_back(std::make_unique<WorkQueue>());
+        }
+    }
+
+    SolveResult ParallelSolver::Solve(State const& start)
+    {
+        auto startTime = std::chrono::steady_clock::now();
+
+        SolveResult result;
+        m_subtrees.clear();
+        m_table.Clear();
+
+        if (start.IsWon())
+        {
+            result.Status = SolveStatus::Winnable;
+            return result;
+        }
+
+        auto root = std::make_unique<Subtree>();
+        root->Position = start;
+        PushFrame(*root, {});
+        m_table.Insert(start.Key(), 0);
+        m_subtrees.push_back(std::move(root));
+
+        std::vector<std::thread> threads;
+        for (auto i = 1u; i < m_threadCount; i++)
+        {
+            threads.emplace_back(&ParallelSolver::WorkerThread, this, i, m_generation);
+        }
+
+        m_firstWon = NoneWon;
+        while (!m_subtrees.empty() && result.Nodes < m_options.MaxNodes)
+        {
+            // Share what's left of the budget out so the last round doesn't
+            // overshoot it by much.
+            auto count = m_subtrees.size();
+            m_roundNodes = std::min(RoundNodes, (m_options.MaxNodes - result.Nodes + count - 1) / count);
+
+            RunPhase(Phase::Search);
+            for (auto& subtree : m_subtrees)
+            {
+                result.Nodes += subtree->Nodes;
+                result.Transpositions += subtree->Transpositions;
+                result.Pruned += subtree->Pruned;
+                subtree->Nodes = 0;
+                subtree->Transpositions = 0;
+                subtree->Pruned = {};
+            }
+            if (m_firstWon != NoneWon)
+            {
+                break;
+            }
+            RunPhase(Phase::Merge);
+
+            // Drop the subtrees that are done and split the rest. The pieces
+            // go right after the subtree they came from, where a single
+            // threaded search would get to them.
+            std::vector<std::unique_ptr<Subtree>> subtrees;
+            for (auto& subtree : m_subtrees)
+            {
+                if (!subtree->Frames.empty())
+                {
+                    subtrees.push_back(std::move(subtree));
+                }
+            }
+            auto isSplit = true;
+            while (isSplit && subtrees.size() < TargetSubtrees)
+            {
+                isSplit = false;
+                auto total = subtrees.size();
+                std::vector<std::unique_ptr<Subtree>> split;
+                for (auto& subtree : subtrees)
+                {
+                    auto piece = total < TargetSubtrees ? Split(*subtree) : nullptr;
+                    split.push_back(std::move(subtree));
+                    if (piece)
+                    {
+                        split.push_back(std::move(piece));
+                        total++;
+                        isSplit = true;
+                    }
+                }
+                subtrees = std::move(split);
+            }
+            m_subtrees = std::move(subtrees);
+        }
+
+        RunPhase(Phase::Exit);
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        if (m_firstWon != NoneWon)
+        {
+            auto& subtree = *m_subtrees[m_firstWon];
+            result.Status = SolveStatus::Winnable;
+            result.Moves = subtree.Path;
+            for (size_t i = 1; i < subtree.Frames.size(); i++)
+            {
+                result.Moves.push_back(subtree.Frames[i].Applied);
+            }
+        }
+        else if (m_subtrees.empty())
+        {
+            result.Status = SolveStatus::Unwinnable;
+        }
+        m_subtrees.clear();
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+        result.Seconds = elapsed.count();
+        return result;
+    }
+
+    // Runs the phase on every thread, this one included, and returns once
+    // they have all finished it.
+    void ParallelSolver::RunPhase(Phase phase)
+    {
+        if (phase == Phase::Search)
+        {
+            // Deal the subtrees out in runs, so each thread starts with
+            // neighbouring ones.
+            auto count = (uint32_t)m_subtrees.size();
+            for (auto worker = 0u; worker < m_threadCount; worker++)
+            {
+                auto& queue = m_queues[worker]->Subtrees;
+                for (auto i = count * worker / m_threadCount; i < count * (worker + 1) / m_threadCount; i++)
+                {
+                    queue.push_back(i);
+                }
+            }
+        }
+        m_nextShard = 0;
+
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_phase = phase;
+            m_generation++;
+            m_running = m_threadCount - 1;
+        }
+        m_wake.notify_all();
+
+        if (phase != Phase::Exit)
+        {
+            RunWorker(0, phase);
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_done.wait(lock, [&] { return m_running == 0; });
+        }
+    }
+
+    void ParallelSolver::RunWorker(unsigned int worker, Phase phase)
+    {
+        if (phase == Phase::Search)
+        {
+            uint32_t index;
+            while (TakeSubtree(worker, index))
+            {
+                Search(*m_subtrees[index], index);
+            }
+        }
+        else if (phase == Phase::Merge)
+        {
+            for (auto shard = m_nextShard++; shard < ShardCount; shard = m_nextShard++)
+            {
+                for (auto& subtree : m_subtrees)
+                {
+                    auto& found = subtree->Found[shard];
+                    for (auto& position : found)
+                    {
+                        m_table.Insert(position.Key, position.Depth);
+                    }
+                    found.clear();
+                }
+            }
+        }
+    }
+
+    void ParallelSolver::WorkerThread(unsigned int worker, uint64_t generation)
+    {
+        while (true)
+        {
+            Phase phase;
+            {
+                std::unique_lock<std::mutex> lock(m_lock);
+                m_wake.wait(lock, [&] { return m_generation != generation; });
+                generation = m_generation;
+                phase = m_phase;
+            }
+            if (phase == Phase::Exit)
+            {
+                return;
+            }
+
+            RunWorker(worker, phase);
+
+            std::lock_guard<std::mutex> lock(m_lock);
+            if (--m_running == 0)
+            {
+                m_done.notify_one();
+            }
+        }
+    }
+
+    bool ParallelSolver::TakeSubtree(unsigned int worker, uint32_t& index)
+    {
+        {
+            auto& queue = *m_queues[worker];
+            std::lock_guard<std::mutex> lock(queue.Lock);
+            if (!queue.Subtrees.empty())
+            {
+                index = queue.Subtrees.front();
+                queue.Subtrees.pop_front();
+                return true;
+            }
+        }
+        for (auto i = 1u; i < m_threadCount; i++)
+        {
+            auto& queue = *m_queues[(worker + i) % m_threadCount];
+            std::lock_guard<std::mutex> lock(queue.Lock);
+            if (!queue.Subtrees.empty())
+            {
+                index = queue.Subtrees.back();
+                queue.Subtrees.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Carries on the subtree's search for a round. A position counts as
+    // seen if it was in the table when the round started or this subtree has
+    // been to it since, never because another subtree has this round.
+    void ParallelSolver::Search(Subtree& subtree, uint32_t index)
+    {
+        subtree.Seen.clear();
+        auto& state = subtree.Position;
+        uint64_t nodes = 0;
+        while (!subtree.Frames.empty())
+        {
+            auto& frame = subtree.Frames.back();
+            if (frame.Next == frame.End)
+            {
+                if (subtree.Frames.size() > 1)
+                {
+                    state.Revert(frame.Applied);
+                }
+                subtree.Moves.resize(frame.Begin);
+                subtree.Frames.pop_back();
+                continue;
+            }
+
+            // Once an earlier subtree has won nothing this one finds matters.
+            if (nodes >= m_roundNodes || ((nodes & 0xff) == 0 && m_firstWon.load(std::memory_order_relaxed) < index))
+            {
+                break;
+            }
+
+            auto move = state.Apply(subtree.Moves[frame.Next++]);
+            auto key = state.Key();
+            if (m_table.Contains(key) || !subtree.Seen.insert(key).second)
+            {
+                subtree.Transpositions++;
+                state.Revert(move);
+                continue;
+            }
+            subtree.Found[ShardOf(key)].push_back({ key, (int)(subtree.Path.size() + subtree.Frames.size()) });
+            nodes++;
+
+            if (state.IsWon())
+            {
+                subtree.Frames.push_back({ 0, 0, 0, move });
+                auto firstWon = m_firstWon.load();
+                while (index < firstWon && !m_firstWon.compare_exchange_weak(firstWon, index))
+                {
+                }
+                break;
+            }
+            PushFrame(subtree, move);
+        }
+        subtree.Nodes = nodes;
+    }
+
+    void ParallelSolver::PushFrame(Subtree& subtree, Move applied)
+    {
+        Move generated[MaxMoves];
+        auto count = FilterMoves(subtree.Position, applied, m_options.Pruning, generated, GenerateMoves(subtree.Position, generated, m_options.Stock), subtree.Pruned);
+        Frame frame;
+        frame.Begin = (uint32_t)subtree.Moves.size();
+        frame.End = frame.Begin + count;
+        frame.Next = frame.Begin;
+        frame.Applied = applied;
+        subtree.Moves.insert(subtree.Moves.end(), generated, generated + count);
+        subtree.Frames.push_back(frame);
+    }
+
+    // Hands the moves not yet tried from the shallowest position on the
+    // subtree's path that has any to a new subtree, which is the biggest
+    // piece that can be cut off.
+    std::unique_ptr<ParallelSolver::Subtree> ParallelSolver::Split(Subtree& subtree)
+    {
+        auto& frames = subtree.Frames;
+        size_t depth = 0;
+        while (depth < frames.size() && frames[depth].Next == frames[depth].End)
+        {
+            depth++;
+        }
+        if (depth == frames.size())
+        {
+            return nullptr;
+        }
+
+        auto piece = std::make_unique<Subtree>();
+        piece->Position = subtree.Position;
+        for (auto i = frames.size() - 1; i > depth; i--)
+        {
+            piece->Position.Revert(frames[i].Applied);
+        }
+        piece->Path = subtree.Path;
+        for (size_t i = 1; i <= depth; i++)
+        {
+            piece->Path.push_back(frames[i].Applied);
+        }
+
+        auto& frame = frames[depth];
+        piece->Moves.assign(subtree.Moves.begin() + frame.Next, subtree.Moves.begin() + frame.End);
+        piece->Frames.push_back({ 0, (uint32_t)piece->Moves.size(), 0, {} });
+        frame.End = frame.Next;
+        return piece;
+    }
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include "Solver.h"
+
+namespace Klondike
+{
+    // Depth first search over a single deal on every core. The tree is cut
+    // into subtrees, kept in the order a single threaded search would reach
+    // them, which the threads search in rounds of a fixed number of nodes
+    // each, stealing subtrees from each other when they run out. Positions a
+    // subtree finds are only added to the shared transposition table between
+    // rounds, so what every subtree sees, and so the result, is the same
+    // whatever the thread count and however the threads are scheduled.
+    //
+    // When the deal is winnable the moves are those of the first subtree in
+    // order to win. Only the node count and timing of the last round can
+    // vary, as the subtrees after that one stop early.
+    class ParallelSolver
+    {
+    public:
+        ParallelSolver(SolveOptions options = {});
+
+        SolveResult Solve(State const& state);
+        SolveResult Solve(ShuffleSeed seed) { return Solve(Deal(seed)); }
+
+        unsigned int ThreadCount() const { return m_threadCount; }
+
+    private:
+        // The transposition table is split into runs of buckets on the top
+        // bits of the key, so that the threads can add a round's positions
+        // to it side by side, each in the same order every time.
+        static constexpr int ShardBits = 6;
+        static constexpr int ShardCount = 1 << ShardBits;
+        static_assert(ShardCount <= TranspositionTable::MinBuckets, "Shards are expected to cover whole buckets");
+        static uint32_t ShardOf(uint64_t key) { return (uint32_t)(key >> (64 - ShardBits)); }
+
+        struct Frame
+        {
+            uint32_t Begin = 0;
+            uint32_t End = 0;
+            uint32_t Next = 0;
+            Move Applied;
+        };
+
+        struct FoundPosition
+        {
+            uint64_t Key;
+            int Depth;
+        };
+
+        // A depth first search of its own that can stop and carry on where it
+        // left off. The first frame is the subtree's root, Path gets there from
+        // the start.
+        struct Subtree
+        {
+            State Position;
+            std::vector<Move> Path;
+            std::vector<Frame> Frames;
+            std::vector<Move> Moves;
+            // What this round found, to check against until it's in the table.
+            std::unordered_set<uint64_t> Seen;
+            std::array<std::vector<FoundPosition>, ShardCount> Found;
+            uint64_t Nodes = 0;
+            uint64_t Transpositions = 0;
+            PruneCounts Pruned;
+        };
+
+        // Each thread takes subtrees off the front of its own queue and steals
+        // from the back of the others'.
+        struct WorkQueue
+        {
+            std::mutex Lock;
+            std::deque<uint32_t> Subtrees;
+        };
+
+        enum class Phase
+        {
+            Search,
+            Merge,
+            Exit
+        };
+
+        void RunPhase(Phase phase);
+        void RunWorker(unsigned int worker, Phase phase);
+        void WorkerThread(unsigned int worker, uint64_t generation);
+        bool TakeSubtree(unsigned int worker, uint32_t& index);
+        void Search(Subtree& subtree, uint32_t index);
+        void PushFrame(Subtree& subtree, Move applied);
+        std::unique_ptr<Subtree> Split(Subtree& subtree);
+
+        SolveOptions m_options;
+        unsigned int m_threadCount = 1;
+        std::vector<std::unique_ptr<Subtree>> m_subtrees;
+        TranspositionTable m_table;
+        std::vector<std::unique_ptr<WorkQueue>> m_queues;
+        uint64_t m_roundNodes = 0;
+        std::atomic<uint32_t> m_firstWon{ 0 };
+        std::atomic<uint32_t> m_nextShard{ 0 };
+
+        std::mutex m_lock;
+        std::condition_variable m_wake;
+        std::condition_variable m_done;
+        Phase m_phase = Phase::Exit;
+        uint64_t m_generation = 0;
+        unsigned int m_running = 0;
+    };
+}
@@ -1,162 +1,188 @@
-#include "pch.h"
+#include <algorithm>
+#include <cassert>
 #include "Card.h"
 #include "CompositionCard.h"
-#include "ShapeCache.h"
+#include "PileLayout.h"
 #include "Pile.h"
+#include "ItemContainerPool.h"
 
-namespace winrt
+Compositing::VisualPtr CreateBaseVisual(Compositing::Compositor& compositor)
 {
-    using namespace Windows::Foundation;
-    using namespace Windows::Foundation::Numerics;
-    using namespace Windows::UI::Composition;
-}
-
-winrt::ShapeVisual CreateBaseVisual(std::shared_ptr<ShapeCache> const& shapeCache)
-{
-    auto compositor = shapeCache->Compositor();
-    auto visual = compositor.CreateShapeVisual();
-    visual.Shapes().Append(shapeCache->GetShape(ShapeType::Empty));
-    visual.Size(CompositionCard::CardSize);
+    auto visual = compositor.CreateShapeVisual(Compositing::ShapeType::Empty);
+    visual->Size(CompositionCard::CardSize);
     return visual;
 }
 
-Pile::ItemContainer CreateItemContainer(winrt::Compositor const& compositor)
+Pile::Pile(std::shared_ptr<Compositing::Compositor> const& compositor, std::shared_ptr<ItemContainerPool> const& itemContainerPool, std::shared_ptr<CardTable> const& cardTable)
 {
-    auto root = compositor.CreateContainerVisual();
-    root.Size(CompositionCard::CardSize);
-    root.Comment(L"Item Container Root");
-    auto content = compositor.CreateContainerVisual();
-    content.RelativeSizeAdjustment({ 1, 1 });
-    content.Comment(L"Item Container Content");
-    root.Children().InsertAtTop(content);
-    return { root, content };
+    m_compositor = compositor;
+    m_itemContainerPool = itemContainerPool;
+    m_cardTable = cardTable;
+    m_background = CreateBaseVisual(*m_compositor);
 }
 
-std::vector<Pile::ItemContainer> CreateItemContainers(winrt::Compositor const& compositor, uint32_t numberOfItems)
+Pile::Pile(std::shared_ptr<Compositing::Compositor> const& compositor, std::shared_ptr<ItemContainerPool> const& itemContainerPool, std::shared_ptr<CardTable> const& cardTable, CardSpan cards)
 {
-    std::vector<Pile::ItemContainer> result(numberOfItems);
-    for (int i = 0; i < numberOfItems; i++)
+    m_compositor = compositor;
+    m_itemContainerPool = itemContainerPool;
+    m_cardTable = cardTable;
+    m_background = CreateBaseVisual(*m_compositor);
+    m_cards = Pile::CardList(cards);
+    // The first layout pass puts the containers and cards in place.
+    for (size_t i = 0; i < m_cards.size(); i++)
     {
-        auto container = CreateItemContainer(compositor);
-
-        auto previousIndex = i - 1;
-        if (previousIndex >= 0)
-        {
-            auto previousContainer = result[previousIndex];
-            previousContainer.Root.Children().InsertAbove(container.Root, previousContainer.Content);
-        }
-
-        result[i] = container;
+        m_itemContainers.push_back(m_itemContainerPool->Acquire());
     }
-    return result;
 }
 
-Pile::Pile(std::shared_ptr<ShapeCache> const& shapeCache)
+Pile::~Pile()
 {
-    m_background = CreateBaseVisual(shapeCache);
-    m_children = m_background.Children();
+    m_itemContainerPool->Release(m_itemContainers);
 }
 
-Pile::Pile(std::shared_ptr<ShapeCache> const& shapeCache, Pile::CardList cards)
+void Pile::InvalidateLayout(int index)
 {
-    m_background = CreateBaseVisual(shapeCache);
-    m_children = m_background.Children();
-    m_cards = cards;
-    m_itemContainers = CreateItemContainers(shapeCache->Compositor(), m_cards.size());
+    m_layoutDirtyFrom = std::min(m_layoutDirtyFrom, std::max(index, 0));
 }
 
-void Pile::ForceLayout()
+void Pile::SetLayoutMode(Layout::PileMode mode)
 {
-    if (!m_itemContainers.empty())
+    if (m_layoutMode != mode)
     {
-        if (!m_itemContainers.front().Root.Parent())
-        {
-            m_children.InsertAtTop(m_itemContainers.front().Root);
-        }
+        m_layoutMode = mode;
+        InvalidateLayout();
     }
-    auto index = 0;
-    for (auto& card : m_cards)
+}
+
+void Pile::UpdateLayout()
+{
+    m_layoutCounts.Passes++;
+    auto isFlat = m_layoutMode == Layout::PileMode::Flat;
+    auto totalContainers = (int)m_itemContainers.size();
+    auto firstMovedIndex = -1;
+    for (auto index = m_layoutDirtyFrom; index < totalContainers; index++)
     {
-        auto visual = card->Root();
-        auto offset = ComputeOffset(index, m_cards.size());
-        m_itemContainers[index].Root.Offset(offset);
-        if (visual.Parent() && visual.Parent() != m_itemContainers[index].Content)
+        auto& container = m_itemContainers[index];
+        m_layoutCounts.ContainersChecked++;
+        auto isMoved = false;
+
+        // Nested containers sit on the one below them, flat ones all sit on
+        // the base, bottom to top.
+        auto& parent = (isFlat || index == 0) ? m_background : m_itemContainers[index - 1].Root;
+        auto currentParent = container.Root->Parent();
+        if (currentParent != parent)
         {
-            visual.Parent().Children().Remove(visual);
+            if (currentParent)
+            {
+                currentParent->Remove(container.Root);
+            }
+            parent->InsertAtTop(container.Root);
+            m_layoutCounts.ContainersParented++;
+            isMoved = true;
         }
-        else if (!visual.Parent())
+
+        auto offset = isFlat ? ComputeBaseSpaceOffset(index, totalContainers) : ComputeOffset(index, totalContainers);
+        if (container.Root->Offset() != offset)
         {
-            m_itemContainers[index].Content.Children().InsertAtTop(visual);
+            container.Root->Offset(offset);
+            m_layoutCounts.OffsetsChanged++;
+            isMoved = true;
         }
-        index++;
+
+        if (isMoved)
+        {
+            if (isFlat)
+            {
+                m_layoutCounts.ContainersTransformed++;
+            }
+            else if (firstMovedIndex < 0)
+            {
+                firstMovedIndex = index;
+            }
+        }
+
+        // Containers past the end of the cards are waiting on a removal.
+        if (index < (int)m_cards.size())
+        {
+            auto& visual = (*m_cardTable)[m_cards[index]].Root();
+            auto parent = visual->Parent();
+            if (parent != container.Content)
+            {
+                if (parent)
+                {
+                    parent->Remove(visual);
+                }
+                container.Content->InsertAtTop(visual);
+                m_layoutCounts.CardsParented++;
+            }
+        }
+    }
+    // Moving a nested container moves every container above it too.
+    if (firstMovedIndex >= 0)
+    {
+        m_layoutCounts.ContainersTransformed += totalContainers - firstMovedIndex;
     }
+    m_layoutDirtyFrom = totalContainers;
 }
 
 // The coordinates provides are assumed to be in "base space" (the local space for the base visual)
-Pile::HitTestResult Pile::HitTest(winrt::float2 point)
+Pile::HitTestResult Pile::HitTest(Compositing::Vector2 point)
 {
     Pile::HitTestResult result;
 
-    for (int i = m_cards.size() - 1; i >= 0; i--)
+    // Cards always sit at the origin of their item container, so only the
+    // container offsets matter.
+    auto totalCards = (int)m_cards.size();
+    auto cardIndex = Layout::HitTestCards({ point.X, point.Y }, totalCards, [&](int index)
     {
-        auto card = m_cards[i];
-
-        winrt::float3 accumulatedOffset = ComputeBaseSpaceOffset(i, m_cards.size());
-
-        auto tempPoint = point;
-        tempPoint.x -= accumulatedOffset.x;
-        tempPoint.y -= accumulatedOffset.y;
-        if (card->HitTest(tempPoint))
-        {
-            result.Target = Pile::HitTestTarget::Card;
-            result.CardIndex = i;
-            return result;
-        }
+        auto offset = ComputeBaseSpaceOffset(index, totalCards);
+        return Layout::Point{ offset.X, offset.Y };
+    });
+    if (cardIndex >= 0)
+    {
+        result.Target = Pile::HitTestTarget::Card;
+        result.CardIndex = cardIndex;
+        return result;
     }
 
-    winrt::float2 const size = m_background.Size();
-    if (point.x >= 0 &&
-        point.x < size.x &&
-        point.y >= 0 &&
-        point.y < size.y)
+    auto const size = m_background->Size();
+    if (point.X >= 0 &&
+        point.X < size.X &&
+        point.Y >= 0 &&
+        point.Y < size.Y)
     {
         result.Target = Pile::HitTestTarget::Base;
         return result;
     }
 
-    WINRT_ASSERT(result.Target == Pile::HitTestTarget::None);
-    WINRT_ASSERT(result.CardIndex < 0);
+    assert(result.Target == Pile::HitTestTarget::None);
+    assert(result.CardIndex < 0);
     return result;
 }
 
 std::tuple<Pile::ItemContainerList, Pile::CardList, Pile::RemovalOperation> Pile::Split(int index)
 {
-    WINRT_ASSERT(CanSplit(index));
-    WINRT_ASSERT(m_itemContainers.size() == m_cards.size());
+    assert(CanSplit(index));
+    assert(m_itemContainers.size() == m_cards.size());
 
     auto startingSize = m_cards.size();
 
-    auto start = m_cards.begin() + index;
-    auto end = m_cards.end();
-    Pile::CardList cards(
-        std::make_move_iterator(start),
-        std::make_move_iterator(end));
-    m_cards.erase(start, end);
+    Pile::CardList cards(Cards().subspan(index));
+    m_cards.erase(m_cards.begin() + index, m_cards.end());
+    m_version++;
 
-    auto compositor = m_background.Compositor();
-    auto containers = CreateItemContainers(compositor, cards.size());
+    auto containers = m_itemContainerPool->Acquire(cards.size());
 
     auto cardIndex = 0;
     auto mainContainerListIndex = index;
     for (auto& newContainer : containers)
     {
-        auto card = cards[cardIndex];
-        auto visual = card->Root();
-        m_itemContainers[mainContainerListIndex].Content.Children().Remove(visual);
+        auto& visual = (*m_cardTable)[cards[cardIndex]].Root();
+        m_itemContainers[mainContainerListIndex].Content->Remove(visual);
 
         auto offset = ComputeOffset(mainContainerListIndex, startingSize);
-        newContainer.Root.Offset(offset);
-        newContainer.Content.Children().InsertAtTop(visual);
+        newContainer.Root->Offset(offset);
+        newContainer.Content->InsertAtTop(visual);
 
         mainContainerListIndex++;
         cardIndex++;
@@ -164,80 +190,109 @@ std::tuple<Pile::ItemContainerList, Pile::CardList, Pile::RemovalOperation> Pile
     
     // We don't need to add an offset to the first container since we're 
     // going to use ParentForTransform to put the it in the right place.
-    containers.front().Root.Offset({ 0, 0, 0 });
-    containers.front().Root.ParentForTransform(m_itemContainers[index].Root);
+    containers.front().Root->Offset({ 0, 0, 0 });
+    containers.front().Root->ParentForTransform(m_itemContainers[index].Root);
 
     return { containers, cards, { index } };
 }
 
 std::tuple<Pile::ItemContainer, Pile::Card, Pile::RemovalOperation> Pile::Take(int index)
 {
-    WINRT_ASSERT(CanTake(index));
-    WINRT_ASSERT(m_itemContainers.size() == m_cards.size());
-
-    auto startingSize = m_cards.size();
+    assert(CanTake(index));
+    assert(m_itemContainers.size() == m_cards.size());
 
     auto card = m_cards[index];
-    auto visualToRemove = card->Root();
+    auto visualToRemove = (*m_cardTable)[card].Root();
     m_cards.erase(m_cards.begin() + index);
+    m_version++;
 
     auto oldContainer = m_itemContainers[index];
-    oldContainer.Content.Children().Remove(visualToRemove);
+    oldContainer.Content->Remove(visualToRemove);
 
-    auto compositor = m_background.Compositor();
-    auto newContainer = CreateItemContainer(compositor);
-    newContainer.Content.Children().InsertAtTop(visualToRemove);
+    auto newContainer = m_itemContainerPool->Acquire();
+    newContainer.Content->InsertAtTop(visualToRemove);
 
-    newContainer.Root.ParentForTransform(m_itemContainers[index].Root);
+    newContainer.Root->ParentForTransform(m_itemContainers[index].Root);
 
     return { newContainer, card, { index } };
 }
 
-void Pile::Add(Pile::CardList const& cards)
+void Pile::Add(CardSpan cards)
 {
-    WINRT_ASSERT(CanAdd(cards));
+    assert(CanAdd(cards));
     AddInternal(cards);
 }
 
-void Pile::AddInternal(Pile::CardList const& cards)
+Pile::CardList Pile::Remove(int count)
 {
-    WINRT_ASSERT(m_itemContainers.size() == m_cards.size());
-    if (cards.empty())
+    assert(m_itemContainers.size() == m_cards.size());
+    assert(count <= (int)m_cards.size());
+    if (count == 0)
     {
-        return;
+        return {};
     }
 
-    auto compositor = m_background.Compositor();
-    auto newContainers = CreateItemContainers(compositor, cards.size());
-
-    if (!m_itemContainers.empty())
+    auto index = m_cards.size() - count;
+    Pile::CardList cards(Cards().subspan(index));
+    for (auto i = index; i < m_cards.size(); i++)
     {
-        m_itemContainers.back().Root.Children().InsertAtTop(newContainers.front().Root);
+        m_itemContainers[i].Content->Remove((*m_cardTable)[m_cards[i]].Root());
     }
-    else
+
+    // Releasing the containers takes them out of the tree.
+    m_cards.erase(m_cards.begin() + index, m_cards.end());
+    Pile::ItemContainerList containers(m_itemContainers.begin() + index, m_itemContainers.end());
+    m_itemContainers.erase(m_itemContainers.begin() + index, m_itemContainers.end());
+    m_itemContainerPool->Release(containers);
+    m_version++;
+
+    OnRemovalCompleted({ (int)index });
+    UpdateLayout();
+    return cards;
+}
+
+void Pile::Put(CardSpan cards)
+{
+    AddInternal(cards);
+}
+
+void Pile::Clear()
+{
+    // Releasing a container empties it, which takes the card out too.
+    m_itemContainerPool->Release(m_itemContainers);
+    m_itemContainers.clear();
+    m_cards.clear();
+    m_layoutDirtyFrom = 0;
+    m_version++;
+}
+
+void Pile::AddInternal(CardSpan cards)
+{
+    assert(m_itemContainers.size() == m_cards.size());
+    if (cards.empty())
     {
-        m_children.InsertAtTop(newContainers.front().Root);
+        return;
     }
 
-    auto newContainerIndex = 0;
-    auto totalSize = m_cards.size() + cards.size();
-    for (auto& card : cards)
+    // The layout pass puts the new containers in the tree.
+    auto firstNewIndex = (int)m_cards.size();
+    for (auto card : cards)
     {
-        auto mainListIndex = m_cards.size();
-        auto visual = card->Root();
-        visual.Offset({ 0, 0, 0 });
+        auto& visual = (*m_cardTable)[card].Root();
+        visual->Offset({ 0, 0, 0 });
 
-        auto newContainer = newContainers[newContainerIndex];
-        newContainer.Root.Offset(ComputeOffset(mainListIndex, totalSize));
-        newContainer.Content.Children().InsertAtTop(visual);
+        auto newContainer = m_itemContainerPool->Acquire();
+        newContainer.Content->InsertAtTop(visual);
         m_itemContainers.push_back(newContainer);
         m_cards.push_back(card);
-
-        newContainerIndex++;
     }
+    m_version++;
+
+    InvalidateLayout(firstNewIndex);
+    UpdateLayout();
 }
 
-void Pile::Return(Pile::CardList const& cards, Pile::RemovalOperation operation)
+void Pile::Return(CardSpan cards, Pile::RemovalOperation operation)
 {
     if (cards.empty())
     {
@@ -251,24 +306,25 @@ void Pile::Return(Pile::CardList const& cards, Pile::RemovalOperation operation)
         container != m_itemContainers.begin() + operation.Index + cards.size(); 
         container++)
     {
-        auto cardVisual = cards[returnedCardIndex]->Root();
-        cardVisual.Offset({ 0, 0, 0 });
-        container->Content.Children().InsertAtTop(cardVisual);
+        auto& cardVisual = (*m_cardTable)[cards[returnedCardIndex]].Root();
+        cardVisual->Offset({ 0, 0, 0 });
+        container->Content->InsertAtTop(cardVisual);
         m_cards.insert(m_cards.begin() + index, cards[returnedCardIndex]);
         returnedCardIndex++;
         index++;
     }
+    m_version++;
 
-    WINRT_ASSERT(m_itemContainers.size() == m_cards.size());
+    assert(m_itemContainers.size() == m_cards.size());
 }
 
 void Pile::CompleteRemoval(Pile::RemovalOperation operation)
 {
-    WINRT_ASSERT(m_itemContainers.size() > m_cards.size());
+    assert(m_itemContainers.size() > m_cards.size());
     auto endIndex = operation.Index;
     for (auto container = m_itemContainers.begin() + operation.Index; container != m_itemContainers.end(); container++)
     {
-        if (container->Content.Children().Count() > 0)
+        if (!container->Content->Children().empty())
         {
             break;
         }
@@ -281,32 +337,15 @@ void Pile::CompleteRemoval(Pile::RemovalOperation operation)
         std::make_move_iterator(start),
         std::make_move_iterator(end));
     m_itemContainers.erase(start, end);
+    m_version++;
 
-    auto previousIndex = operation.Index - 1;
-    auto parentChildren = m_children;
-    if (previousIndex >= 0)
-    {
-        parentChildren = m_itemContainers[previousIndex].Root.Children();
-    }
-    parentChildren.Remove(containers.front().Root);
-
-    if (operation.Index < m_itemContainers.size())
-    {
-        auto shiftedVisual = m_itemContainers[operation.Index].Root;
-        if (shiftedVisual.Parent())
-        {
-            shiftedVisual.Parent().Children().Remove(shiftedVisual);
-        }
-        parentChildren.InsertAtTop(shiftedVisual);
-
-        auto currentIndex = operation.Index;
-        for (auto container = m_itemContainers.begin() + operation.Index; container != m_itemContainers.end(); container++)
-        {
-            container->Root.Offset(ComputeOffset(currentIndex, m_itemContainers.size()));
-            currentIndex++;
-        }
-    }
+    // Releasing the containers takes them out of the tree, along with
+    // anything nested on them. The layout pass puts the containers above
+    // the gap back on the one below it.
+    m_itemContainerPool->Release(containers);
 
-    WINRT_ASSERT(m_itemContainers.size() == m_cards.size());
+    assert(m_itemContainers.size() == m_cards.size());
+    InvalidateLayout(operation.Index);
     OnRemovalCompleted(operation);
+    UpdateLayout();
 }
\ No newline at end of file
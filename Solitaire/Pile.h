@@ -1,15 +1,21 @@
 #pragma once
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <vector>
+#include "CardTable.h"
+#include "Compositing.h"
+#include "PileLayout.h"
 
-class ShapeCache;
-class CompositionCard;
+class ItemContainerPool;
 
 class Pile
 {
 public:
     struct ItemContainer
     {
-        winrt::Windows::UI::Composition::ContainerVisual Root{ nullptr };
-        winrt::Windows::UI::Composition::ContainerVisual Content{ nullptr };
+        Compositing::VisualPtr Root;
+        Compositing::VisualPtr Content;
     };
 
     struct RemovalOperation
@@ -17,17 +23,19 @@ public:
         int Index = -1;
     };
 
-    using Card = std::shared_ptr<CompositionCard>;
-    using CardList = std::vector<Pile::Card>;
+    using Card = CardHandle;
+    using CardList = CardHandleList;
     using ItemContainerList = std::vector<Pile::ItemContainer>;
 
-    Pile(std::shared_ptr<ShapeCache> const& shapeCache);
-    Pile(std::shared_ptr<ShapeCache> const& shapeCache, Pile::CardList cards);
-    ~Pile() {}
+    Pile(std::shared_ptr<Compositing::Compositor> const& compositor, std::shared_ptr<ItemContainerPool> const& itemContainerPool, std::shared_ptr<CardTable> const& cardTable);
+    Pile(std::shared_ptr<Compositing::Compositor> const& compositor, std::shared_ptr<ItemContainerPool> const& itemContainerPool, std::shared_ptr<CardTable> const& cardTable, CardSpan cards);
+    ~Pile();
 
-    winrt::Windows::UI::Composition::Visual Base() { return m_background; }
-    const Pile::CardList& Cards() const { return m_cards; }
+    Compositing::VisualPtr const& Base() { return m_background; }
+    CardSpan Cards() const { return m_cards; }
     const Pile::ItemContainerList& ItemContainers() const { return m_itemContainers; }
+    // Changes whenever cards are added to or taken off the pile.
+    uint32_t Version() const { return m_version; }
 
     enum class HitTestTarget
     {
@@ -42,7 +50,9 @@ public:
         int CardIndex = -1;
     };
 
-    Pile::HitTestResult HitTest(winrt::Windows::Foundation::Numerics::float2 point);
+    Pile::HitTestResult HitTest(Compositing::Vector2 point);
+    // Where the card at the given index sits relative to the base visual.
+    Compositing::Vector3 CardOffset(int index) { return ComputeBaseSpaceOffset(index, m_cards.size()); }
 
     virtual bool CanSplit(int index) = 0;
     std::tuple<Pile::ItemContainerList, Pile::CardList, Pile::RemovalOperation> Split(int index);
@@ -51,23 +61,45 @@ public:
     std::tuple<Pile::ItemContainer, Pile::Card, Pile::RemovalOperation> Take(int index);
 
     void CompleteRemoval(Pile::RemovalOperation operation);
-    void Return(Pile::CardList const& cards, Pile::RemovalOperation operation);
-
-    virtual bool CanAdd(Pile::CardList const& cards) = 0;
-    void Add(Pile::CardList const& cards);
-
-    void ForceLayout();
+    void Return(CardSpan cards, Pile::RemovalOperation operation);
+
+    virtual bool CanAdd(CardSpan cards) = 0;
+    void Add(CardSpan cards);
+
+    // Moves cards off the top and onto the top without a drag and without
+    // checking the rules, for replaying moves from the undo log.
+    Pile::CardList Remove(int count);
+    void Put(CardSpan cards);
+    // Hands back every card and container, ready to be dealt into again.
+    void Clear();
+
+    // Containers from index up have their offsets checked on the next
+    // UpdateLayout. Only the ones whose offset changed are touched.
+    void InvalidateLayout(int index = 0);
+    void UpdateLayout();
+    // Nested piles are cheaper to shift as a whole, flat ones keep the tree
+    // shallow so moving one card doesn't move every card above it.
+    Layout::PileMode LayoutMode() const { return m_layoutMode; }
+    void SetLayoutMode(Layout::PileMode mode);
+    Layout::LayoutCounts const& LayoutCounts() const { return m_layoutCounts; }
 
 protected:
-    virtual winrt::Windows::Foundation::Numerics::float3 ComputeOffset(int index, int totalCards) = 0;
-    virtual winrt::Windows::Foundation::Numerics::float3 ComputeBaseSpaceOffset(int index, int totalCards) = 0;
+    virtual Compositing::Vector3 ComputeOffset(int index, int totalCards) = 0;
+    virtual Compositing::Vector3 ComputeBaseSpaceOffset(int index, int totalCards) = 0;
     virtual void OnRemovalCompleted(Pile::RemovalOperation operation) = 0;
 
-    void AddInternal(Pile::CardList const& cards);
+    void AddInternal(CardSpan cards);
 
 protected:
-    winrt::Windows::UI::Composition::ShapeVisual m_background{ nullptr };
-    winrt::Windows::UI::Composition::VisualCollection m_children{ nullptr };
+    std::shared_ptr<Compositing::Compositor> m_compositor;
+    std::shared_ptr<ItemContainerPool> m_itemContainerPool;
+    std::shared_ptr<CardTable> m_cardTable;
+    Compositing::VisualPtr m_background;
     Pile::CardList m_cards;
     Pile::ItemContainerList m_itemContainers;
+    uint32_t m_version = 0;
+    // New piles have all of their containers to lay out.
+    int m_layoutDirtyFrom = 0;
+    Layout::PileMode m_layoutMode = Layout::PileMode::Nested;
+    Layout::LayoutCounts m_layoutCounts;
 };
\ No newline at end of file
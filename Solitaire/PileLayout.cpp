@@ -0,0 +1,35 @@
+#include <algorithm>
+#include "PileLayout.h"
+
+namespace Layout
+{
+    Point ColumnOffset(int index, float verticalOffset)
+    {
+        return { 0, index == 0 ? 0 : verticalOffset };
+    }
+
+    Point ColumnBaseSpaceOffset(int index, float verticalOffset)
+    {
+        return { 0, index * verticalOffset };
+    }
+
+    Point WasteOffset(int index, int totalCards, float horizontalOffset)
+    {
+        auto numCardsToFan = std::min(WasteFanCount, totalCards);
+        if (index > totalCards - numCardsToFan)
+        {
+            return { horizontalOffset, 0 };
+        }
+        return {};
+    }
+
+    Point WasteBaseSpaceOffset(int index, int totalCards, float horizontalOffset)
+    {
+        auto numCardsToFan = std::min(WasteFanCount, totalCards);
+        if (index > totalCards - numCardsToFan)
+        {
+            return { (index - (totalCards - numCardsToFan)) * horizontalOffset, 0 };
+        }
+        return {};
+    }
+}
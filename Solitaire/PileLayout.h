@@ -0,0 +1,96 @@
+#pragma once
+#include <cstdint>
+
+// Where cards sit within a pile, kept free of WinRT so the layout and hit
+// testing math can be measured and checked headlessly. Offsets are in the
+// local space of the pile's base visual.
+namespace Layout
+{
+    constexpr float CardWidth = 175.0f;
+    constexpr float CardHeight = 250.0f;
+    // The waste fans out its top cards, the rest sit under the first of them.
+    constexpr int WasteFanCount = 3;
+
+    // How a pile arranges its item containers. Nested containers each sit on
+    // the one below and are offset from it, flat ones are siblings on the
+    // pile's base at their base space offsets.
+    enum class PileMode
+    {
+        Nested,
+        Flat
+    };
+
+    struct Point
+    {
+        float X = 0;
+        float Y = 0;
+    };
+
+    // Work done bringing piles up to date with their layout. Only containers
+    // in a pile's dirty range are checked, and only those whose offset has
+    // changed are moved.
+    struct LayoutCounts
+    {
+        uint64_t Passes = 0;
+        uint64_t ContainersChecked = 0;
+        uint64_t OffsetsChanged = 0;
+        uint64_t CardsParented = 0;
+        uint64_t ContainersParented = 0;
+        // Containers whose position on screen changed, the ones that moved
+        // and any nested on them.
+        uint64_t ContainersTransformed = 0;
+
+        LayoutCounts& operator+=(LayoutCounts const& other)
+        {
+            Passes += other.Passes;
+            ContainersChecked += other.ContainersChecked;
+            OffsetsChanged += other.OffsetsChanged;
+            CardsParented += other.CardsParented;
+            ContainersParented += other.ContainersParented;
+            ContainersTransformed += other.ContainersTransformed;
+            return *this;
+        }
+        LayoutCounts operator-(LayoutCounts const& other) const
+        {
+            return
+            {
+                Passes - other.Passes,
+                ContainersChecked - other.ContainersChecked,
+                OffsetsChanged - other.OffsetsChanged,
+                CardsParented - other.CardsParented,
+                ContainersParented - other.ContainersParented,
+                ContainersTransformed - other.ContainersTransformed
+            };
+        }
+    };
+
+    // Column cards are nested, so each one is offset from the card below it.
+    Point ColumnOffset(int index, float verticalOffset);
+    Point ColumnBaseSpaceOffset(int index, float verticalOffset);
+
+    Point WasteOffset(int index, int totalCards, float horizontalOffset);
+    Point WasteBaseSpaceOffset(int index, int totalCards, float horizontalOffset);
+
+    constexpr bool IsInCard(Point point, Point cardOffset)
+    {
+        return point.X >= cardOffset.X &&
+            point.X < cardOffset.X + CardWidth &&
+            point.Y >= cardOffset.Y &&
+            point.Y < cardOffset.Y + CardHeight;
+    }
+
+    // Index of the topmost of count cards under the point, or -1. offsetOf
+    // gives the base space offset of a card from its index.
+    template <typename OffsetOf>
+    int HitTestCards(Point point, int count, OffsetOf&& offsetOf)
+    {
+        for (auto i = count - 1; i >= 0; i--)
+        {
+            if (IsInCard(point, offsetOf(i)))
+            {
+                return i;
+            }
+        }
+        return -1;
+    }
+}
@@ -0,0 +1,331 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include "Rasterizer.h"
+
+namespace Raster
+{
+    // How far, in pixels, a flattened curve can stray from the real one.
+    constexpr float FlatteningTolerance = 0.25f;
+    // Control point distance for a quarter circle drawn as a cubic.
+    constexpr float ArcControl = 0.5522847f;
+
+    static float Length(float x, float y)
+    {
+        return std::sqrt(x * x + y * y);
+    }
+
+    void Image::Resize(int width, int height)
+    {
+        Width = width;
+        Height = height;
+        Pixels.assign((size_t)width * height * 4, 0);
+    }
+
+    void Rasterizer::Transform(float scale, Layout::Point offset)
+    {
+        m_scale = scale;
+        m_offset = offset;
+    }
+
+    Layout::Point Rasterizer::Map(Layout::Point point) const
+    {
+        return { point.X * m_scale + m_offset.X, point.Y * m_scale + m_offset.Y };
+    }
+
+    void Rasterizer::LineTo(Layout::Point point)
+    {
+        if (point.Y != m_current.Y)
+        {
+            m_lines.push_back({ m_current.X, m_current.Y, point.X, point.Y });
+        }
+        m_current = point;
+    }
+
+    void Rasterizer::BeginFigure(Layout::Point point)
+    {
+        if (m_isFigureOpen)
+        {
+            EndFigure();
+        }
+        m_figureStart = Map(point);
+        m_current = m_figureStart;
+        m_isFigureOpen = true;
+    }
+
+    void Rasterizer::AddLine(Layout::Point point)
+    {
+        assert(m_isFigureOpen);
+        LineTo(Map(point));
+    }
+
+    // The error of n even steps along a curve is at most an eighth of its
+    // largest second derivative over n squared.
+    void Rasterizer::AddQuadraticBezier(Layout::Point control, Layout::Point end)
+    {
+        assert(m_isFigureOpen);
+        auto p0 = m_current;
+        auto p1 = Map(control);
+        auto p2 = Map(end);
+        auto curvature = Length(p0.X - 2 * p1.X + p2.X, p0.Y - 2 * p1.Y + p2.Y);
+        auto steps = std::max(1, (int)std::ceil(std::sqrt(curvature / (4 * FlatteningTolerance))));
+        for (auto i = 1; i < steps; i++)
+        {
+            auto t = (float)i / steps;
+            auto u = 1 - t;
+            LineTo({
+                u * u * p0.X + 2 * u * t * p1.X + t * t * p2.X,
+                u * u * p0.Y + 2 * u * t * p1.Y + t * t * p2.Y });
+        }
+        LineTo(p2);
+    }
+
+    void Rasterizer::AddCubicBezier(Layout::Point control1, Layout::Point control2, Layout::Point end)
+    {
+        assert(m_isFigureOpen);
+        auto p0 = m_current;
+        auto p1 = Map(control1);
+        auto p2 = Map(control2);
+        auto p3 = Map(end);
+        auto curvature = std::max(
+            Length(p0.X - 2 * p1.X + p2.X, p0.Y - 2 * p1.Y + p2.Y),
+            Length(p1.X - 2 * p2.X + p3.X, p1.Y - 2 * p2.Y + p3.Y));
+        auto steps = std::max(1, (int)std::ceil(std::sqrt(3 * curvature / (4 * FlatteningTolerance))));
+        for (auto i = 1; i < steps; i++)
+        {
+            auto t = (float)i / steps;
+            auto u = 1 - t;
+            auto a = u * u * u;
+            auto b = 3 * u * u * t;
+            auto c = 3 * u * t * t;
+            auto d = t * t * t;
+            LineTo({
+                a * p0.X + b * p1.X + c * p2.X + d * p3.X,
+                a * p0.Y + b * p1.Y + c * p2.Y + d * p3.Y });
+        }
+        LineTo(p3);
+    }
+
+    void Rasterizer::EndFigure()
+    {
+        assert(m_isFigureOpen);
+        LineTo(m_figureStart);
+        m_isFigureOpen = false;
+    }
+
+    void Rasterizer::AddPath(Layout::GlyphPath const& path)
+    {
+        auto point = path.Points.data();
+        for (auto command : path.Commands)
+        {
+            switch (command)
+            {
+            case Layout::PathCommand::BeginFigure:
+                BeginFigure(point[0]);
+                break;
+            case Layout::PathCommand::AddLine:
+                AddLine(point[0]);
+                break;
+            case Layout::PathCommand::AddQuadraticBezier:
+                AddQuadraticBezier(point[0], point[1]);
+                break;
+            case Layout::PathCommand::AddCubicBezier:
+                AddCubicBezier(point[0], point[1], point[2]);
+                break;
+            case Layout::PathCommand::EndFigure:
+                EndFigure();
+                break;
+            }
+            point += Layout::PointCount(command);
+        }
+    }
+
+    void Rasterizer::AddRoundedRectangle(Layout::Rect rect, float radius, bool isHole)
+    {
+        auto r = std::max(0.0f, std::min({ radius, rect.Width / 2, rect.Height / 2 }));
+        auto k = r * ArcControl;
+        auto left = rect.X;
+        auto top = rect.Y;
+        auto right = rect.X + rect.Width;
+        auto bottom = rect.Y + rect.Height;
+        BeginFigure({ left + r, top });
+        if (!isHole)
+        {
+            AddLine({ right - r, top });
+            AddCubicBezier({ right - r + k, top }, { right, top + r - k }, { right, top + r });
+            AddLine({ right, bottom - r });
+            AddCubicBezier({ right, bottom - r + k }, { right - r + k, bottom }, { right - r, bottom });
+            AddLine({ left + r, bottom });
+            AddCubicBezier({ left + r - k, bottom }, { left, bottom - r + k }, { left, bottom - r });
+            AddLine({ left, top + r });
+            AddCubicBezier({ left, top + r - k }, { left + r - k, top }, { left + r, top });
+        }
+        else
+        {
+            AddCubicBezier({ left + r - k, top }, { left, top + r - k }, { left, top + r });
+            AddLine({ left, bottom - r });
+            AddCubicBezier({ left, bottom - r + k }, { left + r - k, bottom }, { left + r, bottom });
+            AddLine({ right - r, bottom });
+            AddCubicBezier({ right - r + k, bottom }, { right, bottom - r + k }, { right, bottom - r });
+            AddLine({ right, top + r });
+            AddCubicBezier({ right, top + r - k }, { right - r + k, top }, { right - r, top });
+        }
+        EndFigure();
+    }
+
+    void Rasterizer::AddRoundedRectangleStroke(Layout::Rect rect, float radius, float thickness)
+    {
+        auto half = thickness / 2;
+        AddRoundedRectangle({ rect.X - half, rect.Y - half, rect.Width + thickness, rect.Height + thickness }, radius + half);
+        if (rect.Width > thickness && rect.Height > thickness)
+        {
+            AddRoundedRectangle({ rect.X + half, rect.Y + half, rect.Width - thickness, rect.Height - thickness }, radius - half, true);
+        }
+    }
+
+    // Adds the area to the right of the line within each pixel it crosses
+    // to that pixel, and the rest of its height to the next one, so a sweep
+    // along the row sums to the winding number times the coverage.
+    void Rasterizer::AccumulateLine(Line const& line, float left, float top, int width, int height)
+    {
+        auto x0 = line.X0 - left;
+        auto y0 = line.Y0 - top;
+        auto x1 = line.X1 - left;
+        auto y1 = line.Y1 - top;
+        auto direction = 1.0f;
+        if (y0 > y1)
+        {
+            std::swap(x0, x1);
+            std::swap(y0, y1);
+            direction = -1.0f;
+        }
+        if (y1 <= 0 || y0 >= height)
+        {
+            return;
+        }
+
+        auto stride = width + 2;
+        auto dxdy = (x1 - x0) / (y1 - y0);
+        auto x = x0;
+        if (y0 < 0)
+        {
+            x -= y0 * dxdy;
+        }
+        auto rowEnd = std::min(height, (int)std::ceil(y1));
+        for (auto y = std::max(0, (int)y0); y < rowEnd; y++)
+        {
+            auto row = &m_coverage[(size_t)y * stride];
+            auto dy = std::min(y + 1.0f, y1) - std::max((float)y, y0);
+            auto xNext = x + dxdy * dy;
+            auto d = dy * direction;
+            // Left of the bounds covers from their left edge, right of them
+            // covers nothing that's drawn.
+            auto xa = std::clamp(std::min(x, xNext), 0.0f, (float)width);
+            auto xb = std::clamp(std::max(x, xNext), 0.0f, (float)width);
+            auto xaFloor = std::floor(xa);
+            auto xai = (int)xaFloor;
+            auto xbCeil = std::ceil(xb);
+            auto xbi = (int)xbCeil;
+            if (xbi <= xai + 1)
+            {
+                auto middle = 0.5f * (xa + xb) - xaFloor;
+                row[xai] += d - d * middle;
+                row[xai + 1] += d * middle;
+            }
+            else
+            {
+                auto s = 1.0f / (xb - xa);
+                auto xaFraction = xa - xaFloor;
+                auto first = 0.5f * s * (1 - xaFraction) * (1 - xaFraction);
+                auto xbFraction = xb - xbCeil + 1;
+                auto last = 0.5f * s * xbFraction * xbFraction;
+                row[xai] += d * first;
+                if (xbi == xai + 2)
+                {
+                    row[xai + 1] += d * (1 - first - last);
+                }
+                else
+                {
+                    auto second = s * (1.5f - xaFraction);
+                    row[xai + 1] += d * (second - first);
+                    for (auto xi = xai + 2; xi < xbi - 1; xi++)
+                    {
+                        row[xi] += d * s;
+                    }
+                    auto beforeLast = second + (xbi - xai - 3) * s;
+                    row[xbi - 1] += d * (1 - beforeLast - last);
+                }
+                row[xbi] += d * last;
+            }
+            x = xNext;
+        }
+    }
+
+    void Rasterizer::Fill(Image& image, Color color)
+    {
+        if (m_isFigureOpen)
+        {
+            EndFigure();
+        }
+        if (m_lines.empty())
+        {
+            return;
+        }
+
+        auto minX = m_lines[0].X0;
+        auto minY = m_lines[0].Y0;
+        auto maxX = minX;
+        auto maxY = minY;
+        for (auto& line : m_lines)
+        {
+            minX = std::min({ minX, line.X0, line.X1 });
+            minY = std::min({ minY, line.Y0, line.Y1 });
+            maxX = std::max({ maxX, line.X0, line.X1 });
+            maxY = std::max({ maxY, line.Y0, line.Y1 });
+        }
+        auto left = std::max(0, (int)std::floor(minX));
+        auto top = std::max(0, (int)std::floor(minY));
+        auto right = std::min(image.Width, (int)std::ceil(maxX));
+        auto bottom = std::min(image.Height, (int)std::ceil(maxY));
+        if (right <= left || bottom <= top)
+        {
+            m_lines.clear();
+            return;
+        }
+
+        auto width = right - left;
+        auto height = bottom - top;
+        auto stride = width + 2;
+        m_coverage.assign((size_t)stride * height, 0.0f);
+        for (auto& line : m_lines)
+        {
+            AccumulateLine(line, (float)left, (float)top, width, height);
+        }
+        m_lines.clear();
+
+        auto alpha = color.A / 255.0f;
+        float const source[4] = { color.B * alpha, color.G * alpha, color.R * alpha, (float)color.A };
+        for (auto y = 0; y < height; y++)
+        {
+            auto row = &m_coverage[(size_t)y * stride];
+            auto pixel = &image.Pixels[((size_t)(top + y) * image.Width + left) * 4];
+            auto winding = 0.0f;
+            for (auto x = 0; x < width; x++, pixel += 4)
+            {
+                winding += row[x];
+                auto coverage = std::min(1.0f, std::abs(winding));
+                // Below half a step of an 8-bit channel, float error from
+                // the sweep rather than anything drawn.
+                if (coverage < 1.0f / 512)
+                {
+                    continue;
+                }
+                auto remaining = 1 - alpha * coverage;
+                for (auto channel = 0; channel < 4; channel++)
+                {
+                    pixel[channel] = (uint8_t)(source[channel] * coverage + pixel[channel] * remaining + 0.5f);
+                }
+            }
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "GlyphCache.h"
+#include "HitTestIndex.h"
+
+// A small CPU rasterizer for the card atlas, so the card faces can be drawn
+// and checked without a GPU or a window.
+namespace Raster
+{
+    // Straight, not premultiplied, alpha.
+    struct Color
+    {
+        uint8_t R = 0;
+        uint8_t G = 0;
+        uint8_t B = 0;
+        uint8_t A = 255;
+    };
+
+    // Premultiplied BGRA, four bytes a pixel and rows top to bottom, the
+    // layout a B8G8R8A8 composition surface takes.
+    struct Image
+    {
+        int Width = 0;
+        int Height = 0;
+        std::vector<uint8_t> Pixels;
+
+        // Clears to transparent.
+        void Resize(int width, int height);
+    };
+
+    // Fills paths with antialiasing by the nonzero winding rule. Curves are
+    // flattened to lines as they're added. Filling accumulates the signed
+    // area each line covers in every pixel of the path's bounds and sweeps
+    // each row once, so the cost follows the area filled rather than the
+    // number of lines.
+    class Rasterizer
+    {
+    public:
+        // Points added from here on are scaled and then offset, into pixels.
+        void Transform(float scale, Layout::Point offset);
+
+        void BeginFigure(Layout::Point point);
+        void AddLine(Layout::Point point);
+        void AddQuadraticBezier(Layout::Point control, Layout::Point end);
+        void AddCubicBezier(Layout::Point control1, Layout::Point control2, Layout::Point end);
+        void EndFigure();
+
+        void AddPath(Layout::GlyphPath const& path);
+        // Clockwise on screen, or counterclockwise to cut a hole.
+        void AddRoundedRectangle(Layout::Rect rect, float radius, bool isHole = false);
+        // The band thickness wide centered on the rounded rectangle's edge.
+        void AddRoundedRectangleStroke(Layout::Rect rect, float radius, float thickness);
+
+        // Fills and then clears what's been added, clipped to the image.
+        void Fill(Image& image, Color color);
+
+    private:
+        struct Line
+        {
+            float X0;
+            float Y0;
+            float X1;
+            float Y1;
+        };
+
+        Layout::Point Map(Layout::Point point) const;
+        void LineTo(Layout::Point point);
+        void AccumulateLine(Line const& line, float left, float top, int width, int height);
+
+    private:
+        float m_scale = 1;
+        Layout::Point m_offset;
+        std::vector<Line> m_lines;
+        // Both in pixels.
+        Layout::Point m_figureStart;
+        Layout::Point m_current;
+        bool m_isFigureOpen = false;
+        // Each row keeps two extra cells for lines on its right edge.
+        std::vector<float> m_coverage;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#include "RecordingCompositor.h"
+
+namespace Compositing
+{
+    VisualPtr RecordingCompositor::OnCreateContainerVisual()
+    {
+        return std::make_shared<Visual>(m_counts);
+    }
+
+    VisualPtr RecordingCompositor::OnCreateShapeVisual(ShapeType)
+    {
+        return std::make_shared<Visual>(m_counts);
+    }
+
+    VisualPtr RecordingCompositor::OnCreateCardFaceVisual(::Card)
+    {
+        return std::make_shared<Visual>(m_counts);
+    }
+
+    void RecordingCompositor::OnEndBatch(std::function<void()> completed)
+    {
+        m_completions.push_back(std::move(completed));
+    }
+
+    void RecordingCompositor::CompleteAnimations()
+    {
+        // Completions can end batches of their own.
+        while (!m_completions.empty())
+        {
+            auto completions = std::move(m_completions);
+            m_completions.clear();
+            for (auto& completed : completions)
+            {
+                completed();
+            }
+        }
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include "Compositing.h"
+
+namespace Compositing
+{
+    // Builds the visual tree in memory and renders nothing. Lets the piles
+    // and cards run headless, in benchmarks and tools, with the compositor
+    // work they do counted.
+    class RecordingCompositor : public Compositor
+    {
+    public:
+        RecordingCompositor(float textHeight = 47.88f) : m_textHeight(textHeight) {}
+
+        float TextHeight() override { return m_textHeight; }
+
+        // Animations never run, batches wait here until this is called as if
+        // they had all finished.
+        void CompleteAnimations();
+        size_t PendingBatchCount() const { return m_completions.size(); }
+
+    protected:
+        VisualPtr OnCreateContainerVisual() override;
+        VisualPtr OnCreateShapeVisual(ShapeType shapeType) override;
+        VisualPtr OnCreateCardFaceVisual(::Card card) override;
+        void OnBeginBatch() override {}
+        void OnEndBatch(std::function<void()> completed) override;
+
+    private:
+        float m_textHeight;
+        std::vector<std::function<void()>> m_completions;
+    };
+}
@@ -0,0 +1,270 @@
+#include <algorithm>
+#include <cassert>
+#include "Replay.h"
+
+namespace Klondike
+{
+    constexpr uint8_t ReplayMagic[4] = { 'K', 'L', 'R', 'P' };
+    constexpr size_t SeedSize = 16;
+    constexpr uint8_t NoCode = 0xFF;
+
+    // Cards only ever move between these pairs of locations, few enough that
+    // each pair gets its own single byte code.
+    constexpr bool IsMovePair(int from, int to)
+    {
+        if (from == StockLocation)
+        {
+            return to == WasteLocation;
+        }
+        if (to == StockLocation)
+        {
+            return from == WasteLocation;
+        }
+        return to != WasteLocation && from != to;
+    }
+
+    struct MoveCodes
+    {
+        uint8_t Codes[LocationCount][LocationCount] = {};
+        Location From[128] = {};
+        Location To[128] = {};
+        int Count = 0;
+    };
+
+    constexpr MoveCodes MakeMoveCodes()
+    {
+        MoveCodes codes;
+        for (auto from = 0; from < LocationCount; from++)
+        {
+            for (auto to = 0; to < LocationCount; to++)
+            {
+                codes.Codes[from][to] = NoCode;
+                if (IsMovePair(from, to))
+                {
+                    codes.From[codes.Count] = (Location)from;
+                    codes.To[codes.Count] = (Location)to;
+                    codes.Codes[from][to] = (uint8_t)codes.Count++;
+                }
+            }
+        }
+        return codes;
+    }
+
+    constexpr MoveCodes Codes = MakeMoveCodes();
+    static_assert(Codes.Count <= 128, "Every move code is expected to fit in a single varint byte");
+
+    static void WriteVarint(std::vector<uint8_t>& buffer, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            buffer.push_back((uint8_t)(value | 0x80));
+            value >>= 7;
+        }
+        buffer.push_back((uint8_t)value);
+    }
+
+    static bool ReadVarint(uint8_t const*& position, uint8_t const* end, uint64_t& value)
+    {
+        value = 0;
+        for (auto shift = 0; shift < 64 && position < end; shift += 7)
+        {
+            auto byte = *position++;
+            value |= (uint64_t)(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static void WriteUInt32(std::vector<uint8_t>& buffer, uint32_t value)
+    {
+        for (auto i = 0; i < 4; i++)
+        {
+            buffer.push_back((uint8_t)(value >> (i * 8)));
+        }
+    }
+
+    static uint32_t ReadUInt32(uint8_t const* position)
+    {
+        return position[0] | (position[1] << 8) | (position[2] << 16) | ((uint32_t)position[3] << 24);
+    }
+
+    void WriteReplayFileHeader(std::vector<uint8_t>& buffer)
+    {
+        buffer.insert(buffer.end(), ReplayMagic, ReplayMagic + sizeof(ReplayMagic));
+        buffer.push_back(ReplayVersion);
+        buffer.insert(buffer.end(), ReplayFileHeaderSize - sizeof(ReplayMagic) - 1, 0);
+    }
+
+    static void WriteGame(std::vector<uint8_t>& buffer, ShuffleSeed seed, uint8_t cardsPerDraw, size_t moveCount, uint8_t const* stream, size_t streamSize)
+    {
+        WriteUInt32(buffer, seed.Num1);
+        WriteUInt32(buffer, seed.Num2);
+        WriteUInt32(buffer, seed.Num3);
+        WriteUInt32(buffer, seed.Num4);
+        buffer.push_back((uint8_t)seed.Version);
+        buffer.push_back(cardsPerDraw);
+        WriteVarint(buffer, moveCount);
+        WriteVarint(buffer, streamSize);
+        buffer.insert(buffer.end(), stream, stream + streamSize);
+    }
+
+    void WriteReplayGame(std::vector<uint8_t>& buffer, ShuffleSeed seed, Move const* moves, size_t count)
+    {
+        std::vector<uint8_t> stream;
+        stream.reserve(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            auto& move = moves[i];
+            auto code = Codes.Codes[move.From][move.To];
+            assert(code != NoCode);
+            WriteVarint(stream, code);
+            if (IsColumn(move.From) && IsColumn(move.To))
+            {
+                WriteVarint(stream, move.Count);
+            }
+        }
+        WriteGame(buffer, seed, (uint8_t)CardsPerDraw, count, stream.data(), stream.size());
+    }
+
+    // The move stream is the same in every version, only the game's header
+    // has changed.
+    void WriteReplayGame(std::vector<uint8_t>& buffer, ReplayGame const& game)
+    {
+        WriteGame(buffer, game.Seed, game.CardsPerDraw, game.MoveCount, game.MoveData, game.MoveDataSize);
+    }
+
+    uint8_t ReplayFileVersion(uint8_t const* data, size_t size)
+    {
+        if (size < ReplayFileHeaderSize || !std::equal(ReplayMagic, ReplayMagic + sizeof(ReplayMagic), data))
+        {
+            return 0;
+        }
+        return data[sizeof(ReplayMagic)];
+    }
+
+    bool UpgradeReplayFile(uint8_t const* data, size_t size, std::vector<uint8_t>& buffer)
+    {
+        buffer.clear();
+        ReplayReader reader(data, size);
+        if (!reader.IsValid())
+        {
+            return false;
+        }
+
+        WriteReplayFileHeader(buffer);
+        ReplayGame game;
+        while (reader.Next(game))
+        {
+            WriteReplayGame(buffer, game);
+        }
+
+        // The reader stops early at a game that runs past the end of the file.
+        if (reader.Offset() != size)
+        {
+            buffer.clear();
+            return false;
+        }
+        return true;
+    }
+
+    ReplayReader::ReplayReader(uint8_t const* data, size_t size) : m_data(data), m_position(data), m_end(data + size)
+    {
+        auto version = ReplayFileVersion(data, size);
+        if (version >= 1 && version <= ReplayVersion)
+        {
+            m_version = version;
+            m_isValid = true;
+            m_position += ReplayFileHeaderSize;
+        }
+    }
+
+    bool ReplayReader::Next(ReplayGame& game)
+    {
+        auto headerSize = SeedSize + (m_version >= 2 ? 2 : 1);
+        if (!m_isValid || (size_t)(m_end - m_position) < headerSize)
+        {
+            return false;
+        }
+
+        auto position = m_position;
+        game.Seed.Num1 = ReadUInt32(position);
+        game.Seed.Num2 = ReadUInt32(position + 4);
+        game.Seed.Num3 = ReadUInt32(position + 8);
+        game.Seed.Num4 = ReadUInt32(position + 12);
+        position += SeedSize;
+        game.Seed.Version = m_version >= 2 ? (ShuffleVersion)*position++ : ShuffleVersion::Legacy;
+        game.CardsPerDraw = *position++;
+
+        uint64_t moveCount = 0;
+        uint64_t streamSize = 0;
+        if (!ReadVarint(position, m_end, moveCount) ||
+            !ReadVarint(position, m_end, streamSize) ||
+            moveCount > UINT32_MAX ||
+            streamSize > (uint64_t)(m_end - position))
+        {
+            m_isValid = false;
+            return false;
+        }
+
+        game.MoveCount = (uint32_t)moveCount;
+        game.MoveData = position;
+        game.MoveDataSize = (size_t)streamSize;
+        m_position = position + streamSize;
+        return true;
+    }
+
+    bool MoveDecoder::Next(Move& move)
+    {
+        uint64_t code = 0;
+        if (!ReadVarint(m_position, m_end, code) || code >= (uint64_t)Codes.Count)
+        {
+            return false;
+        }
+
+        move = {};
+        move.From = Codes.From[code];
+        move.To = Codes.To[code];
+        // Draws and recycles work out their own count, everything else but a
+        // run of cards between columns moves a single card.
+        move.Count = move.From == StockLocation || move.To == StockLocation ? 0 : 1;
+        if (IsColumn(move.From) && IsColumn(move.To))
+        {
+            uint64_t count = 0;
+            if (!ReadVarint(m_position, m_end, count) || count == 0 || count > MaxColumnCards)
+            {
+                return false;
+            }
+            move.Count = (uint8_t)count;
+        }
+        return true;
+    }
+
+    ReplayValidation ValidateReplay(ReplayGame const& game)
+    {
+        ReplayValidation result;
+        if (game.CardsPerDraw != CardsPerDraw || game.Seed.Version > CurrentShuffleVersion)
+        {
+            return result;
+        }
+
+        auto state = Deal(game.Seed);
+        MoveDecoder decoder(game);
+        Move move;
+        for (; result.FailedMove < game.MoveCount; result.FailedMove++)
+        {
+            if (!decoder.Next(move) || !state.IsLegal(move))
+            {
+                return result;
+            }
+            state.Apply(move);
+        }
+
+        // Trailing bytes mean the stream and the move count disagree.
+        result.IsValid = !decoder.Next(move);
+        result.IsWon = state.IsWon();
+        return result;
+    }
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Klondike.h"
+#include "Deal.h"
+
+// Compact on-disk record of played games.
+//
+// A replay file starts with a ReplayFileHeaderSize byte header ("KLRP", a version
+// byte and three reserved bytes) followed by any number of games. Each game is
+//
+//   16 bytes   the ShuffleSeed, four little endian 32-bit words
+//    1 byte    the ShuffleVersion of the seed
+//    1 byte    the rule set, currently the number of cards per draw
+//   varint     number of moves
+//   varint     number of bytes in the move stream
+//   ...        the move stream
+//
+// Every move is a varint code for its source and destination, followed by a
+// varint card count only for column to column moves (every other move moves a
+// known number of cards). All codes fit in a single byte.
+//
+// Version 1 files predate versioned seeds and have no ShuffleVersion byte,
+// their games were all dealt with ShuffleVersion::Legacy. Games are only ever
+// appended to a file of the current version, older files are upgraded first.
+namespace Klondike
+{
+    constexpr size_t ReplayFileHeaderSize = 8;
+    constexpr uint8_t ReplayVersion = 2;
+
+    struct ReplayGame
+    {
+        ShuffleSeed Seed;
+        uint8_t CardsPerDraw = Klondike::CardsPerDraw;
+        uint32_t MoveCount = 0;
+        // Points into the reader's buffer, nothing is copied.
+        uint8_t const* MoveData = nullptr;
+        size_t MoveDataSize = 0;
+    };
+
+    void WriteReplayFileHeader(std::vector<uint8_t>& buffer);
+    void WriteReplayGame(std::vector<uint8_t>& buffer, ShuffleSeed seed, Move const* moves, size_t count);
+    // Copies a game read from a file of any version in the current layout.
+    void WriteReplayGame(std::vector<uint8_t>& buffer, ReplayGame const& game);
+
+    // The version of the replay file that starts with data, or 0 if it isn't
+    // one. Only the header needs to be there.
+    uint8_t ReplayFileVersion(uint8_t const* data, size_t size);
+    // Fills buffer with a replay file of the current version holding the same
+    // games. Returns false, leaving buffer empty, if the file isn't one this
+    // version can read or any of it is corrupt.
+    bool UpgradeReplayFile(uint8_t const* data, size_t size, std::vector<uint8_t>& buffer);
+
+    // Walks the games in a replay file held in memory (typically mapped).
+    class ReplayReader
+    {
+    public:
+        ReplayReader(uint8_t const* data, size_t size);
+
+        bool IsValid() const { return m_isValid; }
+        // False once the data runs out or turns out to be malformed.
+        bool Next(ReplayGame& game);
+        size_t Offset() const { return m_position - m_data; }
+
+    private:
+        uint8_t const* m_data;
+        uint8_t const* m_position;
+        uint8_t const* m_end;
+        uint8_t m_version = 0;
+        bool m_isValid = false;
+    };
+
+    class MoveDecoder
+    {
+    public:
+        MoveDecoder(ReplayGame const& game) : m_position(game.MoveData), m_end(game.MoveData + game.MoveDataSize) {}
+
+        bool Next(Move& move);
+
+    private:
+        uint8_t const* m_position;
+        uint8_t const* m_end;
+    };
+
+    struct ReplayValidation
+    {
+        bool IsValid = false;
+        bool IsWon = false;
+        // Index of the first move that could not be decoded or was illegal,
+        // or MoveCount when every move checks out.
+        uint32_t FailedMove = 0;
+    };
+
+    // Deals the game and plays every move through the rules engine.
+    ReplayValidation ValidateReplay(ReplayGame const& game);
+}
@@ -1,8 +1,15 @@
 ﻿#include "pch.h"
 #include "ShapeCache.h"
 #include "Card.h"
-#include "CompositionCard.h"
+#include "GlyphCache.h"
+#include "PileLayout.h"
 
+#include <chrono>
+#include <fstream>
+#include <d2d1_1.h>
+#include <windows.graphics.interop.h>
+#include <winrt/Windows.ApplicationModel.h>
+#include <winrt/Windows.Graphics.h>
 #include <winrt/Microsoft.Graphics.Canvas.h>
 #include <winrt/Microsoft.Graphics.Canvas.Geometry.h>
 #include <winrt/Microsoft.Graphics.Canvas.Text.h>
@@ -10,6 +17,7 @@
 using namespace winrt;
 
 using namespace Windows;
+using namespace Windows::ApplicationModel;
 using namespace Windows::ApplicationModel::Core;
 using namespace Windows::Foundation::Numerics;
 using namespace Windows::UI;
@@ -21,24 +29,142 @@ using namespace Microsoft::Graphics::Canvas::Geometry;
 using namespace Microsoft::Graphics::Canvas::Text;
 
 
+// Hands a Direct2D path to composition, which is all CompositionPath needs
+// from Win2D's CanvasGeometry.
+struct GeometrySource : implements<GeometrySource, Windows::Graphics::IGeometrySource2D, ABI::Windows::Graphics::IGeometrySource2DInterop>
+{
+    GeometrySource(com_ptr<ID2D1Geometry> const& geometry) : m_geometry(geometry) {}
+
+    IFACEMETHODIMP GetGeometry(ID2D1Geometry** value) override
+    {
+        m_geometry.copy_to(value);
+        return S_OK;
+    }
+
+    IFACEMETHODIMP TryGetGeometryUsingFactory(ID2D1Factory*, ID2D1Geometry** result) override
+    {
+        *result = nullptr;
+        return E_NOTIMPL;
+    }
+
+private:
+    com_ptr<ID2D1Geometry> m_geometry;
+};
+
+static CompositionPathGeometry CreatePathGeometry(
+    ::Compositor const& compositor,
+    ID2D1Factory* factory,
+    Layout::GlyphPath const& path)
+{
+    com_ptr<ID2D1PathGeometry> geometry;
+    check_hresult(factory->CreatePathGeometry(geometry.put()));
+    com_ptr<ID2D1GeometrySink> sink;
+    check_hresult(geometry->Open(sink.put()));
+    sink->SetFillMode(D2D1_FILL_MODE_WINDING);
+
+    auto point = path.Points.data();
+    for (auto command : path.Commands)
+    {
+        switch (command)
+        {
+        case Layout::PathCommand::BeginFigure:
+            sink->BeginFigure({ point[0].X, point[0].Y }, D2D1_FIGURE_BEGIN_FILLED);
+            break;
+        case Layout::PathCommand::AddLine:
+            sink->AddLine({ point[0].X, point[0].Y });
+            break;
+        case Layout::PathCommand::AddQuadraticBezier:
+            sink->AddQuadraticBezier({ { point[0].X, point[0].Y }, { point[1].X, point[1].Y } });
+            break;
+        case Layout::PathCommand::AddCubicBezier:
+            sink->AddBezier({ { point[0].X, point[0].Y }, { point[1].X, point[1].Y }, { point[2].X, point[2].Y } });
+            break;
+        case Layout::PathCommand::EndFigure:
+            sink->EndFigure(D2D1_FIGURE_END_CLOSED);
+            break;
+        }
+        point += Layout::PointCount(command);
+    }
+    check_hresult(sink->Close());
+
+    return compositor.CreatePathGeometry(CompositionPath(make<GeometrySource>(geometry.as<ID2D1Geometry>())));
+}
+
+// Copies a Win2D path into a GlyphPath. Text outlines have no arcs.
+struct PathReceiver : implements<PathReceiver, ICanvasPathReceiver>
+{
+    PathReceiver(Layout::GlyphPath& path) : m_path(path) {}
+
+    void BeginFigure(float2 startPoint, CanvasFigureFill)
+    {
+        m_path.BeginFigure({ startPoint.x, startPoint.y });
+    }
+
+    void AddArc(float2 endPoint, float, float, float, CanvasSweepDirection, CanvasArcSize)
+    {
+        WINRT_ASSERT(false);
+        m_path.AddLine({ endPoint.x, endPoint.y });
+    }
+
+    void AddCubicBezier(float2 controlPoint1, float2 controlPoint2, float2 endPoint)
+    {
+        m_path.AddCubicBezier({ controlPoint1.x, controlPoint1.y }, { controlPoint2.x, controlPoint2.y }, { endPoint.x, endPoint.y });
+    }
+
+    void AddLine(float2 endPoint)
+    {
+        m_path.AddLine({ endPoint.x, endPoint.y });
+    }
+
+    void AddQuadraticBezier(float2 controlPoint, float2 endPoint)
+    {
+        m_path.AddQuadraticBezier({ controlPoint.x, controlPoint.y }, { endPoint.x, endPoint.y });
+    }
+
+    void SetFilledRegionDetermination(CanvasFilledRegionDetermination) {}
+    void SetSegmentOptions(CanvasFigureSegmentOptions) {}
+
+    void EndFigure(CanvasFigureLoop)
+    {
+        m_path.EndFigure();
+    }
+
+private:
+    Layout::GlyphPath& m_path;
+};
+
 ShapeCache::ShapeCache(
     ::Compositor const& compositor)
 {
     FillCache(
         compositor,
-        L"Segoe UI",
-        36);
+        to_hstring(std::string_view(Layout::CardFontFamily)),
+        Layout::CardFontSize);
+}
+
+CompositionShape ShapeCache::GetShape(Compositing::ShapeType shapeType)
+{
+    return m_shapes[(int)shapeType];
+}
+
+CompositionColorBrush ShapeCache::GetBrush(BrushType brushType)
+{
+    return m_brushes[(int)brushType];
+}
+
+CompositionPathGeometry ShapeCache::GetFaceGeometry(Face face)
+{
+    return m_faceGeometries[(int)face - 1];
 }
 
-CompositionPathGeometry ShapeCache::GetPathGeometry(
-    hstring const& key)
+float ShapeCache::FaceAdvance(Face face)
 {
-    return m_geometryCache.at(key);
+    return m_faceAdvances[(int)face - 1];
 }
 
-CompositionShape ShapeCache::GetShape(ShapeType shapeType)
+CompositionPathGeometry ShapeCache::GetSuitGeometry(Suit suit)
 {
-    return m_shapeCache.at(shapeType);
+    return m_suitGeometries[(int)suit];
 }
 
 void ShapeCache::FillCache(
@@ -46,117 +172,210 @@ void ShapeCache::FillCache(
     hstring const& fontFamily,
     float fontSize)
 {
-    hstring faces[] = 
-    {
-        L"K",
-        L"Q",
-        L"J",
-        L"10",
-        L"9",
-        L"8",
-        L"7",
-        L"6",
-        L"5",
-        L"4",
-        L"3",
-        L"2",
-        L"A"
-    };
-
-    hstring suits[] =
-    {
-        L"♠",
-        L"♣",
-        L"♥",
-        L"♦"
-    };
-
-    std::vector<hstring> cards;
-    for (auto& face : faces)
-    {
-        for (auto& suit : suits)
-        {
-            auto card = face + suit;
-
-            cards.push_back(card);
-        }
+    m_resources = {};
+    m_brushes.clear();
+    for (auto color : { Colors::Black(), Colors::Blue(), Colors::Crimson(), Colors::Gray(), Colors::White() })
+    {
+        m_brushes.push_back(compositor.CreateColorBrush(color));
     }
+    WINRT_ASSERT(m_brushes.size() == (size_t)BrushType::Count);
+    m_resources.Brushes += m_brushes.size();
 
-    auto device = CanvasDevice();
-    m_geometryCache.clear();
-    auto height = -1.0f;
-    for (auto& card : cards)
+    auto startTime = std::chrono::steady_clock::now();
+    auto isLoaded = LoadGlyphs(compositor, fontFamily, fontSize);
+    if (!isLoaded)
     {
-        auto textFormat = CanvasTextFormat();
-        textFormat.FontFamily(fontFamily);
-        textFormat.FontSize(fontSize);
-        auto textLayout = CanvasTextLayout(device, card, textFormat, 500, 0);
-        auto geometry = CanvasGeometry::CreateText(textLayout);
-
-        auto compositionPath = CompositionPath(geometry);
-        auto pathGeoemtry = compositor.CreatePathGeometry(compositionPath);
-
-        m_geometryCache.emplace(card, pathGeoemtry);
-
-        if (height < 0)
-        {
-            height = textLayout.LayoutBounds().Height;
-        }
-        WINRT_ASSERT(height == textLayout.LayoutBounds().Height);
+        LayOutGlyphs(compositor, fontFamily, fontSize);
     }
+    m_resources.Geometries += m_faceGeometries.size() + m_suitGeometries.size();
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - startTime;
+    std::wstringstream debugMessage;
+    debugMessage << L"Card glyphs " << (isLoaded ? L"loaded from the glyph cache" : L"laid out") << L" in " << elapsed.count() << L"ms" << std::endl;
+    OutputDebugStringW(debugMessage.str().c_str());
 
-    m_shapeCache.clear();
+    m_shapes.clear();
+    float2 const cardSize{ Layout::CardWidth, Layout::CardHeight };
     {
         auto shapeContainer = compositor.CreateContainerShape();
-        auto backgroundBaseColor = Colors::Blue();
 
         auto roundedRectGeometry = compositor.CreateRoundedRectangleGeometry();
         roundedRectGeometry.CornerRadius({ 10, 10 });
-        roundedRectGeometry.Size(CompositionCard::CardSize);
+        roundedRectGeometry.Size(cardSize);
         auto rectShape = compositor.CreateSpriteShape(roundedRectGeometry);
-        rectShape.StrokeBrush(compositor.CreateColorBrush(Colors::Gray()));
-        rectShape.FillBrush(compositor.CreateColorBrush(backgroundBaseColor));
+        rectShape.StrokeBrush(GetBrush(BrushType::Gray));
+        rectShape.FillBrush(GetBrush(BrushType::Blue));
         rectShape.StrokeThickness(2);
         shapeContainer.Shapes().Append(rectShape);
 
         float2 innerOffset{ 12, 12 };
         auto innerRoundedRectGeometry = compositor.CreateRoundedRectangleGeometry();
         innerRoundedRectGeometry.CornerRadius({ 6, 6 });
-        innerRoundedRectGeometry.Size(CompositionCard::CardSize - innerOffset);
+        innerRoundedRectGeometry.Size(cardSize - innerOffset);
         auto innerRectShape = compositor.CreateSpriteShape(innerRoundedRectGeometry);
-        innerRectShape.StrokeBrush(compositor.CreateColorBrush(Colors::White()));
+        innerRectShape.StrokeBrush(GetBrush(BrushType::White));
         innerRectShape.StrokeThickness(5);
         innerRectShape.Offset(innerOffset / 2.0f);
         shapeContainer.Shapes().Append(innerRectShape);
 
-        m_shapeCache.emplace(ShapeType::Back, shapeContainer);
+        m_shapes.push_back(shapeContainer);
+        m_resources.Geometries += 2;
+        m_resources.Shapes += 3;
     }
 
     {
         auto shapeContainer = compositor.CreateContainerShape();
-        auto backgroundBaseColor = Colors::Blue();
 
         auto roundedRectGeometry = compositor.CreateRoundedRectangleGeometry();
         roundedRectGeometry.CornerRadius({ 10, 10 });
-        roundedRectGeometry.Size(CompositionCard::CardSize);
+        roundedRectGeometry.Size(cardSize);
         auto rectShape = compositor.CreateSpriteShape(roundedRectGeometry);
-        rectShape.StrokeBrush(compositor.CreateColorBrush(Colors::Gray()));
+        rectShape.StrokeBrush(GetBrush(BrushType::Gray));
         rectShape.StrokeThickness(5);
         shapeContainer.Shapes().Append(rectShape);
 
-        float2 innerSize{ CompositionCard::CardSize / 2.0f };
+        float2 innerSize{ cardSize / 2.0f };
         auto innerRoundedRectGeometry = compositor.CreateRoundedRectangleGeometry();
         innerRoundedRectGeometry.CornerRadius({ 6, 6 });
         innerRoundedRectGeometry.Size(innerSize);
         auto innerRectShape = compositor.CreateSpriteShape(innerRoundedRectGeometry);
-        innerRectShape.FillBrush(compositor.CreateColorBrush(Colors::Gray()));
+        innerRectShape.FillBrush(GetBrush(BrushType::Gray));
         innerRectShape.StrokeThickness(5);
-        innerRectShape.Offset((CompositionCard::CardSize - innerSize) / 2.0f);
+        innerRectShape.Offset((cardSize - innerSize) / 2.0f);
         shapeContainer.Shapes().Append(innerRectShape);
 
-        m_shapeCache.emplace(ShapeType::Empty, shapeContainer);
+        m_shapes.push_back(shapeContainer);
+        m_resources.Geometries += 2;
+        m_resources.Shapes += 3;
+    }
+    WINRT_ASSERT(m_shapes.size() == (size_t)Compositing::ShapeType::Empty + 1);
+
+    {
+        auto roundedRectGeometry = compositor.CreateRoundedRectangleGeometry();
+        roundedRectGeometry.CornerRadius({ 10, 10 });
+        roundedRectGeometry.Size(cardSize);
+        auto rectShape = compositor.CreateSpriteShape(roundedRectGeometry);
+        rectShape.StrokeBrush(GetBrush(BrushType::Gray));
+        rectShape.FillBrush(GetBrush(BrushType::White));
+        rectShape.StrokeThickness(2);
+
+        m_cardFrame = rectShape;
+        m_resources.Geometries += 1;
+        m_resources.Shapes += 1;
     }
 
     m_compositor = compositor;
-    m_textHeight = height;
+}
+
+bool ShapeCache::LoadGlyphs(
+    ::Compositor const& compositor,
+    hstring const& fontFamily,
+    float fontSize)
+{
+    std::ifstream file(std::wstring(Package::Current().InstalledLocation().Path()) + L"\\Assets\\CardGlyphs.bin", std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+    std::vector<uint8_t> buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    // A cache made for another font or size is no use, text layout has to
+    // run after all.
+    Layout::GlyphCacheReader reader(buffer.data(), buffer.size());
+    if (!reader.IsValid() ||
+        to_hstring(reader.FontFamily()) != fontFamily ||
+        reader.FontSize() != fontSize)
+    {
+        return false;
+    }
+
+    Layout::CardOutlines outlines;
+    if (!Layout::ReadCardOutlines(reader, outlines))
+    {
+        return false;
+    }
+
+    com_ptr<ID2D1Factory> factory;
+    check_hresult(D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED, factory.put()));
+
+    std::vector<CompositionPathGeometry> faceGeometries;
+    for (auto& path : outlines.Faces)
+    {
+        faceGeometries.push_back(CreatePathGeometry(compositor, factory.get(), path));
+    }
+    std::vector<CompositionPathGeometry> suitGeometries;
+    for (auto& path : outlines.Suits)
+    {
+        suitGeometries.push_back(CreatePathGeometry(compositor, factory.get(), path));
+    }
+
+    m_faceGeometries = std::move(faceGeometries);
+    m_faceAdvances = outlines.FaceAdvances;
+    m_suitGeometries = std::move(suitGeometries);
+    m_outlines = std::move(outlines);
+    m_textHeight = reader.TextHeight();
+    return true;
+}
+
+void ShapeCache::LayOutGlyphs(
+    ::Compositor const& compositor,
+    hstring const& fontFamily,
+    float fontSize)
+{
+    std::vector<hstring> texts;
+    for (auto face = 1; face <= FaceCount; face++)
+    {
+        texts.push_back(Card::FaceText((Face)face));
+    }
+    for (auto suit = 0; suit < SuitCount; suit++)
+    {
+        texts.push_back(Card::SuitText((Suit)suit));
+    }
+
+    // Laid out on their own, a face and a suit can come from fonts with
+    // different baselines. Move them all down onto the lowest one, where
+    // laying out a card's whole text would have put them.
+    auto device = CanvasDevice();
+    auto textFormat = CanvasTextFormat();
+    textFormat.FontFamily(fontFamily);
+    textFormat.FontSize(fontSize);
+    std::vector<CanvasTextLayout> textLayouts;
+    auto baseline = 0.0f;
+    auto descent = 0.0f;
+    for (auto& text : texts)
+    {
+        auto textLayout = CanvasTextLayout(device, text, textFormat, 500, 0);
+        auto textBaseline = textLayout.LineMetrics()[0].Baseline;
+        baseline = (std::max)(baseline, textBaseline);
+        descent = (std::max)(descent, textLayout.LayoutBounds().Height - textBaseline);
+        textLayouts.push_back(textLayout);
+    }
+
+    std::vector<CompositionPathGeometry> geometries;
+    std::vector<Layout::GlyphPath> paths(texts.size());
+    for (size_t i = 0; i < textLayouts.size(); i++)
+    {
+        auto geometry = CanvasGeometry::CreateText(textLayouts[i]);
+        auto shift = baseline - textLayouts[i].LineMetrics()[0].Baseline;
+        if (shift != 0)
+        {
+            geometry = geometry.Transform(make_float3x2_translation(0, shift));
+        }
+        geometry.SendPathTo(make<PathReceiver>(paths[i]));
+        geometries.push_back(compositor.CreatePathGeometry(CompositionPath(geometry)));
+    }
+
+    m_faceGeometries.assign(geometries.begin(), geometries.begin() + FaceCount);
+    m_suitGeometries.assign(geometries.begin() + FaceCount, geometries.end());
+    m_faceAdvances.clear();
+    for (auto face = 0; face < FaceCount; face++)
+    {
+        m_faceAdvances.push_back(textLayouts[face].LayoutBounds().Width);
+    }
+    m_textHeight = baseline + descent;
+
+    m_outlines.Faces.assign(paths.begin(), paths.begin() + FaceCount);
+    m_outlines.FaceAdvances = m_faceAdvances;
+    m_outlines.Suits.assign(paths.begin() + FaceCount, paths.end());
+    m_outlines.TextHeight = m_textHeight;
 }
\ No newline at end of file
@@ -1,9 +1,17 @@
 #pragma once
+#include "Card.h"
+#include "Compositing.h"
+#include "GlyphCache.h"
 
-enum class ShapeType
+// Brushes shared by every shape that paints in that color.
+enum class BrushType
 {
-    Back,
-    Empty
+    Black,
+    Blue,
+    Crimson,
+    Gray,
+    White,
+    Count
 };
 
 class ShapeCache
@@ -13,9 +21,21 @@ public:
     ~ShapeCache() {}
 
     winrt::Windows::UI::Composition::Compositor Compositor() { return m_compositor; }
-    winrt::Windows::UI::Composition::CompositionPathGeometry GetPathGeometry(winrt::hstring const& key);
-    winrt::Windows::UI::Composition::CompositionShape GetShape(ShapeType shapeType);
+    winrt::Windows::UI::Composition::CompositionShape GetShape(Compositing::ShapeType shapeType);
+    // The outline and fill of a card face, shared by every card.
+    winrt::Windows::UI::Composition::CompositionShape GetCardFrame() { return m_cardFrame; }
+    winrt::Windows::UI::Composition::CompositionColorBrush GetBrush(BrushType brushType);
+    // A card's text is its face followed by its suit at the face's advance,
+    // both with the top of the line at zero.
+    winrt::Windows::UI::Composition::CompositionPathGeometry GetFaceGeometry(Face face);
+    float FaceAdvance(Face face);
+    winrt::Windows::UI::Composition::CompositionPathGeometry GetSuitGeometry(Suit suit);
     float TextHeight() { return m_textHeight; }
+    // The same faces and suits as portable paths, for drawing the atlas.
+    Layout::CardOutlines const& Outlines() const { return m_outlines; }
+
+    // What the cache made, each shared geometry, brush and shape counted once.
+    Compositing::ResourceCounts Resources() const { return m_resources; }
 
 private:
 
@@ -23,10 +43,27 @@ private:
         winrt::Windows::UI::Composition::Compositor const& compositor,
         winrt::hstring const& fontFamily,
         float fontSize);
+    // Builds the card text from the glyph cache file SolitaireGlyphs made
+    // for this font, false if there isn't one.
+    bool LoadGlyphs(
+        winrt::Windows::UI::Composition::Compositor const& compositor,
+        winrt::hstring const& fontFamily,
+        float fontSize);
+    void LayOutGlyphs(
+        winrt::Windows::UI::Composition::Compositor const& compositor,
+        winrt::hstring const& fontFamily,
+        float fontSize);
 
 private:
     winrt::Windows::UI::Composition::Compositor m_compositor;
-    std::map<winrt::hstring, winrt::Windows::UI::Composition::CompositionPathGeometry> m_geometryCache;
-    std::map<ShapeType, winrt::Windows::UI::Composition::CompositionShape> m_shapeCache;
+    // Indexed by face - 1, suit, shape type and brush type.
+    std::vector<winrt::Windows::UI::Composition::CompositionPathGeometry> m_faceGeometries;
+    std::vector<float> m_faceAdvances;
+    std::vector<winrt::Windows::UI::Composition::CompositionPathGeometry> m_suitGeometries;
+    Layout::CardOutlines m_outlines;
+    std::vector<winrt::Windows::UI::Composition::CompositionShape> m_shapes;
+    std::vector<winrt::Windows::UI::Composition::CompositionColorBrush> m_brushes;
+    winrt::Windows::UI::Composition::CompositionShape m_cardFrame{ nullptr };
+    Compositing::ResourceCounts m_resources;
     float m_textHeight;
 };
\ No newline at end of file
@@ -0,0 +1,204 @@
+#include <chrono>
+#include "MoveGenerator.h"
+#include "Solver.h"
+
+namespace Klondike
+{
+    // A card is safe to found once nothing left could need to stack on it:
+    // the two cards one face lower in the other colour are already founded,
+    // and aces only ever go to foundations so twos are always safe. Founded
+    // cards can come back down though, so the other suit of the card's own
+    // colour has to be two faces lower too, leaving nothing for those cards
+    // to come back for.
+    static bool IsSafeToFound(State const& state, Card card)
+    {
+        auto face = (int)card.Face();
+        if (face <= (int)Face::Two)
+        {
+            return true;
+        }
+
+        int foundedFaces[SuitCount] = {};
+        for (auto foundation = 0; foundation < FoundationCount; foundation++)
+        {
+            auto size = state.FoundationSize(foundation);
+            if (size > 0)
+            {
+                foundedFaces[(int)state.FoundationTop(foundation).Suit()] = size;
+            }
+        }
+        // Colours alternate between suits.
+        auto suit = (int)card.Suit();
+        return foundedFaces[(suit + 1) % SuitCount] >= face - 1 &&
+            foundedFaces[(suit + 3) % SuitCount] >= face - 1 &&
+            foundedFaces[(suit + 2) % SuitCount] >= face - 2;
+    }
+
+    // Empty columns and empty foundations are interchangeable, so only the
+    // first of each is worth trying, and shuffling cards between foundations
+    // never helps.
+    int FilterMoves(State const& state, Move const& applied, uint8_t rules, Move* moves, int count, PruneCounts& pruned)
+    {
+        auto isRepeatable = (rules & RepeatColumnMoves) &&
+            IsColumn(applied.From) && IsColumn(applied.To) &&
+            !(applied.Flags & MoveFlags::RevealsCard);
+
+        auto firstEmptyColumn = -1;
+        for (auto column = 0; column < ColumnCount && firstEmptyColumn < 0; column++)
+        {
+            if (state.ColumnSize(column) == 0)
+            {
+                firstEmptyColumn = column;
+            }
+        }
+        auto firstEmptyFoundation = -1;
+        for (auto foundation = 0; foundation < FoundationCount && firstEmptyFoundation < 0; foundation++)
+        {
+            if (state.FoundationSize(foundation) == 0)
+            {
+                firstEmptyFoundation = foundation;
+            }
+        }
+
+        auto kept = 0;
+        for (auto i = 0; i < count; i++)
+        {
+            auto move = moves[i];
+            if (IsColumn(move.To) &&
+                state.ColumnSize(move.To - FirstColumn) == 0 &&
+                move.To - FirstColumn != firstEmptyColumn)
+            {
+                continue;
+            }
+            if ((rules & KingsBetweenEmptyColumns) &&
+                IsColumn(move.From) && IsColumn(move.To) &&
+                state.ColumnSize(move.To - FirstColumn) == 0 &&
+                move.Count == state.ColumnSize(move.From - FirstColumn))
+            {
+                pruned.KingsBetweenEmptyColumns++;
+                continue;
+            }
+            if (isRepeatable &&
+                move.From == applied.To && IsColumn(move.To) &&
+                move.Count == applied.Count)
+            {
+                pruned.RepeatColumnMoves++;
+                continue;
+            }
+            if (IsFoundation(move.To))
+            {
+                if (IsFoundation(move.From))
+                {
+                    continue;
+                }
+                if (state.FoundationSize(move.To - FirstFoundation) == 0 &&
+                    move.To - FirstFoundation != firstEmptyFoundation)
+                {
+                    continue;
+                }
+            }
+            moves[kept++] = move;
+        }
+
+        if (rules & SafeFoundationMoves)
+        {
+            for (auto i = 0; i < kept; i++)
+            {
+                auto move = moves[i];
+                if (IsColumn(move.From) && IsFoundation(move.To))
+                {
+                    auto column = move.From - FirstColumn;
+                    if (IsSafeToFound(state, state.ColumnCard(column, state.ColumnSize(column) - 1)))
+                    {
+                        pruned.SafeFoundationMoves += kept - 1;
+                        moves[0] = move;
+                        return 1;
+                    }
+                }
+            }
+        }
+        return kept;
+    }
+
+    SolveResult Solver::Solve(State const& start)
+    {
+        auto startTime = std::chrono::steady_clock::now();
+
+        SolveResult result;
+        m_transpositions.Clear();
+        m_frames.clear();
+        m_moves.clear();
+
+        Move generated[MaxMoves];
+        auto state = start;
+        auto pushFrame = [&](Move applied)
+        {
+            auto count = FilterMoves(state, applied, m_options.Pruning, generated, GenerateMoves(state, generated, m_options.Stock), result.Pruned);
+            Frame frame;
+            frame.Begin = (uint32_t)m_moves.size();
+            frame.End = frame.Begin + count;
+            frame.Next = frame.Begin;
+            frame.Applied = applied;
+            m_moves.insert(m_moves.end(), generated, generated + count);
+            m_frames.push_back(frame);
+        };
+
+        m_transpositions.Insert(state.Key(), 0);
+        pushFrame({});
+
+        auto isDecided = state.IsWon();
+        while (!isDecided && !m_frames.empty())
+        {
+            auto& frame = m_frames.back();
+            if (frame.Next == frame.End)
+            {
+                if (m_frames.size() > 1)
+                {
+                    state.Revert(frame.Applied);
+                }
+                m_moves.resize(frame.Begin);
+                m_frames.pop_back();
+                continue;
+            }
+
+            if (result.Nodes >= m_options.MaxNodes)
+            {
+                break;
+            }
+
+            auto move = state.Apply(m_moves[frame.Next++]);
+            if (!m_transpositions.Insert(state.Key(), (int)m_frames.size()))
+            {
+                result.Transpositions++;
+                state.Revert(move);
+                continue;
+            }
+            result.Nodes++;
+
+            if (state.IsWon())
+            {
+                m_frames.push_back({ 0, 0, 0, move });
+                isDecided = true;
+                break;
+            }
+            pushFrame(move);
+        }
+
+        if (isDecided)
+        {
+            result.Status = SolveStatus::Winnable;
+            for (size_t i = 1; i < m_frames.size(); i++)
+            {
+                result.Moves.push_back(m_frames[i].Applied);
+            }
+        }
+        else if (m_frames.empty())
+        {
+            result.Status = SolveStatus::Unwinnable;
+        }
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+        result.Seconds = elapsed.count();
+        return result;
+    }
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Klondike.h"
+#include "Deal.h"
+#include "MoveGenerator.h"
+#include "TranspositionTable.h"
+
+namespace Klondike
+{
+    enum class SolveStatus
+    {
+        Winnable,
+        Unwinnable,
+        // The search ran out of nodes before it could decide.
+        Unknown
+    };
+
+    // Pruning rules that can be switched off one at a time, to measure what
+    // each one is worth. Moves to empty columns and foundations other than
+    // the first, and moves between foundations, are always dropped.
+    enum PruneRules : uint8_t
+    {
+        NoPruneRules = 0,
+        // A column card that no other card will need to stack on goes to its
+        // foundation as the only move tried: aces, twos, and cards whose
+        // predecessors of the other colour are both founded, as is the card
+        // two lower in the other suit of its colour. Waste cards are left out,
+        // as taking one changes how the rest of the stock draws.
+        SafeFoundationMoves = 1,
+        // A whole column is never moved to an empty one.
+        KingsBetweenEmptyColumns = 2,
+        // Cards just moved between columns, without turning a card over,
+        // aren't moved straight on to another column or back again. Either
+        // could have been done in one move or none.
+        RepeatColumnMoves = 4,
+        AllPruneRules = SafeFoundationMoves | KingsBetweenEmptyColumns | RepeatColumnMoves
+    };
+
+    // How many moves each rule dropped. For safe foundation moves it's the
+    // moves that would have been tried alongside them.
+    struct PruneCounts
+    {
+        uint64_t SafeFoundationMoves = 0;
+        uint64_t KingsBetweenEmptyColumns = 0;
+        uint64_t RepeatColumnMoves = 0;
+
+        PruneCounts& operator+=(PruneCounts const& other)
+        {
+            SafeFoundationMoves += other.SafeFoundationMoves;
+            KingsBetweenEmptyColumns += other.KingsBetweenEmptyColumns;
+            RepeatColumnMoves += other.RepeatColumnMoves;
+            return *this;
+        }
+    };
+
+    struct SolveOptions
+    {
+        uint64_t MaxNodes = 5000000;
+        // The most memory the transposition table can take. Past that the
+        // search forgets positions and may end up searching some twice.
+        size_t TableBytes = 64 << 20;
+        // Only ParallelSolver uses more than the calling thread. 0 is one
+        // thread per core.
+        unsigned int ThreadCount = 0;
+        uint8_t Pruning = AllPruneRules;
+        StockMoves Stock = StockMoves::Plays;
+    };
+
+    struct SolveResult
+    {
+        SolveStatus Status = SolveStatus::Unknown;
+        // The moves that win the game, only filled in when it is winnable.
+        // With stock plays these stand in for the draws before them.
+        std::vector<Move> Moves;
+        uint64_t Nodes = 0;
+        // Positions reached again and skipped, by way of the transposition
+        // table.
+        uint64_t Transpositions = 0;
+        PruneCounts Pruned;
+        double Seconds = 0;
+
+        double NodesPerSecond() const { return Seconds > 0 ? Nodes / Seconds : 0; }
+    };
+
+    // Drops moves that lead to a position equivalent to one of its siblings,
+    // or that the prune rules say aren't worth trying, and returns how many
+    // are left. The kept moves stay in order. Applied is the move that led to
+    // the position, with its Count and Flags filled in.
+    int FilterMoves(State const& state, Move const& applied, uint8_t rules, Move* moves, int count, PruneCounts& pruned);
+
+    // Depth first search over a single deal. Positions already seen are kept
+    // in a transposition table so the search doesn't expand them twice.
+    class Solver
+    {
+    public:
+        Solver(SolveOptions options = {}) : m_options(options), m_transpositions(options.TableBytes) {}
+
+        SolveResult Solve(State const& state);
+        SolveResult Solve(ShuffleSeed seed) { return Solve(Deal(seed)); }
+
+    private:
+        // Moves for every position on the current path live in one flat
+        // list, each frame owns the slice [Begin, End).
+        struct Frame
+        {
+            uint32_t Begin = 0;
+            uint32_t End = 0;
+            uint32_t Next = 0;
+            // The move that led to this position.
+            Move Applied;
+        };
+
+        SolveOptions m_options;
+        TranspositionTable m_transpositions;
+        std::vector<Frame> m_frames;
+        std::vector<Move> m_moves;
+    };
+}
@@ -0,0 +1,99 @@
+#include <algorithm>
+#include "TranspositionTable.h"
+
+namespace Klondike
+{
+    TranspositionTable::TranspositionTable(size_t bytes)
+    {
+        m_bucketCount = MinBuckets;
+        while (m_bucketCount * 2 * BucketBytes <= bytes)
+        {
+            m_bucketCount *= 2;
+        }
+        m_shift = 64;
+        for (auto count = m_bucketCount; count > 1; count /= 2)
+        {
+            m_shift--;
+        }
+        m_buckets = std::make_unique<Bucket[]>(m_bucketCount);
+        for (size_t i = 0; i < m_bucketCount; i++)
+        {
+            for (auto& entry : m_buckets[i].Entries)
+            {
+                entry.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void TranspositionTable::Clear()
+    {
+        if (++m_generation < GenerationCount)
+        {
+            return;
+        }
+
+        // Out of generations, old entries could pass for new ones.
+        m_generation = 1;
+        for (size_t i = 0; i < m_bucketCount; i++)
+        {
+            for (auto& entry : m_buckets[i].Entries)
+            {
+                entry.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool TranspositionTable::Contains(uint64_t key) const
+    {
+        auto& bucket = m_buckets[BucketOf(key)];
+        auto tag = TagOf(key);
+        for (auto& slot : bucket.Entries)
+        {
+            auto entry = slot.load(std::memory_order_relaxed);
+            if ((entry & KeyMask) == tag && IsCurrent(entry))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool TranspositionTable::Insert(uint64_t key, int depth)
+    {
+        auto& bucket = m_buckets[BucketOf(key)];
+        auto tag = TagOf(key);
+        auto stored = tag | (m_generation << GenerationShift) | (uint64_t)std::min(depth, MaxDepth);
+        while (true)
+        {
+            // Empty and stale entries go before any current one.
+            auto victim = 0;
+            auto victimDepth = -1;
+            uint64_t victimEntry = 0;
+            for (auto i = 0; i < BucketEntries; i++)
+            {
+                auto entry = bucket.Entries[i].load(std::memory_order_relaxed);
+                auto entryDepth = MaxDepth + 1;
+                if (IsCurrent(entry))
+                {
+                    if ((entry & KeyMask) == tag)
+                    {
+                        return false;
+                    }
+                    entryDepth = (int)(entry & ((1 << GenerationShift) - 1));
+                }
+                if (entryDepth > victimDepth)
+                {
+                    victim = i;
+                    victimDepth = entryDepth;
+                    victimEntry = entry;
+                }
+            }
+
+            // Another thread got to the entry first, look again.
+            if (bucket.Entries[victim].compare_exchange_weak(victimEntry, stored, std::memory_order_relaxed))
+            {
+                return true;
+            }
+        }
+    }
+}
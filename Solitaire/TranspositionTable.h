@@ -0,0 +1,72 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace Klondike
+{
+    // The positions a search has been to, in a fixed amount of memory. Entries
+    // are grouped in buckets of one cache line, and probing or storing is a
+    // few atomic operations on one bucket, so any number of threads can share
+    // a table without locks.
+    //
+    // Once a bucket is full a new position replaces the deepest one in it.
+    // The deeper a position the smaller the subtree under it tends to be, so
+    // it's the cheapest to search again if it comes back. Positions near the
+    // root, including the path the search is on, are kept the longest.
+    //
+    // Each entry keeps 48 bits of the key from below the ones that picked its
+    // bucket, with the depth it was stored at and the generation of the table
+    // it belongs to. Clearing the table only moves on to the next generation,
+    // so a solver can reuse one table for many deals without wiping it every
+    // time.
+    class TranspositionTable
+    {
+    public:
+        static constexpr int BucketEntries = 8;
+        static constexpr size_t BucketBytes = BucketEntries * sizeof(uint64_t);
+        static constexpr int MaxDepth = (1 << 10) - 1;
+        static constexpr size_t MinBuckets = 64;
+
+        // Uses the largest power of two number of buckets that fits in bytes,
+        // and never less than MinBuckets.
+        explicit TranspositionTable(size_t bytes);
+
+        TranspositionTable(TranspositionTable const&) = delete;
+        TranspositionTable& operator=(TranspositionTable const&) = delete;
+
+        void Clear();
+        bool Contains(uint64_t key) const;
+        // Returns false if the position was already there. Depths past
+        // MaxDepth are stored as MaxDepth.
+        bool Insert(uint64_t key, int depth);
+
+        size_t Bytes() const { return m_bucketCount * BucketBytes; }
+        size_t BucketCount() const { return m_bucketCount; }
+        // Buckets are picked by the top bits of the key, so keys that share
+        // their top bits land in one run of buckets.
+        size_t BucketOf(uint64_t key) const { return (size_t)(key >> m_shift); }
+
+    private:
+        static constexpr uint64_t KeyMask = ~0xffffull;
+        static constexpr int GenerationShift = 10;
+        // Keys in a bucket already share their top bits, so the entry keeps
+        // the next 48 down.
+        uint64_t TagOf(uint64_t key) const { return (key << (64 - m_shift)) & KeyMask; }
+        static constexpr uint64_t GenerationCount = 1 << 6;
+
+        struct alignas(64) Bucket
+        {
+            std::atomic<uint64_t> Entries[BucketEntries];
+        };
+
+        bool IsCurrent(uint64_t entry) const { return ((entry & ~KeyMask) >> GenerationShift) == m_generation; }
+
+        std::unique_ptr<Bucket[]> m_buckets;
+        size_t m_bucketCount = 0;
+        int m_shift = 0;
+        // Zero is left for entries that have never been written.
+        uint64_t m_generation = 1;
+    };
+}
@@ -1,116 +1,68 @@
-#include "pch.h"
+#include <cassert>
 #include "Card.h"
-#include "CompositionCard.h"
-#include "ShapeCache.h"
+#include "Klondike.h"
+#include "PileLayout.h"
 #include "Waste.h"
-
-namespace winrt
-{
-    using namespace Windows;
-    using namespace Windows::ApplicationModel::Core;
-    using namespace Windows::Foundation;
-    using namespace Windows::Foundation::Numerics;
-    using namespace Windows::UI;
-    using namespace Windows::UI::Core;
-    using namespace Windows::UI::Composition;
-}
+#include "ItemContainerPool.h"
 
 void Waste::SetLayoutOptions(float horizontalOffset)
 {
-    m_horizontalOffset = horizontalOffset;
+    if (m_horizontalOffset != horizontalOffset)
+    {
+        m_horizontalOffset = horizontalOffset;
+        InvalidateLayout();
+    }
 }
 
 Pile::CardList Waste::Flush()
 {
-    for (auto& container : m_itemContainers)
-    {
-        container.Content.Children().RemoveAll();
-    }
+    m_itemContainerPool->Release(m_itemContainers);
     m_itemContainers.clear();
-    m_children.RemoveAll();
 
-    std::vector<std::shared_ptr<CompositionCard>> result(
-        std::make_move_iterator(m_cards.rbegin()),
-        std::make_move_iterator(m_cards.rend()));
-    m_cards.erase(m_cards.begin(), m_cards.end());
+    Pile::CardList result;
+    for (auto card = m_cards.rbegin(); card != m_cards.rend(); card++)
+    {
+        result.push_back(*card);
+    }
+    m_cards.clear();
+    m_version++;
 
     return result;
 }
 
-void Waste::Discard(Pile::CardList const& cards)
+void Waste::Discard(CardSpan cards)
 {
-    auto numCardsBefore = m_cards.size();
-    // All cards should be in the stack now. Only the cards we add will be fanned out.
-    auto count = 0;
-    for (auto container = m_itemContainers.rbegin(); container != m_itemContainers.rend() && count < 3; container++, count++)
-    {
-        container->Root.Offset({ 0, 0, 0 });
-    }
+    // The cards fanned out so far fold back under the ones we add.
+    InvalidateLayout((int)m_itemContainers.size() - Layout::WasteFanCount);
     AddInternal(cards);
-    // Force the last three cards to be fanned out, regardless of layout
-    count = 0;
-    for (auto container = m_itemContainers.rbegin(); container != m_itemContainers.rend() && count < 3; container++, count++)
-    {
-        // Since we're walking the list backwards, we have to flip the count
-        // indexRelativeToEnd = (last index) - count
-        container->Root.Offset(ComputeOffset(3 - 1 - count, 3));
-    }
-    WINRT_ASSERT(count == 3);
 }
 
 bool Waste::CanTake(int index)
 {
-    if (m_cards.empty() || index < 0 || index >= m_cards.size())
-    {
-        return false;
-    }
-
-    return true;
+    return Klondike::CanTakeFromWaste(index, m_cards.size());
 }
 
-bool Waste::CanAdd(Pile::CardList const& cards)
+bool Waste::CanAdd(CardSpan cards)
 {
     return false;
 }
 
-winrt::float3 Waste::ComputeOffset(int index, int totalCards)
+Compositing::Vector3 Waste::ComputeOffset(int index, int totalCards)
 {
-    WINRT_ASSERT(index < totalCards);
-    if (index > totalCards - 3)
-    {
-        return { m_horizontalOffset, 0, 0 };
-    }
-    return { 0, 0, 0 };
+    assert(index < totalCards);
+    auto offset = Layout::WasteOffset(index, totalCards, m_horizontalOffset);
+    return { offset.X, offset.Y, 0 };
 }
 
-winrt::float3 Waste::ComputeBaseSpaceOffset(int index, int totalCards)
+Compositing::Vector3 Waste::ComputeBaseSpaceOffset(int index, int totalCards)
 {
-    WINRT_ASSERT(index < totalCards);
-    auto numCardsToFan = 3;
-    if (totalCards < numCardsToFan)
-    {
-        numCardsToFan = totalCards;
-    }
-    if (index > totalCards - numCardsToFan)
-    {
-        return { (index - (totalCards - numCardsToFan)) * m_horizontalOffset, 0, 0 };
-    }
-    return { 0, 0, 0 };
+    assert(index < totalCards);
+    auto offset = Layout::WasteBaseSpaceOffset(index, totalCards, m_horizontalOffset);
+    return { offset.X, offset.Y, 0 };
 }
 
 void Waste::OnRemovalCompleted(Pile::RemovalOperation operation)
 {
-    auto numCardsFromBack = 3;
-    if (m_itemContainers.size() < numCardsFromBack)
-    {
-        numCardsFromBack = m_itemContainers.size();
-    }
-    // Force the last three cards to be fanned out, regardless of layout
-    auto count = 0;
-    for (auto container = m_itemContainers.rbegin(); container != m_itemContainers.rend() && count < numCardsFromBack; container++, count++)
-    {
-        // Since we're walking the list backwards, we have to flip the count
-        // indexRelativeToEnd = (last index) - count
-        container->Root.Offset(ComputeOffset(numCardsFromBack - 1 - count, 3));
-    }
+    // The cards under the ones taken fan back out.
+    InvalidateLayout((int)m_itemContainers.size() - Layout::WasteFanCount);
 }
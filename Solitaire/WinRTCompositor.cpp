@@ -0,0 +1,232 @@
+#include "pch.h"
+#include "AtlasCache.h"
+#include "Card.h"
+#include "ShapeCache.h"
+#include "WinRTCompositor.h"
+
+namespace winrt
+{
+    using namespace Windows::Foundation;
+    using namespace Windows::Foundation::Numerics;
+    using namespace Windows::UI;
+    using namespace Windows::UI::Composition;
+}
+
+namespace Compositing
+{
+    static winrt::ContainerVisual const& Get(Visual& visual)
+    {
+        return static_cast<WinRTVisual&>(visual).Get();
+    }
+
+    static wchar_t const* PropertyName(AnimatableProperty property)
+    {
+        switch (property)
+        {
+        case AnimatableProperty::OffsetX:
+            return L"Offset.X";
+        case AnimatableProperty::OffsetZ:
+            return L"Offset.Z";
+        case AnimatableProperty::RotationAngleInDegrees:
+            return L"RotationAngleInDegrees";
+        }
+        WINRT_ASSERT(false);
+        return L"";
+    }
+
+    void WinRTVisual::OnInsertAtTop(Visual& child)
+    {
+        m_visual.Children().InsertAtTop(Compositing::Get(child));
+    }
+
+    void WinRTVisual::OnInsertAbove(Visual& child, Visual& sibling)
+    {
+        m_visual.Children().InsertAbove(Compositing::Get(child), Compositing::Get(sibling));
+    }
+
+    void WinRTVisual::OnRemove(Visual& child)
+    {
+        m_visual.Children().Remove(Compositing::Get(child));
+    }
+
+    void WinRTVisual::OnRemoveAll()
+    {
+        m_visual.Children().RemoveAll();
+    }
+
+    void WinRTVisual::OnPropertyChanged(Property property)
+    {
+        switch (property)
+        {
+        case Property::Offset:
+            m_visual.Offset({ Offset().X, Offset().Y, Offset().Z });
+            break;
+        case Property::Size:
+            m_visual.Size({ Size().X, Size().Y });
+            break;
+        case Property::RelativeOffsetAdjustment:
+            m_visual.RelativeOffsetAdjustment({ RelativeOffsetAdjustment().X, RelativeOffsetAdjustment().Y, RelativeOffsetAdjustment().Z });
+            break;
+        case Property::RelativeSizeAdjustment:
+            m_visual.RelativeSizeAdjustment({ RelativeSizeAdjustment().X, RelativeSizeAdjustment().Y });
+            break;
+        case Property::AnchorPoint:
+            m_visual.AnchorPoint({ AnchorPoint().X, AnchorPoint().Y });
+            break;
+        case Property::CenterPoint:
+            m_visual.CenterPoint({ CenterPoint().X, CenterPoint().Y, CenterPoint().Z });
+            break;
+        case Property::RotationAxis:
+            m_visual.RotationAxis({ RotationAxis().X, RotationAxis().Y, RotationAxis().Z });
+            break;
+        case Property::RotationAngleInDegrees:
+            m_visual.RotationAngleInDegrees(RotationAngleInDegrees());
+            break;
+        case Property::IsBackfaceVisible:
+            m_visual.BackfaceVisibility(IsBackfaceVisible() ? winrt::CompositionBackfaceVisibility::Visible : winrt::CompositionBackfaceVisibility::Hidden);
+            break;
+        }
+    }
+
+    void WinRTVisual::OnParentForTransform(Visual* visual)
+    {
+        if (visual)
+        {
+            m_visual.ParentForTransform(Compositing::Get(*visual));
+        }
+        else
+        {
+            m_visual.ParentForTransform(nullptr);
+        }
+    }
+
+    void WinRTVisual::OnComment(wchar_t const* comment)
+    {
+        m_visual.Comment(comment);
+    }
+
+    void WinRTVisual::OnAnimate(AnimatableProperty property, std::initializer_list<KeyFrame> keyFrames, TimeSpan duration, TimeSpan delayTime)
+    {
+        auto animation = m_visual.Compositor().CreateScalarKeyFrameAnimation();
+        for (auto& keyFrame : keyFrames)
+        {
+            animation.InsertKeyFrame(keyFrame.Progress, keyFrame.Value);
+        }
+        animation.IterationBehavior(winrt::AnimationIterationBehavior::Count);
+        animation.IterationCount(1);
+        animation.Duration(duration);
+        animation.DelayTime(delayTime);
+        m_visual.StartAnimation(PropertyName(property), animation);
+    }
+
+    WinRTCompositor::WinRTCompositor(winrt::Compositor const& compositor, CardRendering cardRendering)
+    {
+        m_compositor = compositor;
+        m_shapeCache = std::make_shared<ShapeCache>(m_compositor);
+        if (cardRendering == CardRendering::Atlas)
+        {
+            m_atlasCache = std::make_unique<AtlasCache>(m_compositor, m_shapeCache->Outlines());
+        }
+    }
+
+    WinRTCompositor::~WinRTCompositor()
+    {
+    }
+
+    winrt::Visual WinRTCompositor::Unwrap(VisualPtr const& visual)
+    {
+        return Compositing::Get(*visual);
+    }
+
+    float WinRTCompositor::TextHeight()
+    {
+        return m_shapeCache->TextHeight();
+    }
+
+    ResourceCounts WinRTCompositor::Resources() const
+    {
+        auto resources = m_shapeCache->Resources();
+        resources.Shapes += m_cardFaceShapes;
+        if (m_atlasCache)
+        {
+            auto atlasResources = m_atlasCache->Resources();
+            resources.Brushes += atlasResources.Brushes;
+            resources.Surfaces += atlasResources.Surfaces;
+            resources.SurfaceBytes += atlasResources.SurfaceBytes;
+        }
+        return resources;
+    }
+
+    void WinRTCompositor::RasterizationScale(float scale)
+    {
+        if (m_atlasCache)
+        {
+            m_atlasCache->RasterizationScale(scale);
+        }
+    }
+
+    VisualPtr WinRTCompositor::OnCreateContainerVisual()
+    {
+        return std::make_shared<WinRTVisual>(m_counts, m_compositor.CreateContainerVisual());
+    }
+
+    VisualPtr WinRTCompositor::OnCreateShapeVisual(ShapeType shapeType)
+    {
+        if (m_atlasCache && shapeType == ShapeType::Back)
+        {
+            auto spriteVisual = m_compositor.CreateSpriteVisual();
+            spriteVisual.Brush(m_atlasCache->GetBrush(Raster::AtlasBackCell));
+            return std::make_shared<WinRTVisual>(m_counts, spriteVisual);
+        }
+
+        auto visual = m_compositor.CreateShapeVisual();
+        visual.Shapes().Append(m_shapeCache->GetShape(shapeType));
+        return std::make_shared<WinRTVisual>(m_counts, visual);
+    }
+
+    VisualPtr WinRTCompositor::OnCreateCardFaceVisual(::Card card)
+    {
+        if (m_atlasCache)
+        {
+            auto spriteVisual = m_compositor.CreateSpriteVisual();
+            spriteVisual.Brush(m_atlasCache->GetBrush(Raster::CardAtlas::CellOf(card)));
+            return std::make_shared<WinRTVisual>(m_counts, spriteVisual);
+        }
+
+        // Only the two sprites placing the face and suit are the card's own,
+        // the frame, geometry and brushes are shared with the other cards.
+        auto shapeVisual = m_compositor.CreateShapeVisual();
+        shapeVisual.Shapes().Append(m_shapeCache->GetCardFrame());
+
+        auto textBrush = m_shapeCache->GetBrush(card.IsRed() ? BrushType::Crimson : BrushType::Black);
+        auto faceShape = m_compositor.CreateSpriteShape(m_shapeCache->GetFaceGeometry(card.Face()));
+        faceShape.Offset({ 5, 0 });
+        faceShape.FillBrush(textBrush);
+        shapeVisual.Shapes().Append(faceShape);
+
+        auto suitShape = m_compositor.CreateSpriteShape(m_shapeCache->GetSuitGeometry(card.Suit()));
+        suitShape.Offset({ 5 + m_shapeCache->FaceAdvance(card.Face()), 0 });
+        suitShape.FillBrush(textBrush);
+        shapeVisual.Shapes().Append(suitShape);
+        m_cardFaceShapes += 2;
+
+        return std::make_shared<WinRTVisual>(m_counts, shapeVisual);
+    }
+
+    void WinRTCompositor::OnBeginBatch()
+    {
+        WINRT_ASSERT(!m_batch);
+        m_batch = m_compositor.CreateScopedBatch(winrt::CompositionBatchTypes::Animation);
+    }
+
+    void WinRTCompositor::OnEndBatch(std::function<void()> completed)
+    {
+        WINRT_ASSERT(m_batch);
+        m_batch.Completed([completed](auto&& ...)
+            {
+                completed();
+            });
+        m_batch.End();
+        m_batch = nullptr;
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "Compositing.h"
+
+class AtlasCache;
+class ShapeCache;
+
+namespace Compositing
+{
+    // Forwards every change to a real composition visual.
+    class WinRTVisual : public Visual
+    {
+    public:
+        WinRTVisual(OperationCounts& counts, winrt::Windows::UI::Composition::ContainerVisual const& visual) : Visual(counts), m_visual(visual) {}
+
+        winrt::Windows::UI::Composition::ContainerVisual const& Get() const { return m_visual; }
+
+    protected:
+        void OnInsertAtTop(Visual& child) override;
+        void OnInsertAbove(Visual& child, Visual& sibling) override;
+        void OnRemove(Visual& child) override;
+        void OnRemoveAll() override;
+        void OnPropertyChanged(Property property) override;
+        void OnParentForTransform(Visual* visual) override;
+        void OnComment(wchar_t const* comment) override;
+        void OnAnimate(AnimatableProperty property, std::initializer_list<KeyFrame> keyFrames, TimeSpan duration, TimeSpan delayTime) override;
+
+    private:
+        winrt::Windows::UI::Composition::ContainerVisual m_visual{ nullptr };
+    };
+
+    class WinRTCompositor : public Compositor
+    {
+    public:
+        WinRTCompositor(winrt::Windows::UI::Composition::Compositor const& compositor, CardRendering cardRendering = CardRendering::Shapes);
+        ~WinRTCompositor();
+
+        // The composition visual behind one of ours, for hosting the tree.
+        static winrt::Windows::UI::Composition::Visual Unwrap(VisualPtr const& visual);
+
+        float TextHeight() override;
+        ResourceCounts Resources() const override;
+        void RasterizationScale(float scale) override;
+
+    protected:
+        VisualPtr OnCreateContainerVisual() override;
+        VisualPtr OnCreateShapeVisual(ShapeType shapeType) override;
+        VisualPtr OnCreateCardFaceVisual(::Card card) override;
+        void OnBeginBatch() override;
+        void OnEndBatch(std::function<void()> completed) override;
+
+    private:
+        winrt::Windows::UI::Composition::Compositor m_compositor{ nullptr };
+        winrt::Windows::UI::Composition::CompositionScopedBatch m_batch{ nullptr };
+        std::shared_ptr<ShapeCache> m_shapeCache;
+        // Only in atlas mode. Draws from the shape cache's outlines.
+        std::unique_ptr<AtlasCache> m_atlasCache;
+        // The shapes made for each card face, on top of the shared ones.
+        uint64_t m_cardFaceShapes = 0;
+    };
+}
@@ -11,6 +11,7 @@
 #include <winrt/Windows.UI.Composition.h>
 #include <winrt/Windows.UI.Input.h>
 #include <winrt/Windows.UI.Popups.h>
+#include <winrt/Windows.Storage.h>
 
 #include <vector>
 #include <memory>
@@ -0,0 +1,217 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "CardAtlas.h"
+#include "GlyphCache.h"
+#include "MappedFile.h"
+
+struct AtlasOptions
+{
+    std::string GlyphsPath;
+    std::vector<float> Scales;
+    std::string OutputDirectory;
+    std::string GoldenDirectory;
+    int Tolerance = 2;
+};
+
+void PrintUsage()
+{
+    std::fprintf(stderr,
+        "Usage: SolitaireAtlas -glyphs FILE [-scale S]... [-out DIR] [-golden DIR] [-tolerance N]\n"
+        "\n"
+        "Draws the card atlas from a glyph cache the way the app does in atlas mode,\n"
+        "and reports how long each scale took. Images are 32-bit TGA files named\n"
+        "atlas-<scale>.tga.\n"
+        "\n"
+        "  -glyphs FILE     Glyph cache made by SolitaireGlyphs\n"
+        "  -scale S         Scale to draw at, can be repeated (default: every atlas scale)\n"
+        "  -out DIR         Write the images here\n"
+        "  -golden DIR      Compare with the images here and fail if any differ\n"
+        "  -tolerance N     Largest channel difference that still matches (default 2)\n");
+}
+
+bool ParseOptions(int argc, char** argv, AtlasOptions& options)
+{
+    for (auto i = 1; i < argc; i++)
+    {
+        auto hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "-glyphs") == 0 && hasValue)
+        {
+            options.GlyphsPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "-scale") == 0 && hasValue)
+        {
+            auto scale = std::strtof(argv[++i], nullptr);
+            if (scale <= 0)
+            {
+                return false;
+            }
+            options.Scales.push_back(scale);
+        }
+        else if (std::strcmp(argv[i], "-out") == 0 && hasValue)
+        {
+            options.OutputDirectory = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "-golden") == 0 && hasValue)
+        {
+            options.GoldenDirectory = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "-tolerance") == 0 && hasValue)
+        {
+            options.Tolerance = std::atoi(argv[++i]);
+        }
+        else
+        {
+            return false;
+        }
+    }
+    if (options.Scales.empty())
+    {
+        options.Scales.assign(std::begin(Raster::AtlasScales), std::end(Raster::AtlasScales));
+    }
+    return !options.GlyphsPath.empty();
+}
+
+std::string ImageName(float scale)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "atlas-%g.tga", scale);
+    return name;
+}
+
+// TGA wants straight alpha, the atlas is premultiplied.
+std::vector<uint8_t> ToTga(Raster::Image const& image)
+{
+    std::vector<uint8_t> file(18, 0);
+    file[2] = 2;
+    file[12] = (uint8_t)image.Width;
+    file[13] = (uint8_t)(image.Width >> 8);
+    file[14] = (uint8_t)image.Height;
+    file[15] = (uint8_t)(image.Height >> 8);
+    file[16] = 32;
+    // Eight alpha bits, rows top to bottom.
+    file[17] = 0x28;
+    file.reserve(file.size() + image.Pixels.size());
+    for (size_t i = 0; i < image.Pixels.size(); i += 4)
+    {
+        auto alpha = image.Pixels[i + 3];
+        for (auto channel = 0; channel < 3; channel++)
+        {
+            auto value = image.Pixels[i + channel];
+            file.push_back(alpha == 0 ? 0 : (uint8_t)std::min(255, (value * 255 + alpha / 2) / alpha));
+        }
+        file.push_back(alpha);
+    }
+    return file;
+}
+
+bool WriteFile(std::string const& path, std::vector<uint8_t> const& data)
+{
+    auto output = std::fopen(path.c_str(), "wb");
+    if (!output)
+    {
+        return false;
+    }
+    auto written = std::fwrite(data.data(), 1, data.size(), output);
+    std::fclose(output);
+    return written == data.size();
+}
+
+// Pixels with a channel more than the tolerance off, -1 if the golden image
+// can't be read or is another size.
+int64_t CompareWithGolden(std::string const& path, std::vector<uint8_t> const& tga, int tolerance, int& largestDifference)
+{
+    MappedFile golden;
+    if (!golden.Open(path.c_str()) ||
+        golden.Size() != tga.size() ||
+        std::memcmp(golden.Data(), tga.data(), 18) != 0)
+    {
+        return -1;
+    }
+
+    int64_t differing = 0;
+    largestDifference = 0;
+    for (size_t i = 18; i < tga.size(); i += 4)
+    {
+        auto pixelDifference = 0;
+        for (auto channel = 0; channel < 4; channel++)
+        {
+            pixelDifference = std::max(pixelDifference, std::abs(golden.Data()[i + channel] - tga[i + channel]));
+        }
+        largestDifference = std::max(largestDifference, pixelDifference);
+        if (pixelDifference > tolerance)
+        {
+            differing++;
+        }
+    }
+    return differing;
+}
+
+int main(int argc, char** argv)
+{
+    AtlasOptions options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    MappedFile glyphsFile;
+    if (!glyphsFile.Open(options.GlyphsPath.c_str()))
+    {
+        std::fprintf(stderr, "Couldn't open %s\n", options.GlyphsPath.c_str());
+        return 1;
+    }
+    Layout::GlyphCacheReader reader(glyphsFile.Data(), glyphsFile.Size());
+    Layout::CardOutlines outlines;
+    if (!reader.IsValid() || !Layout::ReadCardOutlines(reader, outlines))
+    {
+        std::fprintf(stderr, "%s is not a glyph cache with every card face and suit\n", options.GlyphsPath.c_str());
+        return 1;
+    }
+
+    Raster::CardAtlas atlas(outlines);
+    Raster::Image image;
+    auto failed = false;
+    for (auto scale : options.Scales)
+    {
+        auto startTime = std::chrono::steady_clock::now();
+        atlas.Render(scale, image);
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - startTime;
+        std::printf("scale %g: %dx%d, %.2fms", scale, image.Width, image.Height, elapsed.count());
+
+        auto tga = ToTga(image);
+        auto name = ImageName(scale);
+        if (!options.GoldenDirectory.empty())
+        {
+            int largestDifference;
+            auto differing = CompareWithGolden(options.GoldenDirectory + "/" + name, tga, options.Tolerance, largestDifference);
+            if (differing < 0)
+            {
+                std::printf(", no golden image to compare with");
+                failed = true;
+            }
+            else if (differing > 0)
+            {
+                std::printf(", %lld pixels differ from the golden image, by up to %d", (long long)differing, largestDifference);
+                failed = true;
+            }
+            else
+            {
+                std::printf(", matches the golden image");
+            }
+        }
+        std::printf("\n");
+
+        if (!options.OutputDirectory.empty() && !WriteFile(options.OutputDirectory + "/" + name, tga))
+        {
+            std::fprintf(stderr, "Couldn't write %s\n", name.c_str());
+            return 1;
+        }
+    }
+    return failed ? 1 : 0;
+}
\ No newline at end of file
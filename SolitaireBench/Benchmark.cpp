@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <sstream>
+#include <thread>
+#include "Benchmark.h"
+
+namespace Benchmark
+{
+    std::vector<Registration>& Registry()
+    {
+        static std::vector<Registration> registry;
+        return registry;
+    }
+
+    static std::vector<std::pair<std::string, double>> s_counters;
+    static std::vector<std::pair<std::string, double>> s_budgets;
+
+    static void Set(std::vector<std::pair<std::string, double>>& values, char const* name, double value)
+    {
+        for (auto& entry : values)
+        {
+            if (entry.first == name)
+            {
+                entry.second = value;
+                return;
+            }
+        }
+        values.push_back({ name, value });
+    }
+
+    void SetCounter(char const* name, double value)
+    {
+        Set(s_counters, name, value);
+    }
+
+    void SetBudget(char const* name, double limit)
+    {
+        Set(s_budgets, name, limit);
+    }
+
+    std::vector<std::pair<std::string, double>> OverBudget(Result const& result)
+    {
+        std::vector<std::pair<std::string, double>> over;
+        for (auto& budget : result.Budgets)
+        {
+            for (auto& counter : result.Counters)
+            {
+                if (counter.first == budget.first && counter.second > budget.second)
+                {
+                    over.push_back(counter);
+                }
+            }
+        }
+        return over;
+    }
+
+    struct Sample
+    {
+        double RealSeconds = 0;
+        double CpuSeconds = 0;
+        uint64_t Items = 0;
+    };
+
+    static Sample Measure(Function run, uint64_t iterations)
+    {
+        s_counters.clear();
+        s_budgets.clear();
+        auto cpuStart = std::clock();
+        auto realStart = std::chrono::steady_clock::now();
+        auto items = run(iterations);
+        std::chrono::duration<double> real = std::chrono::steady_clock::now() - realStart;
+        auto cpuEnd = std::clock();
+
+        Sample sample;
+        sample.RealSeconds = real.count();
+        sample.CpuSeconds = (double)(cpuEnd - cpuStart) / CLOCKS_PER_SEC;
+        sample.Items = items * iterations;
+        return sample;
+    }
+
+    static double Median(std::vector<double> values)
+    {
+        std::sort(values.begin(), values.end());
+        auto middle = values.size() / 2;
+        return values.size() % 2 ? values[middle] : (values[middle - 1] + values[middle]) / 2;
+    }
+
+    static Result RunOne(Registration const& registration, Options const& options)
+    {
+        // Grow the iteration count until one run takes long enough to time.
+        uint64_t iterations = 1;
+        auto sample = Measure(registration.Run, iterations);
+        while (sample.RealSeconds < options.MinSeconds && iterations < (1ull << 40))
+        {
+            auto scale = sample.RealSeconds > 0 ? options.MinSeconds * 1.4 / sample.RealSeconds : 100.0;
+            iterations = (uint64_t)(iterations * std::min(std::max(scale, 2.0), 100.0));
+            sample = Measure(registration.Run, iterations);
+        }
+
+        std::vector<double> realTimes;
+        std::vector<double> cpuTimes;
+        std::vector<double> itemRates;
+        for (auto i = 0; i < std::max(1, options.Repetitions); i++)
+        {
+            if (i > 0)
+            {
+                sample = Measure(registration.Run, iterations);
+            }
+            realTimes.push_back(sample.RealSeconds * 1e9 / iterations);
+            cpuTimes.push_back(sample.CpuSeconds * 1e9 / iterations);
+            itemRates.push_back(sample.RealSeconds > 0 ? sample.Items / sample.RealSeconds : 0);
+        }
+
+        Result result;
+        result.Name = registration.Name;
+        result.Iterations = iterations;
+        result.RealTime = Median(realTimes);
+        result.CpuTime = Median(cpuTimes);
+        result.ItemsPerSecond = Median(itemRates);
+        result.Counters = s_counters;
+        result.Budgets = s_budgets;
+        return result;
+    }
+
+    std::vector<Result> RunAll(Options const& options)
+    {
+        std::vector<Result> results;
+        for (auto& registration : Registry())
+        {
+            if (std::string(registration.Name).find(options.Filter) == std::string::npos)
+            {
+                continue;
+            }
+            results.push_back(RunOne(registration, options));
+        }
+        return results;
+    }
+
+    std::string ToJson(std::vector<Result> const& results, Options const& options)
+    {
+        auto now = std::time(nullptr);
+        std::tm local = {};
+#ifdef _WIN32
+        localtime_s(&local, &now);
+#else
+        localtime_r(&now, &local);
+#endif
+        char date[32] = {};
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", &local);
+
+        std::ostringstream json;
+        json.precision(17);
+        json << "{\n";
+        json << "  \"context\": {\n";
+        json << "    \"date\": \"" << date << "\",\n";
+        json << "    \"commit\": \"" << options.Commit << "\",\n";
+        json << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n";
+#ifdef NDEBUG
+        json << "    \"library_build_type\": \"release\"\n";
+#else
+        json << "    \"library_build_type\": \"debug\"\n";
+#endif
+        json << "  },\n";
+        json << "  \"benchmarks\": [";
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            auto& result = results[i];
+            json << (i == 0 ? "\n" : ",\n");
+            json << "    {\n";
+            json << "      \"name\": \"" << result.Name << "\",\n";
+            json << "      \"run_name\": \"" << result.Name << "\",\n";
+            json << "      \"run_type\": \"aggregate\",\n";
+            json << "      \"aggregate_name\": \"median\",\n";
+            json << "      \"repetitions\": " << options.Repetitions << ",\n";
+            json << "      \"iterations\": " << result.Iterations << ",\n";
+            json << "      \"real_time\": " << result.RealTime << ",\n";
+            json << "      \"cpu_time\": " << result.CpuTime << ",\n";
+            json << "      \"time_unit\": \"ns\",\n";
+            json << "      \"items_per_second\": " << result.ItemsPerSecond;
+            for (auto& counter : result.Counters)
+            {
+                json << ",\n      \"" << counter.first << "\": " << counter.second;
+            }
+            json << "\n";
+            json << "    }";
+        }
+        json << "\n  ]\n";
+        json << "}\n";
+        return json.str();
+    }
+}
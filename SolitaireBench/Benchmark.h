@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+// A small benchmark runner in the spirit of Google Benchmark, with no
+// dependencies so it builds wherever the engine does. Results are written in
+// Google Benchmark's JSON layout so the usual comparison tools can read them.
+namespace Benchmark
+{
+    // Runs the measured work the given number of times. Returns the number of
+    // items processed per iteration, used to report items per second.
+    using Function = uint64_t (*)(uint64_t iterations);
+
+    struct Registration
+    {
+        char const* Name;
+        Function Run;
+    };
+
+    struct Result
+    {
+        std::string Name;
+        uint64_t Iterations = 0;
+        // Median over the repetitions, in nanoseconds per iteration.
+        double RealTime = 0;
+        double CpuTime = 0;
+        double ItemsPerSecond = 0;
+        std::vector<std::pair<std::string, double>> Counters;
+        // The limits set on counters, a counter above its limit fails the run.
+        std::vector<std::pair<std::string, double>> Budgets;
+    };
+
+    struct Options
+    {
+        std::string Filter;
+        double MinSeconds = 0.2;
+        int Repetitions = 5;
+        std::string Commit;
+    };
+
+    std::vector<Registration>& Registry();
+
+    struct Registrar
+    {
+        Registrar(char const* name, Function run) { Registry().push_back({ name, run }); }
+    };
+
+    // Reports a figure per iteration alongside the timings, such as the
+    // compositor calls the work makes. Call it from the benchmark function,
+    // the value from the last measurement is kept.
+    void SetCounter(char const* name, double value);
+    // Sets the most a counter may come to, such as the compositor calls a
+    // draw is allowed, so that a change that adds churn fails the run rather
+    // than only showing up in the numbers.
+    void SetBudget(char const* name, double limit);
+    // The counters of a result that went over their budget.
+    std::vector<std::pair<std::string, double>> OverBudget(Result const& result);
+
+    std::vector<Result> RunAll(Options const& options);
+    std::string ToJson(std::vector<Result> const& results, Options const& options);
+
+    // Keeps the compiler from optimizing away a value it can prove is unused.
+    template <typename T>
+    inline void DoNotOptimize(T const& value)
+    {
+#if defined(_MSC_VER) && !defined(__clang__)
+        static volatile char const* sink;
+        sink = reinterpret_cast<char const volatile*>(&value);
+        _ReadWriteBarrier();
+#else
+        asm volatile("" : : "r,m"(value) : "memory");
+#endif
+    }
+}
+
+#define BENCHMARK_CONCAT_INNER(a, b) a##b
+#define BENCHMARK_CONCAT(a, b) BENCHMARK_CONCAT_INNER(a, b)
+#define BENCHMARK(name, function) \
+    static Benchmark::Registrar BENCHMARK_CONCAT(s_benchmark, __LINE__)(name, function)
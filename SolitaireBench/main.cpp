@@ -0,0 +1,919 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "Benchmark.h"
+#include "Card.h"
+#include "CardAtlas.h"
+#include "CardStack.h"
+#include "CompositionCard.h"
+#include "Deal.h"
+#include "Deck.h"
+#include "GlyphCache.h"
+#include "HitTestIndex.h"
+#include "ItemContainerPool.h"
+#include "Klondike.h"
+#include "MoveGenerator.h"
+#include "PileLayout.h"
+#include "RecordingCompositor.h"
+#include "Waste.h"
+
+// Inputs are generated once up front so the timed loops only do the work
+// being measured. Every loop walks a table of inputs rather than repeating one
+// value, so branch prediction sees a realistic mix.
+constexpr size_t InputCount = 4096;
+constexpr float VerticalOffset = 40.0f;
+constexpr float HorizontalOffset = 40.0f;
+
+struct Inputs
+{
+    std::vector<Klondike::ShuffleSeed> Seeds;
+    std::vector<Klondike::CardOrder> Orders;
+    std::vector<std::pair<Card, Card>> CardPairs;
+    std::vector<Klondike::State> States;
+    std::vector<Klondike::Move> Moves;
+    std::vector<Layout::Point> ColumnPoints;
+    std::vector<Layout::Point> WastePoints;
+    std::vector<std::pair<int, int>> WasteIndices;
+
+    Inputs()
+    {
+        for (auto i = 0u; i < InputCount; i++)
+        {
+            Seeds.push_back({ i, 0, 0, 0 });
+        }
+        Orders.resize(InputCount);
+        Klondike::ShuffleCards(Seeds.data(), Seeds.size(), Orders.data());
+
+        for (auto i = 0u; i < InputCount; i++)
+        {
+            auto& order = Orders[i];
+            CardPairs.push_back({ order[0], order[1] });
+        }
+
+        // Positions from a few moves into random games, with every move
+        // tried against every position.
+        std::srand(1);
+        Klondike::Move moves[Klondike::MaxMoves];
+        for (auto i = 0u; i < InputCount / 64; i++)
+        {
+            auto state = Klondike::Deal(Orders[i]);
+            for (auto step = 0; step < 20; step++)
+            {
+                auto count = Klondike::GenerateMoves(state, moves);
+                if (count == 0)
+                {
+                    break;
+                }
+                state.Apply(moves[std::rand() % count]);
+            }
+            States.push_back(state);
+            auto count = Klondike::GenerateMoves(state, moves);
+            Moves.insert(Moves.end(), moves, moves + count);
+        }
+        for (auto i = 0; Moves.size() < InputCount; i++)
+        {
+            Moves.push_back({ (Klondike::Location)(i % Klondike::LocationCount), (Klondike::Location)(i * 7 % Klondike::LocationCount), (uint8_t)(1 + i % 3) });
+        }
+
+        // Points spread over a full 19 card column and a fanned waste, plus
+        // a margin that misses everything.
+        auto columnHeight = Layout::CardHeight + 18 * VerticalOffset;
+        auto wasteWidth = Layout::CardWidth + 2 * HorizontalOffset;
+        for (auto i = 0u; i < InputCount; i++)
+        {
+            auto u = (float)((i * 37) % 101) / 100.0f;
+            auto v = (float)((i * 53) % 103) / 102.0f;
+            ColumnPoints.push_back({ u * Layout::CardWidth * 1.1f, v * columnHeight * 1.1f });
+            WastePoints.push_back({ u * wasteWidth * 1.1f, v * Layout::CardHeight * 1.1f });
+            auto total = 1 + (int)(i % 24);
+            WasteIndices.push_back({ (int)(i * 7 % total), total });
+        }
+    }
+};
+
+static Inputs const& Data()
+{
+    static Inputs inputs;
+    return inputs;
+}
+
+//
+// Shuffling, as done by Pack::Shuffle
+//
+
+static uint64_t ShuffleLegacy(uint64_t iterations)
+{
+    auto& data = Data();
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        auto seed = data.Seeds[i % InputCount];
+        seed.Version = Klondike::ShuffleVersion::Legacy;
+        Benchmark::DoNotOptimize(Klondike::ShuffleCards(seed));
+    }
+    return 1;
+}
+BENCHMARK("Shuffle/Legacy", ShuffleLegacy);
+
+static uint64_t ShufflePortable(uint64_t iterations)
+{
+    auto& data = Data();
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        Benchmark::DoNotOptimize(Klondike::ShuffleCards(data.Seeds[i % InputCount]));
+    }
+    return 1;
+}
+BENCHMARK("Shuffle/Portable", ShufflePortable);
+
+static uint64_t ShuffleBatch(uint64_t iterations)
+{
+    constexpr size_t BatchSize = 1024;
+    static std::vector<Klondike::CardOrder> orders(BatchSize);
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        Klondike::ShuffleCards(Klondike::ShuffleSeed{ (unsigned int)(i * BatchSize), 0, 0, 0 }, BatchSize, orders.data());
+        Benchmark::DoNotOptimize(orders.front());
+    }
+    return BatchSize;
+}
+BENCHMARK("Shuffle/PortableBatch1024", ShuffleBatch);
+
+static uint64_t DealPortable(uint64_t iterations)
+{
+    auto& data = Data();
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        Benchmark::DoNotOptimize(Klondike::Deal(data.Seeds[i % InputCount]));
+    }
+    return 1;
+}
+BENCHMARK("Deal/Portable", DealPortable);
+
+//
+// The rules behind CardStack and Foundation CanAdd and CanSplit
+//
+
+static uint64_t CardStackCanAdd(uint64_t iterations)
+{
+    auto& data = Data();
+    auto count = 0;
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        auto [card, target] = data.CardPairs[i % InputCount];
+        count += Klondike::CanStackOn(card, target) || Klondike::CanStartColumn(card);
+    }
+    Benchmark::DoNotOptimize(count);
+    return 1;
+}
+BENCHMARK("Rules/CardStackCanAdd", CardStackCanAdd);
+
+static uint64_t FoundationCanAdd(uint64_t iterations)
+{
+    auto& data = Data();
+    auto count = 0;
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        auto [card, target] = data.CardPairs[i % InputCount];
+        count += Klondike::CanFoundOn(card, target) || Klondike::CanStartFoundation(card);
+    }
+    Benchmark::DoNotOptimize(count);
+    return 1;
+}
+BENCHMARK("Rules/FoundationCanAdd", FoundationCanAdd);
+
+static uint64_t CardStackCanSplit(uint64_t iterations)
+{
+    auto count = 0;
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        auto size = 1 + (int)(i % Klondike::MaxColumnCards);
+        count += Klondike::CanPickUpFromColumn((int)(i * 7 % size), size, i & 1);
+    }
+    Benchmark::DoNotOptimize(count);
+    return 1;
+}
+BENCHMARK("Rules/CardStackCanSplit", CardStackCanSplit);
+
+static uint64_t FoundationCanSplit(uint64_t iterations)
+{
+    auto count = 0;
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        auto size = 1 + (int)(i % Klondike::CardsPerSuit);
+        count += Klondike::CanPickUpFromFoundation((int)(i * 7 % size), size);
+    }
+    Benchmark::DoNotOptimize(count);
+    return 1;
+}
+BENCHMARK("Rules/FoundationCanSplit", FoundationCanSplit);
+
+static uint64_t StateIsLegal(uint64_t iterations)
+{
+    auto& data = Data();
+    auto count = 0;
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        auto& state = data.States[i % data.States.size()];
+        count += state.IsLegal(data.Moves[i % InputCount]);
+    }
+    Benchmark::DoNotOptimize(count);
+    return 1;
+}
+BENCHMARK("State/IsLegal", StateIsLegal);
+
+static uint64_t StateGenerateMoves(uint64_t iterations)
+{
+    auto& data = Data();
+    Klondike::Move moves[Klondike::MaxMoves];
+    auto count = 0;
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        count += Klondike::GenerateMoves(data.States[i % data.States.size()], moves);
+    }
+    Benchmark::DoNotOptimize(count);
+    return 1;
+}
+BENCHMARK("State/GenerateMoves", StateGenerateMoves);
+
+//
+// Hit testing and layout, as done by Pile::HitTest and the pile overrides of
+// ComputeBaseSpaceOffset
+//
+
+// Pile::HitTest asks the pile for each card's offset through a virtual call.
+struct OffsetSource
+{
+    virtual ~OffsetSource() {}
+    virtual Layout::Point BaseSpaceOffset(int index, int totalCards) = 0;
+};
+
+struct ColumnOffsets : OffsetSource
+{
+    Layout::Point BaseSpaceOffset(int index, int) override { return Layout::ColumnBaseSpaceOffset(index, VerticalOffset); }
+};
+
+struct WasteOffsets : OffsetSource
+{
+    Layout::Point BaseSpaceOffset(int index, int totalCards) override { return Layout::WasteBaseSpaceOffset(index, totalCards, HorizontalOffset); }
+};
+
+static uint64_t HitTest(OffsetSource& pile, std::vector<Layout::Point> const& points, int totalCards, uint64_t iterations)
+{
+    auto sum = 0;
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        sum += Layout::HitTestCards(points[i % InputCount], totalCards, [&](int index)
+        {
+            return pile.BaseSpaceOffset(index, totalCards);
+        });
+    }
+    Benchmark::DoNotOptimize(sum);
+    return 1;
+}
+
+static uint64_t HitTestColumn19(uint64_t iterations)
+{
+    std::unique_ptr<OffsetSource> pile = std::make_unique<ColumnOffsets>();
+    return HitTest(*pile, Data().ColumnPoints, Klondike::MaxColumnCards, iterations);
+}
+BENCHMARK("HitTest/Column19", HitTestColumn19);
+
+static uint64_t HitTestWaste24(uint64_t iterations)
+{
+    std::unique_ptr<OffsetSource> pile = std::make_unique<WasteOffsets>();
+    return HitTest(*pile, Data().WastePoints, Klondike::TalonCapacity, iterations);
+}
+BENCHMARK("HitTest/Waste24", HitTestWaste24);
+
+// A full board laid out the way Game lays it out: the deck, a fanned waste
+// and four foundations along the top, seven full columns below.
+struct BoardPile
+{
+    Layout::Point Origin;
+    int CardCount;
+    std::unique_ptr<OffsetSource> Offsets;
+};
+
+static std::vector<BoardPile> MakeBoard()
+{
+    constexpr float Spacing = Layout::CardWidth + 15.0f;
+    std::vector<BoardPile> piles;
+    for (auto i = 0; i < Klondike::ColumnCount; i++)
+    {
+        piles.push_back({ { i * Spacing, Layout::CardHeight + 25.0f }, Klondike::MaxColumnCards, std::make_unique<ColumnOffsets>() });
+    }
+    for (auto i = 0; i < Klondike::FoundationCount; i++)
+    {
+        piles.push_back({ { 3 * Spacing + i * Spacing, 0 }, Klondike::CardsPerSuit, std::make_unique<ColumnOffsets>() });
+    }
+    piles.push_back({ { Layout::CardWidth + 25.0f, 0 }, Klondike::TalonCapacity, std::make_unique<WasteOffsets>() });
+    return piles;
+}
+
+static std::vector<Layout::Point> MakeBoardPoints()
+{
+    std::vector<Layout::Point> points;
+    for (auto i = 0u; i < InputCount; i++)
+    {
+        auto u = (float)((i * 37) % 101) / 100.0f;
+        auto v = (float)((i * 53) % 103) / 102.0f;
+        points.push_back({ u * 7 * (Layout::CardWidth + 15.0f), v * (2 * Layout::CardHeight + 25.0f + 18 * VerticalOffset) });
+    }
+    return points;
+}
+
+static void BuildIndex(std::vector<BoardPile> const& piles, Layout::HitTestIndex& index)
+{
+    index.Clear();
+    for (auto pile = 0; pile < (int)piles.size(); pile++)
+    {
+        auto& board = piles[pile];
+        index.Add({ board.Origin.X, board.Origin.Y, Layout::CardWidth, Layout::CardHeight }, pile, Layout::HitTestIndex::Base);
+        for (auto card = 0; card < board.CardCount; card++)
+        {
+            auto offset = board.Offsets->BaseSpaceOffset(card, board.CardCount);
+            index.Add({ board.Origin.X + offset.X, board.Origin.Y + offset.Y, Layout::CardWidth, Layout::CardHeight }, pile, card);
+        }
+    }
+    index.Build();
+}
+
+// What Game did before the index: every pile in turn, every card from the
+// top down, then the pile base.
+static uint64_t HitTestBoardScan(uint64_t iterations)
+{
+    auto piles = MakeBoard();
+    auto points = MakeBoardPoints();
+    auto sum = 0;
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        auto point = points[i % InputCount];
+        for (auto pile = 0; pile < (int)piles.size(); pile++)
+        {
+            auto& board = piles[pile];
+            Layout::Point local{ point.X - board.Origin.X, point.Y - board.Origin.Y };
+            auto card = Layout::HitTestCards(local, board.CardCount, [&](int index)
+            {
+                return board.Offsets->BaseSpaceOffset(index, board.CardCount);
+            });
+            if (card >= 0 || Layout::IsInCard(local, {}))
+            {
+                sum += pile + card;
+                break;
+            }
+        }
+    }
+    Benchmark::DoNotOptimize(sum);
+    return 1;
+}
+BENCHMARK("HitTest/BoardScan", HitTestBoardScan);
+
+static uint64_t HitTestBoardIndex(uint64_t iterations)
+{
+    auto piles = MakeBoard();
+    auto points = MakeBoardPoints();
+    Layout::HitTestIndex index;
+    BuildIndex(piles, index);
+    auto sum = 0;
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        auto hit = index.Find(points[i % InputCount]);
+        sum += hit.Pile + hit.Card;
+    }
+    Benchmark::DoNotOptimize(sum);
+    return 1;
+}
+BENCHMARK("HitTest/BoardIndex", HitTestBoardIndex);
+
+static uint64_t HitTestBoardIndexBuild(uint64_t iterations)
+{
+    auto piles = MakeBoard();
+    Layout::HitTestIndex index;
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        BuildIndex(piles, index);
+        Benchmark::DoNotOptimize(index.CellCount());
+    }
+    return 1;
+}
+BENCHMARK("HitTest/BoardIndexBuild", HitTestBoardIndexBuild);
+
+static uint64_t WasteBaseSpaceOffset(uint64_t iterations)
+{
+    auto& data = Data();
+    auto sum = 0.0f;
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        auto [index, total] = data.WasteIndices[i % InputCount];
+        sum += Layout::WasteBaseSpaceOffset(index, total, HorizontalOffset).X;
+    }
+    Benchmark::DoNotOptimize(sum);
+    return 1;
+}
+BENCHMARK("Layout/WasteBaseSpaceOffset", WasteBaseSpaceOffset);
+
+//
+// Pile bookkeeping
+//
+
+// The real piles and cards, built on a compositor that only records the
+// visual tree and sharing one item container pool, as in a game. Each
+// benchmark reports the compositor calls per iteration next to its timings,
+// and sets a budget on their total a little above what it takes today.
+static std::shared_ptr<Compositing::RecordingCompositor> MakeCompositor()
+{
+    return std::make_shared<Compositing::RecordingCompositor>();
+}
+
+static std::shared_ptr<ItemContainerPool> MakePool(std::shared_ptr<Compositing::RecordingCompositor> const& compositor)
+{
+    return std::make_shared<ItemContainerPool>(compositor);
+}
+
+static std::shared_ptr<CardTable> MakeTable(std::shared_ptr<Compositing::RecordingCompositor> const& compositor)
+{
+    return std::make_shared<CardTable>(compositor);
+}
+
+static Pile::CardList MakeCards(int first, int count)
+{
+    Pile::CardList cards;
+    for (auto i = first; i < first + count; i++)
+    {
+        cards.push_back((CardHandle)i);
+    }
+    return cards;
+}
+
+static std::shared_ptr<CardStack> MakeColumn(
+    std::shared_ptr<Compositing::RecordingCompositor> const& compositor,
+    std::shared_ptr<ItemContainerPool> const& pool,
+    std::shared_ptr<CardTable> const& table,
+    int first,
+    int size,
+    Layout::PileMode mode = Layout::PileMode::Nested)
+{
+    auto cards = MakeCards(first, size);
+    for (auto card : cards)
+    {
+        (*table)[card].IsFaceUp(true);
+    }
+    auto stack = std::make_shared<CardStack>(compositor, pool, table, cards);
+    stack->SetLayoutOptions(VerticalOffset);
+    stack->SetLayoutMode(mode);
+    stack->UpdateLayout();
+    return stack;
+}
+
+static void ReportCounts(Compositing::OperationCounts const& counts, uint64_t iterations)
+{
+    Benchmark::SetCounter("creates", (double)counts.Creates / iterations);
+    Benchmark::SetCounter("inserts", (double)counts.Inserts / iterations);
+    Benchmark::SetCounter("removes", (double)counts.Removes / iterations);
+    Benchmark::SetCounter("property_sets", (double)counts.PropertySets / iterations);
+    Benchmark::SetCounter("animations", (double)counts.Animations / iterations);
+    Benchmark::SetCounter("calls", (double)counts.Total() / iterations);
+}
+
+static void ReportLayoutCounts(Layout::LayoutCounts const& counts, uint64_t iterations)
+{
+    Benchmark::SetCounter("layout_checked", (double)counts.ContainersChecked / iterations);
+    Benchmark::SetCounter("layout_moved", (double)counts.OffsetsChanged / iterations);
+    Benchmark::SetCounter("layout_transformed", (double)counts.ContainersTransformed / iterations);
+}
+
+// Levels of visuals from a pile's base down to its deepest card.
+static int TreeDepth(Compositing::Visual const& visual)
+{
+    auto depth = 0;
+    for (auto& child : visual.Children())
+    {
+        depth = std::max(depth, TreeDepth(*child));
+    }
+    return depth + 1;
+}
+
+// Dropping a dragged run empties its containers first, as Game does.
+static void EmptyContainers(Pile::ItemContainerList const& containers)
+{
+    for (auto& container : containers)
+    {
+        container.Content->RemoveAll();
+    }
+}
+
+// Setting up the table for a new game as Game does, from a fresh pack: seven
+// columns with only their top card face up and the rest in the stock.
+static uint64_t PileDealTable(uint64_t iterations)
+{
+    auto compositor = MakeCompositor();
+    auto pool = MakePool(compositor);
+    auto start = compositor->Counts();
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        auto table = MakeTable(compositor);
+        auto cards = MakeCards(0, 52);
+        std::vector<std::shared_ptr<CardStack>> stacks;
+        auto cardsSoFar = 0;
+        for (auto column = 0; column < Klondike::ColumnCount; column++)
+        {
+            auto columnCards = CardSpan(cards).subspan(cardsSoFar, column + 1);
+            cardsSoFar += column + 1;
+            auto stack = std::make_shared<CardStack>(compositor, pool, table, columnCards);
+            stack->SetLayoutOptions(VerticalOffset);
+            stack->UpdateLayout();
+            for (auto card : columnCards)
+            {
+                (*table)[card].IsFaceUp(false);
+            }
+            (*table)[columnCards.back()].IsFaceUp(true);
+            stacks.push_back(stack);
+        }
+        Deck deck(compositor, table, CardSpan(cards).subspan(cardsSoFar));
+        deck.UpdateLayout();
+        Benchmark::DoNotOptimize(stacks.size() + deck.Cards().size());
+    }
+    ReportCounts(compositor->Counts() - start, iterations);
+    Benchmark::SetBudget("calls", 760);
+    return 1;
+}
+BENCHMARK("Pile/DealTable", PileDealTable);
+
+// Dealing the next game into the same piles with the same cards, as
+// Game::DealCards does after the first game.
+static uint64_t PileRedealTable(uint64_t iterations)
+{
+    auto compositor = MakeCompositor();
+    auto pool = MakePool(compositor);
+    auto table = MakeTable(compositor);
+    std::vector<std::shared_ptr<CardStack>> stacks;
+    for (auto column = 0; column < Klondike::ColumnCount; column++)
+    {
+        stacks.push_back(std::make_shared<CardStack>(compositor, pool, table));
+        stacks.back()->SetLayoutOptions(VerticalOffset);
+    }
+    Deck deck(compositor, table);
+    Klondike::ShuffleSeed seed{ 1, 2, 3, 4 };
+    auto start = compositor->Counts();
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        // Turn the cards over between deals, as playing a game would.
+        auto order = Klondike::ShuffleCards(seed);
+        seed.Num1++;
+        for (CardHandle card = 0; card < CardHandleCount; card++)
+        {
+            (*table)[card].IsFaceUp(true);
+        }
+
+        deck.Clear();
+        for (auto& stack : stacks)
+        {
+            stack->Clear();
+        }
+        auto cardsSoFar = 0;
+        for (auto column = 0; column < Klondike::ColumnCount; column++)
+        {
+            Pile::CardList columnCards;
+            for (auto j = 0; j <= column; j++)
+            {
+                columnCards.push_back(HandleOf(order[cardsSoFar++]));
+                (*table)[columnCards.back()].IsFaceUp(false);
+            }
+            (*table)[columnCards.back()].IsFaceUp(true);
+            stacks[column]->Put(columnCards);
+        }
+        Pile::CardList stock;
+        for (auto j = cardsSoFar; j < 52; j++)
+        {
+            stock.push_back(HandleOf(order[j]));
+        }
+        deck.AddCards(stock);
+    }
+    ReportCounts(compositor->Counts() - start, iterations);
+    // Redealing reuses every visual, only the first deal creates any.
+    Benchmark::SetBudget("creates", 1);
+    Benchmark::SetBudget("calls", 300);
+    return 1;
+}
+BENCHMARK("Pile/RedealTable", PileRedealTable);
+
+// Picking up the top 12 cards of a 19 card column and dropping them back.
+static uint64_t PileSplitReturn(uint64_t iterations)
+{
+    auto compositor = MakeCompositor();
+    auto pool = MakePool(compositor);
+    auto pile = MakeColumn(compositor, pool, MakeTable(compositor), 0, Klondike::MaxColumnCards);
+    auto start = compositor->Counts();
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        auto [containers, cards, operation] = pile->Split(Klondike::MaxColumnCards - 12);
+        EmptyContainers(containers);
+        pile->Return(cards, operation);
+        pool->Release(containers);
+    }
+    ReportCounts(compositor->Counts() - start, iterations);
+    Benchmark::SetBudget("calls", 120);
+    return 1;
+}
+BENCHMARK("Pile/SplitReturn12", PileSplitReturn);
+
+// Moving the top 12 cards of a 19 card column to another column and back.
+static uint64_t PileSplitCompleteRemoval(uint64_t iterations, Layout::PileMode mode)
+{
+    auto compositor = MakeCompositor();
+    auto pool = MakePool(compositor);
+    auto table = MakeTable(compositor);
+    auto from = MakeColumn(compositor, pool, table, 0, Klondike::MaxColumnCards, mode);
+    auto to = MakeColumn(compositor, pool, table, Klondike::MaxColumnCards, 1, mode);
+    Benchmark::SetCounter("depth", TreeDepth(*from->Base()));
+    auto start = compositor->Counts();
+    auto layoutStart = from->LayoutCounts();
+    layoutStart += to->LayoutCounts();
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        auto [containers, cards, operation] = from->Split(Klondike::MaxColumnCards - 12);
+        EmptyContainers(containers);
+        to->Put(cards);
+        from->CompleteRemoval(operation);
+        pool->Release(containers);
+
+        auto [backContainers, backCards, backOperation] = to->Split(1);
+        EmptyContainers(backContainers);
+        from->Put(backCards);
+        to->CompleteRemoval(backOperation);
+        pool->Release(backContainers);
+    }
+    ReportCounts(compositor->Counts() - start, iterations);
+    Benchmark::SetBudget("calls", 330);
+    auto layoutEnd = from->LayoutCounts();
+    layoutEnd += to->LayoutCounts();
+    ReportLayoutCounts(layoutEnd - layoutStart, iterations);
+    return 1;
+}
+
+static uint64_t PileSplitCompleteRemovalNested(uint64_t iterations)
+{
+    return PileSplitCompleteRemoval(iterations, Layout::PileMode::Nested);
+}
+BENCHMARK("Pile/SplitCompleteRemoval12", PileSplitCompleteRemovalNested);
+
+static uint64_t PileSplitCompleteRemovalFlat(uint64_t iterations)
+{
+    return PileSplitCompleteRemoval(iterations, Layout::PileMode::Flat);
+}
+BENCHMARK("Pile/SplitCompleteRemoval12Flat", PileSplitCompleteRemovalFlat);
+
+// Drawing three cards at a time onto the waste, turning the waste back over
+// once the 24 card stock runs out.
+static uint64_t PileDrawDiscard(uint64_t iterations)
+{
+    auto compositor = MakeCompositor();
+    auto table = MakeTable(compositor);
+    Deck deck(compositor, table, MakeCards(0, 24));
+    deck.UpdateLayout();
+    Waste waste(compositor, MakePool(compositor), table);
+    waste.SetLayoutOptions(HorizontalOffset);
+    auto start = compositor->Counts();
+    auto layoutStart = waste.LayoutCounts();
+    layoutStart += deck.LayoutCounts();
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        auto cards = deck.Draw();
+        if (cards.empty())
+        {
+            deck.AddCards(waste.Flush());
+        }
+        else
+        {
+            waste.Discard(cards);
+        }
+    }
+    ReportCounts(compositor->Counts() - start, iterations);
+    Benchmark::SetBudget("calls", 20);
+    auto layoutEnd = waste.LayoutCounts();
+    layoutEnd += deck.LayoutCounts();
+    ReportLayoutCounts(layoutEnd - layoutStart, iterations);
+    return 1;
+}
+BENCHMARK("Pile/DrawDiscard3", PileDrawDiscard);
+
+// A layout change on a full column, switching between two card spacings as
+// the window is resized. Only containers whose offset differs are moved.
+static uint64_t PileRelayout(uint64_t iterations, Layout::PileMode mode)
+{
+    auto compositor = MakeCompositor();
+    auto pool = MakePool(compositor);
+    auto pile = MakeColumn(compositor, pool, MakeTable(compositor), 0, Klondike::MaxColumnCards, mode);
+    Benchmark::SetCounter("depth", TreeDepth(*pile->Base()));
+    auto start = compositor->Counts();
+    auto layoutStart = pile->LayoutCounts();
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        pile->SetLayoutOptions(i % 2 == 0 ? VerticalOffset / 2 : VerticalOffset);
+        pile->UpdateLayout();
+    }
+    ReportCounts(compositor->Counts() - start, iterations);
+    // Only the cards that move get a property set, and the first card sits at
+    // the same offset whatever the spacing.
+    Benchmark::SetBudget("calls", Klondike::MaxColumnCards - 1);
+    ReportLayoutCounts(pile->LayoutCounts() - layoutStart, iterations);
+    return 1;
+}
+
+static uint64_t PileRelayoutNested(uint64_t iterations)
+{
+    return PileRelayout(iterations, Layout::PileMode::Nested);
+}
+BENCHMARK("Pile/Relayout19", PileRelayoutNested);
+
+static uint64_t PileRelayoutFlat(uint64_t iterations)
+{
+    return PileRelayout(iterations, Layout::PileMode::Flat);
+}
+BENCHMARK("Pile/Relayout19Flat", PileRelayoutFlat);
+
+// Startup
+
+// A glyph cache shaped like the one SolitaireGlyphs writes for the card
+// faces: a run for each face and each suit, of three outlines each and about
+// 70 points a run.
+static std::vector<uint8_t> MakeGlyphCache()
+{
+    Layout::GlyphCacheInfo info{ Layout::CardFontFamily, Layout::CardFontSize, 48.0f };
+    std::vector<Layout::GlyphRun> runs(FaceCount + SuitCount);
+    for (size_t i = 0; i < runs.size(); i++)
+    {
+        auto& run = runs[i];
+        run.Text = i < FaceCount ?
+            Layout::ToUtf8(Card::FaceText((Face)(i + 1))) :
+            Layout::ToUtf8(Card::SuitText((Suit)(i - FaceCount)));
+        run.Advance = 56.0f;
+        for (auto figure = 0; figure < 3; figure++)
+        {
+            auto x = figure * 18.0f;
+            run.Path.BeginFigure({ x, 10 });
+            for (auto segment = 0; segment < 11; segment++)
+            {
+                run.Path.AddQuadraticBezier({ x + segment, 10.0f + segment * 2 }, { x + segment + 1, 12.0f + segment * 2 });
+            }
+            run.Path.AddLine({ x, 40 });
+            run.Path.EndFigure();
+        }
+    }
+    std::vector<uint8_t> buffer;
+    Layout::WriteGlyphCache(buffer, info, runs);
+    return buffer;
+}
+
+// Reading every path out of the glyph cache, the part of ShapeCache's launch
+// that replaced laying out the text of every face and suit.
+static uint64_t StartupReadGlyphCache(uint64_t iterations)
+{
+    auto buffer = MakeGlyphCache();
+    uint64_t points = 0;
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        Layout::GlyphCacheReader reader(buffer.data(), buffer.size());
+        Layout::GlyphRunView run;
+        while (reader.Next(run))
+        {
+            Layout::PathDecoder decoder(run);
+            Layout::PathSegment segment;
+            while (decoder.Next(segment))
+            {
+                points += Layout::PointCount(segment.Command);
+            }
+        }
+    }
+    Benchmark::DoNotOptimize(points);
+    Benchmark::SetCounter("bytes", (double)buffer.size());
+    Benchmark::SetCounter("points", (double)points / iterations);
+    return 1;
+}
+BENCHMARK("Startup/ReadGlyphCache", StartupReadGlyphCache);
+
+// Card atlas
+
+// Drawing every card face and the back into the atlas, the CPU side of a
+// scale change that moves to another atlas scale.
+static uint64_t AtlasRender(uint64_t iterations, float scale)
+{
+    auto buffer = MakeGlyphCache();
+    Layout::GlyphCacheReader reader(buffer.data(), buffer.size());
+    Layout::CardOutlines outlines;
+    Layout::ReadCardOutlines(reader, outlines);
+    Raster::CardAtlas atlas(outlines);
+    Raster::Image image;
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        atlas.Render(scale, image);
+        Benchmark::DoNotOptimize(image.Pixels.data());
+    }
+    Benchmark::SetCounter("pixels", (double)image.Width * image.Height);
+    return 1;
+}
+
+static uint64_t AtlasRender1(uint64_t iterations)
+{
+    return AtlasRender(iterations, 1.0f);
+}
+BENCHMARK("Atlas/Render1", AtlasRender1);
+
+static uint64_t AtlasRender2(uint64_t iterations)
+{
+    return AtlasRender(iterations, 2.0f);
+}
+BENCHMARK("Atlas/Render2", AtlasRender2);
+
+void PrintUsage()
+{
+    std::fprintf(stderr,
+        "Usage: SolitaireBench [-filter TEXT] [-time SECONDS] [-repetitions N] [-commit ID] [-out FILE]\n"
+        "\n"
+        "Runs the microbenchmarks and writes the results as JSON. Exits with 1 if any\n"
+        "benchmark goes over one of its budgets.\n"
+        "\n"
+        "  -filter TEXT     Only run benchmarks whose name contains TEXT\n"
+        "  -time SECONDS    Minimum time per measurement (default 0.2)\n"
+        "  -repetitions N   Measurements per benchmark, the median is reported (default 5)\n"
+        "  -commit ID       Recorded in the output to tie results to a commit\n"
+        "  -out FILE        Where to write results (default: stdout)\n");
+}
+
+int main(int argc, char** argv)
+{
+    Benchmark::Options options;
+    std::string outputPath;
+    for (auto i = 1; i < argc; i++)
+    {
+        auto hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "-filter") == 0 && hasValue)
+        {
+            options.Filter = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "-time") == 0 && hasValue)
+        {
+            options.MinSeconds = std::strtod(argv[++i], nullptr);
+        }
+        else if (std::strcmp(argv[i], "-repetitions") == 0 && hasValue)
+        {
+            options.Repetitions = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "-commit") == 0 && hasValue)
+        {
+            options.Commit = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "-out") == 0 && hasValue)
+        {
+            outputPath = argv[++i];
+        }
+        else
+        {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    // Build the inputs before anything is timed.
+    Data();
+
+    auto results = Benchmark::RunAll(options);
+    auto overBudgetCount = 0;
+    for (auto& result : results)
+    {
+        std::fprintf(stderr, "%-32s %12.2f ns %14.0f items/s", result.Name.c_str(), result.RealTime, result.ItemsPerSecond);
+        for (auto& counter : result.Counters)
+        {
+            std::fprintf(stderr, " %s=%g", counter.first.c_str(), counter.second);
+        }
+        std::fprintf(stderr, "\n");
+        for (auto& counter : Benchmark::OverBudget(result))
+        {
+            std::fprintf(stderr, "  over budget: %s=%g\n", counter.first.c_str(), counter.second);
+            overBudgetCount++;
+        }
+    }
+
+    auto json = Benchmark::ToJson(results, options);
+    auto output = stdout;
+    if (!outputPath.empty())
+    {
+        output = std::fopen(outputPath.c_str(), "w");
+        if (!output)
+        {
+            std::fprintf(stderr, "Couldn't open %s\n", outputPath.c_str());
+            return 1;
+        }
+    }
+    std::fputs(json.c_str(), output);
+    if (output != stdout)
+    {
+        std::fclose(output);
+    }
+    return overBudgetCount == 0 ? 0 : 1;
+}
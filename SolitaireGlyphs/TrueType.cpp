@@ -0,0 +1,546 @@
+#include <cstring>
+#include <vector>
+#include "TrueType.h"
+
+// Composite glyphs nest rarely and shallowly, this only guards against loops.
+constexpr int MaxCompositeDepth = 8;
+
+static uint16_t ReadUInt16(uint8_t const* position)
+{
+    return (uint16_t)((position[0] << 8) | position[1]);
+}
+
+static int16_t ReadInt16(uint8_t const* position)
+{
+    return (int16_t)ReadUInt16(position);
+}
+
+static uint32_t ReadUInt32(uint8_t const* position)
+{
+    return ((uint32_t)position[0] << 24) | (position[1] << 16) | (position[2] << 8) | position[3];
+}
+
+// 2.14 fixed point, used for composite glyph scales.
+static float ReadF2Dot14(uint8_t const* position)
+{
+    return ReadInt16(position) / 16384.0f;
+}
+
+bool TrueTypeFont::Load(uint8_t const* data, size_t size)
+{
+    m_data = data;
+    m_size = size;
+    if (size < 12)
+    {
+        return false;
+    }
+
+    // A collection is read as its first font.
+    auto offset = (size_t)0;
+    if (std::memcmp(data, "ttcf", 4) == 0)
+    {
+        if (size < 16)
+        {
+            return false;
+        }
+        offset = ReadUInt32(data + 12);
+        if (offset > size - 12)
+        {
+            return false;
+        }
+    }
+
+    auto version = ReadUInt32(data + offset);
+    if (version != 0x00010000 && std::memcmp(data + offset, "true", 4) != 0)
+    {
+        return false;
+    }
+    m_tableCount = ReadUInt16(data + offset + 4);
+    m_tables = data + offset + 12;
+    if ((size_t)(data + size - m_tables) < (size_t)m_tableCount * 16)
+    {
+        return false;
+    }
+
+    size_t headSize = 0;
+    size_t maxpSize = 0;
+    size_t hheaSize = 0;
+    size_t os2Size = 0;
+    auto head = Table("head", headSize);
+    auto maxp = Table("maxp", maxpSize);
+    auto hhea = Table("hhea", hheaSize);
+    auto os2 = Table("OS/2", os2Size);
+    m_cmap = Table("cmap", m_cmapSize);
+    m_hmtx = Table("hmtx", m_hmtxSize);
+    m_loca = Table("loca", m_locaSize);
+    m_glyf = Table("glyf", m_glyfSize);
+    if (!head || headSize < 54 ||
+        !maxp || maxpSize < 6 ||
+        !hhea || hheaSize < 36 ||
+        !m_cmap || !m_hmtx || !m_loca || !m_glyf)
+    {
+        return false;
+    }
+
+    m_unitsPerEm = ReadUInt16(head + 18);
+    m_isLongLoca = ReadInt16(head + 50) != 0;
+    m_glyphCount = ReadUInt16(maxp + 4);
+    m_hmetricCount = ReadUInt16(hhea + 34);
+    if (m_unitsPerEm == 0 ||
+        m_hmetricCount == 0 ||
+        m_hmtxSize < (size_t)m_hmetricCount * 4 ||
+        m_locaSize < (size_t)(m_glyphCount + 1) * (m_isLongLoca ? 4 : 2))
+    {
+        return false;
+    }
+
+    // DirectWrite sizes a line from the Windows metrics unless the font asks
+    // for its typographic ones.
+    m_ascent = ReadInt16(hhea + 4);
+    m_descent = -ReadInt16(hhea + 6);
+    m_lineGap = ReadInt16(hhea + 8);
+    if (os2 && os2Size >= 78)
+    {
+        auto useTypoMetrics = (ReadUInt16(os2 + 62) & 0x80) != 0;
+        if (useTypoMetrics)
+        {
+            m_ascent = ReadInt16(os2 + 68);
+            m_descent = -ReadInt16(os2 + 70);
+            m_lineGap = ReadInt16(os2 + 72);
+        }
+        else
+        {
+            m_ascent = ReadUInt16(os2 + 74);
+            m_descent = ReadUInt16(os2 + 76);
+            m_lineGap = 0;
+        }
+    }
+
+    // Prefer the full Unicode subtable, then the BMP one, then symbol fonts.
+    if (m_cmapSize < 4)
+    {
+        return false;
+    }
+    auto subtableCount = ReadUInt16(m_cmap + 2);
+    if (m_cmapSize < 4 + (size_t)subtableCount * 8)
+    {
+        return false;
+    }
+    auto bestRank = 0;
+    uint8_t const* best = nullptr;
+    for (auto i = 0; i < subtableCount; i++)
+    {
+        auto record = m_cmap + 4 + i * 8;
+        auto platform = ReadUInt16(record);
+        auto encoding = ReadUInt16(record + 2);
+        auto subtableOffset = ReadUInt32(record + 4);
+        if (subtableOffset > m_cmapSize - 2)
+        {
+            continue;
+        }
+        auto subtable = m_cmap + subtableOffset;
+        auto format = ReadUInt16(subtable);
+        auto rank = 0;
+        if (format == 12 && (platform == 0 || (platform == 3 && encoding == 10)))
+        {
+            rank = 4;
+        }
+        else if (format == 4 && (platform == 0 || (platform == 3 && encoding == 1)))
+        {
+            rank = 3;
+        }
+        else if (format == 4 && platform == 3 && encoding == 0)
+        {
+            rank = 2;
+        }
+        if (rank > bestRank)
+        {
+            bestRank = rank;
+            best = subtable;
+            m_cmapFormat = format;
+        }
+    }
+    if (!best)
+    {
+        return false;
+    }
+    m_cmapSize -= best - m_cmap;
+    m_cmap = best;
+    return true;
+}
+
+uint8_t const* TrueTypeFont::Table(char const* tag, size_t& size) const
+{
+    for (auto i = 0; i < m_tableCount; i++)
+    {
+        auto record = m_tables + i * 16;
+        if (std::memcmp(record, tag, 4) == 0)
+        {
+            auto offset = ReadUInt32(record + 8);
+            auto length = ReadUInt32(record + 12);
+            if (offset > m_size || length > m_size - offset)
+            {
+                return nullptr;
+            }
+            size = length;
+            return m_data + offset;
+        }
+    }
+    return nullptr;
+}
+
+uint16_t TrueTypeFont::GlyphIndex(uint32_t codePoint) const
+{
+    if (m_cmapFormat == 12)
+    {
+        if (m_cmapSize < 16)
+        {
+            return 0;
+        }
+        auto groupCount = ReadUInt32(m_cmap + 12);
+        if (groupCount > (m_cmapSize - 16) / 12)
+        {
+            return 0;
+        }
+        for (uint32_t i = 0; i < groupCount; i++)
+        {
+            auto group = m_cmap + 16 + i * 12;
+            auto first = ReadUInt32(group);
+            auto last = ReadUInt32(group + 4);
+            if (codePoint >= first && codePoint <= last)
+            {
+                auto glyph = ReadUInt32(group + 8) + (codePoint - first);
+                return glyph < (uint32_t)m_glyphCount ? (uint16_t)glyph : 0;
+            }
+        }
+        return 0;
+    }
+
+    // Format 4, split into segments of consecutive characters. Symbol fonts
+    // put their characters at U+F000 up.
+    if (codePoint > 0xFFFF || m_cmapSize < 14)
+    {
+        return 0;
+    }
+    auto segmentCount = ReadUInt16(m_cmap + 6) / 2;
+    if (m_cmapSize < 16 + (size_t)segmentCount * 8)
+    {
+        return 0;
+    }
+    auto endCodes = m_cmap + 14;
+    auto startCodes = endCodes + segmentCount * 2 + 2;
+    auto deltas = startCodes + segmentCount * 2;
+    auto rangeOffsets = deltas + segmentCount * 2;
+    for (auto i = 0; i < segmentCount; i++)
+    {
+        if (codePoint > ReadUInt16(endCodes + i * 2))
+        {
+            continue;
+        }
+        auto start = ReadUInt16(startCodes + i * 2);
+        if (codePoint < start)
+        {
+            return 0;
+        }
+        auto delta = ReadUInt16(deltas + i * 2);
+        auto rangeOffset = ReadUInt16(rangeOffsets + i * 2);
+        if (rangeOffset == 0)
+        {
+            return (uint16_t)(codePoint + delta);
+        }
+        auto glyphAddress = rangeOffsets + i * 2 + rangeOffset + (codePoint - start) * 2;
+        if (glyphAddress + 2 > m_cmap + m_cmapSize)
+        {
+            return 0;
+        }
+        auto glyph = ReadUInt16(glyphAddress);
+        return glyph == 0 ? 0 : (uint16_t)(glyph + delta);
+    }
+    return 0;
+}
+
+int TrueTypeFont::AdvanceWidth(uint16_t glyph) const
+{
+    auto metric = glyph < m_hmetricCount ? glyph : m_hmetricCount - 1;
+    return ReadUInt16(m_hmtx + metric * 4);
+}
+
+bool TrueTypeFont::AppendOutline(uint16_t glyph, float scale, Layout::Point origin, Layout::GlyphPath& path) const
+{
+    Transform transform;
+    transform.XX = scale;
+    transform.YY = -scale;
+    transform.DX = origin.X;
+    transform.DY = origin.Y;
+    return AppendGlyph(glyph, transform, 0, path);
+}
+
+bool TrueTypeFont::AppendGlyph(uint16_t glyph, Transform const& transform, int depth, Layout::GlyphPath& path) const
+{
+    if (glyph >= m_glyphCount || depth > MaxCompositeDepth)
+    {
+        return false;
+    }
+
+    auto start = m_isLongLoca ? ReadUInt32(m_loca + glyph * 4) : ReadUInt16(m_loca + glyph * 2) * 2u;
+    auto end = m_isLongLoca ? ReadUInt32(m_loca + glyph * 4 + 4) : ReadUInt16(m_loca + glyph * 2 + 2) * 2u;
+    // Spaces and other blank glyphs have no outline at all.
+    if (start == end)
+    {
+        return true;
+    }
+    if (start > end || end > m_glyfSize || end - start < 10)
+    {
+        return false;
+    }
+
+    auto position = m_glyf + start;
+    auto glyphEnd = m_glyf + end;
+    auto contourCount = ReadInt16(position);
+    position += 10;
+
+    if (contourCount < 0)
+    {
+        // A composite glyph, made of other glyphs each with its own transform.
+        constexpr uint16_t ArgsAreWords = 0x0001;
+        constexpr uint16_t ArgsAreXYValues = 0x0002;
+        constexpr uint16_t HasScale = 0x0008;
+        constexpr uint16_t MoreComponents = 0x0020;
+        constexpr uint16_t HasXYScale = 0x0040;
+        constexpr uint16_t HasTwoByTwo = 0x0080;
+
+        auto flags = MoreComponents;
+        while (flags & MoreComponents)
+        {
+            if (glyphEnd - position < 4)
+            {
+                return false;
+            }
+            flags = ReadUInt16(position);
+            auto component = ReadUInt16(position + 2);
+            position += 4;
+
+            auto argumentSize = (flags & ArgsAreWords) ? 4 : 2;
+            auto scaleSize = (flags & HasTwoByTwo) ? 8 : (flags & HasXYScale) ? 4 : (flags & HasScale) ? 2 : 0;
+            if (glyphEnd - position < argumentSize + scaleSize)
+            {
+                return false;
+            }
+
+            float dx = 0;
+            float dy = 0;
+            // Components placed by matching points are rare enough in text
+            // fonts to be left at the origin.
+            if (flags & ArgsAreXYValues)
+            {
+                dx = (flags & ArgsAreWords) ? ReadInt16(position) : (int8_t)position[0];
+                dy = (flags & ArgsAreWords) ? ReadInt16(position + 2) : (int8_t)position[1];
+            }
+            position += argumentSize;
+
+            Transform local;
+            if (flags & HasTwoByTwo)
+            {
+                local.XX = ReadF2Dot14(position);
+                local.YX = ReadF2Dot14(position + 2);
+                local.XY = ReadF2Dot14(position + 4);
+                local.YY = ReadF2Dot14(position + 6);
+            }
+            else if (flags & HasXYScale)
+            {
+                local.XX = ReadF2Dot14(position);
+                local.YY = ReadF2Dot14(position + 2);
+            }
+            else if (flags & HasScale)
+            {
+                local.XX = local.YY = ReadF2Dot14(position);
+            }
+            position += scaleSize;
+
+            // The component's points go through its own transform, then ours.
+            Transform combined;
+            combined.XX = transform.XX * local.XX + transform.XY * local.YX;
+            combined.XY = transform.XX * local.XY + transform.XY * local.YY;
+            combined.YX = transform.YX * local.XX + transform.YY * local.YX;
+            combined.YY = transform.YX * local.XY + transform.YY * local.YY;
+            combined.DX = transform.XX * dx + transform.XY * dy + transform.DX;
+            combined.DY = transform.YX * dx + transform.YY * dy + transform.DY;
+            if (!AppendGlyph(component, combined, depth + 1, path))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    if (glyphEnd - position < contourCount * 2 + 2)
+    {
+        return false;
+    }
+    std::vector<int> contourEnds(contourCount);
+    for (auto i = 0; i < contourCount; i++)
+    {
+        contourEnds[i] = ReadUInt16(position + i * 2);
+    }
+    auto pointCount = contourCount > 0 ? contourEnds.back() + 1 : 0;
+    position += contourCount * 2;
+    auto instructionSize = ReadUInt16(position);
+    position += 2;
+    if (glyphEnd - position < instructionSize)
+    {
+        return false;
+    }
+    position += instructionSize;
+
+    constexpr uint8_t OnCurve = 0x01;
+    constexpr uint8_t XIsShort = 0x02;
+    constexpr uint8_t YIsShort = 0x04;
+    constexpr uint8_t Repeat = 0x08;
+    constexpr uint8_t XIsSameOrPositive = 0x10;
+    constexpr uint8_t YIsSameOrPositive = 0x20;
+
+    std::vector<uint8_t> flags;
+    flags.reserve(pointCount);
+    while ((int)flags.size() < pointCount)
+    {
+        if (position == glyphEnd)
+        {
+            return false;
+        }
+        auto flag = *position++;
+        auto count = 1;
+        if (flag & Repeat)
+        {
+            if (position == glyphEnd)
+            {
+                return false;
+            }
+            count += *position++;
+        }
+        for (auto i = 0; i < count && (int)flags.size() < pointCount; i++)
+        {
+            flags.push_back(flag);
+        }
+    }
+
+    // Coordinates are deltas from the previous point, x first then y.
+    std::vector<Layout::Point> points(pointCount);
+    for (auto axis = 0; axis < 2; axis++)
+    {
+        auto isShort = axis == 0 ? XIsShort : YIsShort;
+        auto isSameOrPositive = axis == 0 ? XIsSameOrPositive : YIsSameOrPositive;
+        auto value = 0;
+        for (auto i = 0; i < pointCount; i++)
+        {
+            if (flags[i] & isShort)
+            {
+                if (position == glyphEnd)
+                {
+                    return false;
+                }
+                value += (flags[i] & isSameOrPositive) ? *position : -*position;
+                position++;
+            }
+            else if (!(flags[i] & isSameOrPositive))
+            {
+                if (glyphEnd - position < 2)
+                {
+                    return false;
+                }
+                value += ReadInt16(position);
+                position += 2;
+            }
+            (axis == 0 ? points[i].X : points[i].Y) = (float)value;
+        }
+    }
+
+    for (auto& point : points)
+    {
+        auto x = point.X;
+        auto y = point.Y;
+        point.X = transform.XX * x + transform.XY * y + transform.DX;
+        point.Y = transform.YX * x + transform.YY * y + transform.DY;
+    }
+
+    auto Midpoint = [](Layout::Point a, Layout::Point b) -> Layout::Point
+    {
+        return { (a.X + b.X) / 2, (a.Y + b.Y) / 2 };
+    };
+
+    // Two off curve points in a row have an implied on curve point halfway
+    // between them.
+    auto first = 0;
+    for (auto contour = 0; contour < contourCount; contour++)
+    {
+        auto last = contourEnds[contour];
+        if (last < first || last >= pointCount)
+        {
+            return false;
+        }
+        auto count = last - first + 1;
+        if (count < 2)
+        {
+            first = last + 1;
+            continue;
+        }
+
+        auto isOn = [&](int i) { return (flags[first + i % count] & OnCurve) != 0; };
+        auto at = [&](int i) { return points[first + i % count]; };
+
+        // Start on an on curve point, making one up if there are none.
+        Layout::Point startPoint;
+        auto startIndex = 0;
+        if (isOn(0))
+        {
+            startPoint = at(0);
+            startIndex = 1;
+        }
+        else if (isOn(count - 1))
+        {
+            startPoint = at(count - 1);
+            startIndex = 0;
+            count--;
+        }
+        else
+        {
+            startPoint = Midpoint(at(0), at(count - 1));
+            startIndex = 0;
+        }
+
+        path.BeginFigure(startPoint);
+        auto hasControl = false;
+        Layout::Point control;
+        for (auto i = startIndex; i < count; i++)
+        {
+            auto point = at(i);
+            if (isOn(i))
+            {
+                if (hasControl)
+                {
+                    path.AddQuadraticBezier(control, point);
+                }
+                else
+                {
+                    path.AddLine(point);
+                }
+                hasControl = false;
+            }
+            else
+            {
+                if (hasControl)
+                {
+                    path.AddQuadraticBezier(control, Midpoint(control, point));
+                }
+                control = point;
+                hasControl = true;
+            }
+        }
+        if (hasControl)
+        {
+            path.AddQuadraticBezier(control, startPoint);
+        }
+        path.EndFigure();
+        first = last + 1;
+    }
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "GlyphCache.h"
+
+// Just enough of a TrueType font to pull glyph outlines and advances out of
+// it: the cmap, hmtx, loca and glyf tables and the line metrics. Fonts with
+// CFF outlines aren't supported, and neither is hinting, kerning or shaping,
+// none of which the text on a card needs.
+class TrueTypeFont
+{
+public:
+    // The font points into data, which has to outlive it.
+    bool Load(uint8_t const* data, size_t size);
+
+    // Zero when the font has no glyph for the code point.
+    uint16_t GlyphIndex(uint32_t codePoint) const;
+    // In font units.
+    int AdvanceWidth(uint16_t glyph) const;
+    int UnitsPerEm() const { return m_unitsPerEm; }
+    int Ascent() const { return m_ascent; }
+    int Descent() const { return m_descent; }
+    int LineGap() const { return m_lineGap; }
+
+    // Appends the glyph's outline scaled from font units to pixels, with
+    // y pointing down and the glyph's origin on the baseline at origin.
+    bool AppendOutline(uint16_t glyph, float scale, Layout::Point origin, Layout::GlyphPath& path) const;
+
+private:
+    struct Transform
+    {
+        float XX = 1;
+        float XY = 0;
+        float YX = 0;
+        float YY = 1;
+        float DX = 0;
+        float DY = 0;
+    };
+
+    uint8_t const* Table(char const* tag, size_t& size) const;
+    bool AppendGlyph(uint16_t glyph, Transform const& transform, int depth, Layout::GlyphPath& path) const;
+
+private:
+    uint8_t const* m_data = nullptr;
+    size_t m_size = 0;
+    uint8_t const* m_tables = nullptr;
+    int m_tableCount = 0;
+    uint8_t const* m_cmap = nullptr;
+    size_t m_cmapSize = 0;
+    int m_cmapFormat = 0;
+    uint8_t const* m_hmtx = nullptr;
+    size_t m_hmtxSize = 0;
+    int m_hmetricCount = 0;
+    uint8_t const* m_loca = nullptr;
+    size_t m_locaSize = 0;
+    bool m_isLongLoca = false;
+    uint8_t const* m_glyf = nullptr;
+    size_t m_glyfSize = 0;
+    int m_glyphCount = 0;
+    int m_unitsPerEm = 0;
+    int m_ascent = 0;
+    int m_descent = 0;
+    int m_lineGap = 0;
+};
\ No newline at end of file
@@ -0,0 +1,206 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "Card.h"
+#include "GlyphCache.h"
+#include "MappedFile.h"
+#include "TrueType.h"
+
+struct GlyphsOptions
+{
+    std::string FontPath;
+    std::string FallbackPath;
+    std::string FontFamily = Layout::CardFontFamily;
+    float FontSize = Layout::CardFontSize;
+    std::string OutputPath;
+};
+
+void PrintUsage()
+{
+    std::fprintf(stderr,
+        "Usage: SolitaireGlyphs -font FILE [-fallback FILE] [-family NAME] [-size PIXELS] -out FILE\n"
+        "\n"
+        "Lays out every card face and suit and writes their outlines to a glyph cache,\n"
+        "which the app loads at launch in place of running text layout. Only\n"
+        "TrueType outlines are supported.\n"
+        "\n"
+        "  -font FILE       Font the cards are set in, segoeui.ttf for Segoe UI\n"
+        "  -fallback FILE   Font for the characters -font doesn't have, as text layout\n"
+        "                   falls back to, seguisym.ttf for Segoe UI's suits\n"
+        "  -family NAME     Font family the app asks for (default Segoe UI)\n"
+        "  -size PIXELS     Font size the app asks for (default 36)\n"
+        "  -out FILE        Where to write the glyph cache\n");
+}
+
+bool ParseOptions(int argc, char** argv, GlyphsOptions& options)
+{
+    for (auto i = 1; i < argc; i++)
+    {
+        auto hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "-font") == 0 && hasValue)
+        {
+            options.FontPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "-fallback") == 0 && hasValue)
+        {
+            options.FallbackPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "-family") == 0 && hasValue)
+        {
+            options.FontFamily = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "-size") == 0 && hasValue)
+        {
+            options.FontSize = std::strtof(argv[++i], nullptr);
+        }
+        else if (std::strcmp(argv[i], "-out") == 0 && hasValue)
+        {
+            options.OutputPath = argv[++i];
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return !options.FontPath.empty() && !options.OutputPath.empty() && options.FontSize > 0;
+}
+
+bool LoadFont(char const* path, MappedFile& file, TrueTypeFont& font)
+{
+    if (!file.Open(path))
+    {
+        std::fprintf(stderr, "Couldn't open %s\n", path);
+        return false;
+    }
+    if (!font.Load(file.Data(), file.Size()))
+    {
+        std::fprintf(stderr, "%s is not a TrueType font\n", path);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    GlyphsOptions options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+    MappedFile fontFile;
+    MappedFile fallbackFile;
+    TrueTypeFont fonts[2];
+    auto fontCount = 1;
+    if (!LoadFont(options.FontPath.c_str(), fontFile, fonts[0]))
+    {
+        return 1;
+    }
+    if (!options.FallbackPath.empty())
+    {
+        if (!LoadFont(options.FallbackPath.c_str(), fallbackFile, fonts[1]))
+        {
+            return 1;
+        }
+        fontCount++;
+    }
+
+    std::vector<std::wstring> texts;
+    for (auto face = 1; face <= FaceCount; face++)
+    {
+        texts.push_back(Card::FaceText((Face)face));
+    }
+    for (auto suit = 0; suit < SuitCount; suit++)
+    {
+        texts.push_back(Card::SuitText((Suit)suit));
+    }
+
+    // Every character comes from the first font that has it, as with the
+    // live text layout. A card's face and suit are laid out on one line, as
+    // tall as the tallest font used on it with the baseline at its ascent,
+    // so every run shares the line the fonts used by any card would make.
+    std::vector<std::vector<std::pair<TrueTypeFont const*, uint16_t>>> glyphs(texts.size());
+    auto ascent = 0.0f;
+    auto lineHeight = 0.0f;
+    for (size_t i = 0; i < texts.size(); i++)
+    {
+        for (auto character : texts[i])
+        {
+            auto codePoint = (uint32_t)character;
+            auto found = false;
+            for (auto j = 0; j < fontCount && !found; j++)
+            {
+                auto glyph = fonts[j].GlyphIndex(codePoint);
+                if (glyph != 0)
+                {
+                    auto scale = options.FontSize / fonts[j].UnitsPerEm();
+                    ascent = std::max(ascent, fonts[j].Ascent() * scale);
+                    lineHeight = std::max(lineHeight, (fonts[j].Ascent() + fonts[j].Descent() + fonts[j].LineGap()) * scale);
+                    glyphs[i].push_back({ &fonts[j], glyph });
+                    found = true;
+                }
+            }
+            if (!found)
+            {
+                std::fprintf(stderr, "No font has a glyph for U+%04X\n", codePoint);
+                return 1;
+            }
+        }
+    }
+
+    Layout::GlyphCacheInfo info;
+    info.FontFamily = options.FontFamily;
+    info.FontSize = options.FontSize;
+    info.TextHeight = lineHeight;
+    std::vector<Layout::GlyphRun> runs;
+    size_t pointCount = 0;
+    for (size_t i = 0; i < texts.size(); i++)
+    {
+        Layout::GlyphRun run;
+        run.Text = Layout::ToUtf8(texts[i]);
+        for (auto& [font, glyph] : glyphs[i])
+        {
+            auto scale = options.FontSize / font->UnitsPerEm();
+            if (!font->AppendOutline(glyph, scale, { run.Advance, ascent }, run.Path))
+            {
+                std::fprintf(stderr, "Couldn't read the outline of glyph %d for %s\n", glyph, run.Text.c_str());
+                return 1;
+            }
+            run.Advance += font->AdvanceWidth(glyph) * scale;
+        }
+        pointCount += run.Path.Points.size();
+        runs.push_back(std::move(run));
+    }
+
+    std::vector<uint8_t> buffer;
+    Layout::WriteGlyphCache(buffer, info, runs);
+
+    auto output = std::fopen(options.OutputPath.c_str(), "wb");
+    if (!output)
+    {
+        std::fprintf(stderr, "Couldn't open %s\n", options.OutputPath.c_str());
+        return 1;
+    }
+    auto written = std::fwrite(buffer.data(), 1, buffer.size(), output);
+    std::fclose(output);
+    if (written != buffer.size())
+    {
+        std::fprintf(stderr, "Couldn't write %s\n", options.OutputPath.c_str());
+        return 1;
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+    std::fprintf(stderr, "%zu runs, %zu points, line height %.2f, %zu bytes in %.3fs\n",
+        runs.size(),
+        pointCount,
+        info.TextHeight,
+        buffer.size(),
+        elapsed.count());
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,124 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "MappedFile.h"
+#include "Replay.h"
+
+void PrintUsage()
+{
+    std::fprintf(stderr,
+        "Usage: SolitaireReplay [-v] FILE...\n"
+        "\n"
+        "Replays every game in each replay file through the rules engine and reports\n"
+        "how many were valid and how many were won.\n"
+        "\n"
+        "  -v           List every invalid game: offset,seed,version,move\n");
+}
+
+struct ReplayTotals
+{
+    uint64_t Games = 0;
+    uint64_t Invalid = 0;
+    uint64_t Won = 0;
+    uint64_t Moves = 0;
+    uint64_t Bytes = 0;
+};
+
+bool ValidateFile(char const* path, bool isVerbose, ReplayTotals& totals)
+{
+    MappedFile file;
+    if (!file.Open(path))
+    {
+        std::fprintf(stderr, "Couldn't open %s\n", path);
+        return false;
+    }
+
+    Klondike::ReplayReader reader(file.Data(), file.Size());
+    if (!reader.IsValid())
+    {
+        std::fprintf(stderr, "%s is not a replay file\n", path);
+        return false;
+    }
+
+    Klondike::ReplayGame game;
+    auto offset = reader.Offset();
+    while (reader.Next(game))
+    {
+        auto result = Klondike::ValidateReplay(game);
+        totals.Games++;
+        totals.Moves += game.MoveCount;
+        if (!result.IsValid)
+        {
+            totals.Invalid++;
+            if (isVerbose)
+            {
+                std::printf("%zu,%u:%u:%u:%u,%d,%u\n",
+                    offset,
+                    game.Seed.Num1, game.Seed.Num2, game.Seed.Num3, game.Seed.Num4,
+                    (int)game.Seed.Version,
+                    result.FailedMove);
+            }
+        }
+        else if (result.IsWon)
+        {
+            totals.Won++;
+        }
+        offset = reader.Offset();
+    }
+    totals.Bytes += file.Size();
+
+    // The reader stops early when a game runs past the end of the file.
+    if (offset != file.Size())
+    {
+        std::fprintf(stderr, "%s is truncated or corrupt at offset %zu\n", path, offset);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    auto isVerbose = false;
+    std::vector<char const*> paths;
+    for (auto i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "-v") == 0)
+        {
+            isVerbose = true;
+        }
+        else if (argv[i][0] == '-')
+        {
+            PrintUsage();
+            return 1;
+        }
+        else
+        {
+            paths.push_back(argv[i]);
+        }
+    }
+    if (paths.empty())
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    ReplayTotals totals;
+    auto succeeded = true;
+    auto startTime = std::chrono::steady_clock::now();
+    for (auto path : paths)
+    {
+        succeeded = ValidateFile(path, isVerbose, totals) && succeeded;
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+    std::fprintf(stderr, "%llu games, %llu invalid, %llu won, %llu moves in %llu bytes, %.2fs (%.0f games/s)\n",
+        (unsigned long long)totals.Games,
+        (unsigned long long)totals.Invalid,
+        (unsigned long long)totals.Won,
+        (unsigned long long)totals.Moves,
+        (unsigned long long)totals.Bytes,
+        elapsed.count(),
+        elapsed.count() > 0 ? totals.Games / elapsed.count() : 0.0);
+    return succeeded && totals.Invalid == 0 ? 0 : 1;
+}
@@ -0,0 +1,302 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ParallelSolver.h"
+#include "Solver.h"
+
+// Seeds a worker takes at a time. Dealing them together keeps the shuffle
+// out of the way of the solver.
+constexpr unsigned int DealsPerBatch = 64;
+
+struct SweepOptions
+{
+    unsigned int FirstSeed = 0;
+    uint64_t SeedCount = 1000;
+    unsigned int ThreadCount = 0;
+    uint64_t MaxNodes = Klondike::SolveOptions().MaxNodes;
+    // Shared out between the workers' transposition tables, so the sweep
+    // stays well inside a 2 GB process however many cores it runs on.
+    size_t MemoryBytes = (size_t)1024 << 20;
+    uint8_t Pruning = Klondike::AllPruneRules;
+    Klondike::StockMoves Stock = Klondike::StockMoves::Plays;
+    Klondike::ShuffleVersion Shuffle = Klondike::CurrentShuffleVersion;
+    bool IsParallel = false;
+    std::string OutputPath;
+};
+
+void PrintUsage()
+{
+    std::fprintf(stderr,
+        "Usage: SolitaireSweep [-first N] [-count N] [-threads N] [-nodes N] [-memory MB] [-prune RULES] [-draws] [-shuffle N] [-parallel] [-out FILE]\n"
+        "\n"
+        "Solves the deals for shuffle seeds { N, 0, 0, 0 } through { N + count - 1, 0, 0, 0 }\n"
+        "and writes one line per seed: seed,status,moves,nodes,seconds\n"
+        "\n"
+        "  -first N     First seed to solve (default 0)\n"
+        "  -count N     Number of seeds to solve (default 1000)\n"
+        "  -threads N   Worker threads (default: one per core)\n"
+        "  -nodes N     Node budget per deal before giving up (default 5000000)\n"
+        "  -memory MB   Memory for all the transposition tables together (default 1024)\n"
+        "  -prune RULES Pruning rules to use, a comma separated list of safe, kings and\n"
+        "               repeats, or all or none (default all)\n"
+        "  -draws       Search draws one at a time instead of playing stock cards directly\n"
+        "  -shuffle N   Shuffle version the seeds are for, 0 is legacy (default 1)\n"
+        "  -parallel    Solve one deal at a time with every thread on it, for hard deals\n"
+        "  -out FILE    Where to write results (default: stdout)\n");
+}
+
+bool ParsePruneRules(char const* list, uint8_t& rules)
+{
+    rules = Klondike::NoPruneRules;
+    std::string rest = list;
+    while (!rest.empty())
+    {
+        auto end = rest.find(',');
+        auto name = rest.substr(0, end);
+        rest = end == std::string::npos ? "" : rest.substr(end + 1);
+        if (name == "safe")
+        {
+            rules |= Klondike::SafeFoundationMoves;
+        }
+        else if (name == "kings")
+        {
+            rules |= Klondike::KingsBetweenEmptyColumns;
+        }
+        else if (name == "repeats")
+        {
+            rules |= Klondike::RepeatColumnMoves;
+        }
+        else if (name == "all")
+        {
+            rules |= Klondike::AllPruneRules;
+        }
+        else if (name != "none")
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ParseOptions(int argc, char** argv, SweepOptions& options)
+{
+    for (auto i = 1; i < argc; i++)
+    {
+        auto hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "-first") == 0 && hasValue)
+        {
+            options.FirstSeed = (unsigned int)std::strtoul(argv[++i], nullptr, 0);
+        }
+        else if (std::strcmp(argv[i], "-count") == 0 && hasValue)
+        {
+            options.SeedCount = std::strtoull(argv[++i], nullptr, 0);
+        }
+        else if (std::strcmp(argv[i], "-threads") == 0 && hasValue)
+        {
+            options.ThreadCount = (unsigned int)std::strtoul(argv[++i], nullptr, 0);
+        }
+        else if (std::strcmp(argv[i], "-nodes") == 0 && hasValue)
+        {
+            options.MaxNodes = std::strtoull(argv[++i], nullptr, 0);
+        }
+        else if (std::strcmp(argv[i], "-memory") == 0 && hasValue)
+        {
+            options.MemoryBytes = (size_t)std::strtoull(argv[++i], nullptr, 0) << 20;
+        }
+        else if (std::strcmp(argv[i], "-prune") == 0 && hasValue)
+        {
+            if (!ParsePruneRules(argv[++i], options.Pruning))
+            {
+                return false;
+            }
+        }
+        else if (std::strcmp(argv[i], "-draws") == 0)
+        {
+            options.Stock = Klondike::StockMoves::Draws;
+        }
+        else if (std::strcmp(argv[i], "-shuffle") == 0 && hasValue)
+        {
+            auto version = std::strtoul(argv[++i], nullptr, 0);
+            if (version > (unsigned long)Klondike::CurrentShuffleVersion)
+            {
+                return false;
+            }
+            options.Shuffle = (Klondike::ShuffleVersion)version;
+        }
+        else if (std::strcmp(argv[i], "-parallel") == 0)
+        {
+            options.IsParallel = true;
+        }
+        else if (std::strcmp(argv[i], "-out") == 0 && hasValue)
+        {
+            options.OutputPath = argv[++i];
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+const char* StatusName(Klondike::SolveStatus status)
+{
+    switch (status)
+    {
+    case Klondike::SolveStatus::Winnable:
+        return "winnable";
+    case Klondike::SolveStatus::Unwinnable:
+        return "unwinnable";
+    default:
+        return "unknown";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    SweepOptions options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    // Seeds are 32-bit, stop at the last one rather than wrapping around to
+    // seeds that may already have been solved.
+    options.SeedCount = std::min<uint64_t>(options.SeedCount, (uint64_t)UINT32_MAX - options.FirstSeed + 1);
+
+    auto threadCount = options.ThreadCount;
+    if (threadCount == 0)
+    {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    auto output = stdout;
+    if (!options.OutputPath.empty())
+    {
+        output = std::fopen(options.OutputPath.c_str(), "w");
+        if (!output)
+        {
+            std::fprintf(stderr, "Couldn't open %s\n", options.OutputPath.c_str());
+            return 1;
+        }
+    }
+
+    std::fprintf(output, "seed,status,moves,nodes,seconds\n");
+
+    // Workers pull the next batch of seeds off a shared counter and stream
+    // their results as soon as each deal is decided, so lines are not in seed
+    // order. The counter is 64-bit so that taking batches past the last seed
+    // can't wrap it around.
+    std::atomic<uint64_t> nextSeed{ 0 };
+    std::atomic<uint64_t> totalNodes{ 0 };
+    std::atomic<uint64_t> totalTranspositions{ 0 };
+    std::atomic<unsigned int> winnableCount{ 0 };
+    std::mutex outputLock;
+    Klondike::PruneCounts totalPruned;
+    auto startTime = std::chrono::steady_clock::now();
+
+    auto writeResult = [&](unsigned int seed, Klondike::SolveResult const& result)
+    {
+        totalNodes += result.Nodes;
+        totalTranspositions += result.Transpositions;
+        if (result.Status == Klondike::SolveStatus::Winnable)
+        {
+            winnableCount++;
+        }
+
+        std::lock_guard<std::mutex> lock(outputLock);
+        totalPruned += result.Pruned;
+        std::fprintf(output, "%u,%s,%zu,%llu,%.6f\n",
+            seed,
+            StatusName(result.Status),
+            result.Moves.size(),
+            (unsigned long long)result.Nodes,
+            result.Seconds);
+        // A long run that gets killed keeps every result written so far.
+        std::fflush(output);
+    };
+
+    auto worker = [&]()
+    {
+        Klondike::SolveOptions solveOptions;
+        solveOptions.MaxNodes = options.MaxNodes;
+        solveOptions.Pruning = options.Pruning;
+        solveOptions.Stock = options.Stock;
+        solveOptions.TableBytes = options.MemoryBytes / threadCount;
+        Klondike::Solver solver(solveOptions);
+
+        std::vector<Klondike::CardOrder> deals(DealsPerBatch);
+        for (auto first = nextSeed.fetch_add(DealsPerBatch); first < options.SeedCount; first = nextSeed.fetch_add(DealsPerBatch))
+        {
+            auto count = (unsigned int)std::min<uint64_t>(DealsPerBatch, options.SeedCount - first);
+            Klondike::ShuffleSeed firstSeed{ options.FirstSeed + (unsigned int)first, 0, 0, 0, options.Shuffle };
+            Klondike::ShuffleCards(firstSeed, count, deals.data());
+
+            for (auto i = 0u; i < count; i++)
+            {
+                auto seed = firstSeed.Num1 + i;
+                writeResult(seed, solver.Solve(Klondike::Deal(deals[i])));
+            }
+        }
+    };
+
+    if (options.IsParallel)
+    {
+        // Lines come out in seed order.
+        Klondike::SolveOptions solveOptions;
+        solveOptions.MaxNodes = options.MaxNodes;
+        solveOptions.ThreadCount = threadCount;
+        solveOptions.Pruning = options.Pruning;
+        solveOptions.Stock = options.Stock;
+        solveOptions.TableBytes = options.MemoryBytes;
+        Klondike::ParallelSolver solver(solveOptions);
+        for (uint64_t i = 0; i < options.SeedCount; i++)
+        {
+            Klondike::ShuffleSeed seed{ options.FirstSeed + (unsigned int)i, 0, 0, 0, options.Shuffle };
+            writeResult(seed.Num1, solver.Solve(seed));
+        }
+    }
+    else
+    {
+        std::vector<std::thread> threads;
+        for (auto i = 0u; i < threadCount; i++)
+        {
+            threads.emplace_back(worker);
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    if (output != stdout)
+    {
+        std::fclose(output);
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+    std::fprintf(stderr, "%llu seeds, %u winnable, %llu nodes in %.2fs on %u threads (%.0f nodes/s)\n",
+        (unsigned long long)options.SeedCount,
+        winnableCount.load(),
+        (unsigned long long)totalNodes.load(),
+        elapsed.count(),
+        threadCount,
+        elapsed.count() > 0 ? totalNodes.load() / elapsed.count() : 0.0);
+    std::fprintf(stderr, "%llu transpositions skipped (%.1f%% of positions reached)\n",
+        (unsigned long long)totalTranspositions.load(),
+        totalNodes.load() + totalTranspositions.load() > 0 ? 100.0 * totalTranspositions.load() / (totalNodes.load() + totalTranspositions.load()) : 0.0);
+    std::fprintf(stderr, "Moves pruned: %llu beside safe foundation moves, %llu kings between empty columns, %llu repeat column moves\n",
+        (unsigned long long)totalPruned.SafeFoundationMoves,
+        (unsigned long long)totalPruned.KingsBetweenEmptyColumns,
+        (unsigned long long)totalPruned.RepeatColumnMoves);
+    return 0;
+}
@@ -0,0 +1,416 @@
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "Deal.h"
+#include "Klondike.h"
+#include "MoveGenerator.h"
+#include "ParallelSolver.h"
+#include "Replay.h"
+#include "Solver.h"
+#include "TranspositionTable.h"
+
+// Checks for the parts of the engine the app can't show are right by itself,
+// with no dependencies so it builds wherever the engine does. Each test runs
+// its CHECKs to the end, the exit code says whether any failed.
+using TestFunction = void (*)();
+
+struct TestRegistration
+{
+    char const* Name;
+    TestFunction Run;
+};
+
+static std::vector<TestRegistration>& Tests()
+{
+    static std::vector<TestRegistration> tests;
+    return tests;
+}
+
+struct TestRegistrar
+{
+    TestRegistrar(char const* name, TestFunction run) { Tests().push_back({ name, run }); }
+};
+
+#define TEST_CONCAT_INNER(a, b) a##b
+#define TEST_CONCAT(a, b) TEST_CONCAT_INNER(a, b)
+#define TEST(name, function) \
+    static TestRegistrar TEST_CONCAT(s_test, __LINE__)(name, function)
+
+static int s_failures = 0;
+
+static void Check(bool condition, char const* expression, int line)
+{
+    if (!condition)
+    {
+        std::fprintf(stderr, "  line %d: CHECK(%s) failed\n", line, expression);
+        s_failures++;
+    }
+}
+
+#define CHECK(condition) Check((condition), #condition, __LINE__)
+
+// Plays a game of legal moves, picking a different one of them each time so
+// every kind of move code gets a chance to turn up.
+static std::vector<Klondike::Move> PlayMoves(Klondike::ShuffleSeed seed, int count)
+{
+    auto state = Klondike::Deal(seed);
+    std::vector<Klondike::Move> moves;
+    Klondike::Move generated[Klondike::MaxMoves];
+    for (auto i = 0; i < count; i++)
+    {
+        auto moveCount = Klondike::GenerateMoves(state, generated);
+        if (moveCount == 0)
+        {
+            break;
+        }
+        moves.push_back(state.Apply(generated[i % moveCount]));
+    }
+    return moves;
+}
+
+// A version 1 file is a version 2 one without the ShuffleVersion byte in each
+// game, and every seed Legacy.
+static std::vector<uint8_t> MakeVersion1File(std::vector<Klondike::ShuffleSeed> const& seeds)
+{
+    std::vector<uint8_t> file;
+    Klondike::WriteReplayFileHeader(file);
+    file[4] = 1;
+    for (auto& seed : seeds)
+    {
+        auto moves = PlayMoves(seed, 40);
+        std::vector<uint8_t> game;
+        Klondike::WriteReplayGame(game, seed, moves.data(), moves.size());
+        game.erase(game.begin() + 16);
+        file.insert(file.end(), game.begin(), game.end());
+    }
+    return file;
+}
+
+static std::vector<Klondike::ReplayGame> ReadGames(std::vector<uint8_t> const& file, bool& isComplete)
+{
+    std::vector<Klondike::ReplayGame> games;
+    Klondike::ReplayReader reader(file.data(), file.size());
+    Klondike::ReplayGame game;
+    while (reader.Next(game))
+    {
+        games.push_back(game);
+    }
+    isComplete = reader.IsValid() && reader.Offset() == file.size();
+    return games;
+}
+
+static void ReplayUpgradeThenAppend()
+{
+    std::vector<Klondike::ShuffleSeed> legacySeeds = {
+        { 1, 0, 0, 0, Klondike::ShuffleVersion::Legacy },
+        { 2, 0, 0, 0, Klondike::ShuffleVersion::Legacy },
+    };
+    auto old = MakeVersion1File(legacySeeds);
+    CHECK(Klondike::ReplayFileVersion(old.data(), old.size()) == 1);
+
+    std::vector<uint8_t> file;
+    CHECK(Klondike::UpgradeReplayFile(old.data(), old.size(), file));
+    CHECK(Klondike::ReplayFileVersion(file.data(), file.size()) == Klondike::ReplayVersion);
+
+    // What the app does next: add a game dealt with the current shuffle.
+    Klondike::ShuffleSeed seed{ 3, 0, 0, 0 };
+    auto moves = PlayMoves(seed, 40);
+    Klondike::WriteReplayGame(file, seed, moves.data(), moves.size());
+
+    auto isComplete = false;
+    auto games = ReadGames(file, isComplete);
+    CHECK(isComplete);
+    CHECK(games.size() == 3);
+    for (size_t i = 0; i < games.size() && i < 3; i++)
+    {
+        auto expected = i < legacySeeds.size() ? legacySeeds[i] : seed;
+        CHECK(games[i].Seed.Num1 == expected.Num1);
+        CHECK(games[i].Seed.Version == expected.Version);
+        CHECK(games[i].MoveCount == 40);
+        CHECK(Klondike::ValidateReplay(games[i]).IsValid);
+    }
+}
+TEST("Replay/UpgradeThenAppend", ReplayUpgradeThenAppend);
+
+static void ReplayUpgradeCurrentVersion()
+{
+    std::vector<uint8_t> file;
+    Klondike::WriteReplayFileHeader(file);
+    Klondike::ShuffleSeed seed{ 5, 0, 0, 0 };
+    auto moves = PlayMoves(seed, 40);
+    Klondike::WriteReplayGame(file, seed, moves.data(), moves.size());
+
+    std::vector<uint8_t> upgraded;
+    CHECK(Klondike::UpgradeReplayFile(file.data(), file.size(), upgraded));
+    CHECK(upgraded == file);
+}
+TEST("Replay/UpgradeCurrentVersion", ReplayUpgradeCurrentVersion);
+
+static void ReplayUpgradeRejectsUnreadable()
+{
+    std::vector<uint8_t> upgraded;
+
+    auto truncated = MakeVersion1File({ { 1, 0, 0, 0, Klondike::ShuffleVersion::Legacy } });
+    truncated.pop_back();
+    CHECK(!Klondike::UpgradeReplayFile(truncated.data(), truncated.size(), upgraded));
+    CHECK(upgraded.empty());
+
+    std::vector<uint8_t> newer;
+    Klondike::WriteReplayFileHeader(newer);
+    newer[4] = Klondike::ReplayVersion + 1;
+    CHECK(Klondike::ReplayFileVersion(newer.data(), newer.size()) == Klondike::ReplayVersion + 1);
+    CHECK(!Klondike::UpgradeReplayFile(newer.data(), newer.size(), upgraded));
+
+    uint8_t const text[] = "seed,status,moves";
+    CHECK(Klondike::ReplayFileVersion(text, sizeof(text)) == 0);
+    CHECK(!Klondike::UpgradeReplayFile(text, sizeof(text), upgraded));
+    CHECK(Klondike::ReplayFileVersion(nullptr, 0) == 0);
+}
+TEST("Replay/UpgradeRejectsUnreadable", ReplayUpgradeRejectsUnreadable);
+
+// Keys in one bucket share the bits that picked it, so each of the 48 bits
+// below those has to tell them apart.
+static void TranspositionTableKeysInOneBucket()
+{
+    Klondike::TranspositionTable table(0);
+    auto bucketBits = 0;
+    while ((1ull << bucketBits) < table.BucketCount())
+    {
+        bucketBits++;
+    }
+
+    uint64_t key = 0x9e3779b97f4a7c15;
+    CHECK(table.Insert(key, 1));
+    CHECK(table.Contains(key));
+    for (auto bit = 64 - bucketBits - 48; bit < 64 - bucketBits; bit++)
+    {
+        auto other = key ^ (1ull << bit);
+        CHECK(table.BucketOf(other) == table.BucketOf(key));
+        CHECK(!table.Contains(other));
+    }
+}
+TEST("TranspositionTable/KeysInOneBucket", TranspositionTableKeysInOneBucket);
+
+// Deals the seed and plays moves that leave the stock alone, so the position
+// can be set up again from its columns and foundations.
+static Klondike::State PlayColumnMoves(Klondike::ShuffleSeed seed, int count)
+{
+    auto state = Klondike::Deal(seed);
+    Klondike::Move generated[Klondike::MaxMoves];
+    for (auto i = 0; i < count; i++)
+    {
+        auto kept = 0;
+        auto moveCount = Klondike::GenerateMoves(state, generated);
+        for (auto j = 0; j < moveCount; j++)
+        {
+            if (Klondike::IsColumn(generated[j].From) || Klondike::IsColumn(generated[j].To))
+            {
+                generated[kept++] = generated[j];
+            }
+        }
+        if (kept == 0)
+        {
+            break;
+        }
+        state.Apply(generated[i % kept]);
+    }
+    return state;
+}
+
+// Puts the cards on the foundations through the last column, which has to be
+// empty, the first card first.
+static void FoundCards(Klondike::State& state, std::vector<Card> const& cards)
+{
+    auto column = Klondike::ColumnCount - 1;
+    std::vector<Card> reversed(cards.rbegin(), cards.rend());
+    state.SetColumn(column, reversed.data(), (int)reversed.size(), 0);
+    for (size_t i = 0; i < cards.size(); i++)
+    {
+        auto isFounded = false;
+        for (auto foundation = 0; foundation < Klondike::FoundationCount && !isFounded; foundation++)
+        {
+            Klondike::Move move;
+            move.From = Klondike::ColumnLocation(column);
+            move.To = Klondike::FoundationLocation(foundation);
+            move.Count = 1;
+            if (state.IsLegal(move))
+            {
+                state.Apply(move);
+                isFounded = true;
+            }
+        }
+        CHECK(isFounded);
+    }
+}
+
+static std::vector<Card> FoundationCards(Klondike::State const& state)
+{
+    std::vector<Card> cards;
+    for (auto foundation = 0; foundation < Klondike::FoundationCount; foundation++)
+    {
+        for (auto face = 1; face <= state.FoundationSize(foundation); face++)
+        {
+            cards.push_back(Card((Face)face, state.FoundationTop(foundation).Suit()));
+        }
+    }
+    return cards;
+}
+
+// Positions that only differ in the order of their columns are the same
+// position, to the key and to operator==.
+static void StateKeyIgnoresColumnOrder()
+{
+    for (auto seed = 0u; seed < 20; seed++)
+    {
+        auto state = PlayColumnMoves({ seed, 0, 0, 0 }, 30);
+        auto talonSize = state.StockSize();
+        std::vector<Card> talon;
+        for (auto i = 0; i < talonSize; i++)
+        {
+            talon.push_back(state.StockCard(i));
+        }
+
+        // Reversed, then rotated by the seed.
+        Klondike::State permuted;
+        FoundCards(permuted, FoundationCards(state));
+        for (auto column = 0; column < Klondike::ColumnCount; column++)
+        {
+            auto from = (Klondike::ColumnCount - 1 - column + (int)seed) % Klondike::ColumnCount;
+            std::vector<Card> cards;
+            for (auto i = 0; i < state.ColumnSize(from); i++)
+            {
+                cards.push_back(state.ColumnCard(from, i));
+            }
+            permuted.SetColumn(column, cards.data(), (int)cards.size(), state.HiddenCount(from));
+        }
+        permuted.SetTalon(talon.data(), (int)talon.size());
+
+        CHECK(state.WasteSize() == 0);
+        CHECK(permuted.Key() == state.Key());
+        CHECK(permuted.ComputeKey() == state.ComputeKey());
+        CHECK(permuted == state);
+    }
+}
+TEST("State/KeyIgnoresColumnOrder", StateKeyIgnoresColumnOrder);
+
+// Founding the 5 of diamonds looks safe with both black fours founded, but the
+// 2 of hearts is hidden under the 3, and the only way to turn it over is to
+// bring the 4 of spades back down onto the 5 for the 3 to move to. Every rule
+// has to leave it winnable.
+static Klondike::State SafeFoundationTrap()
+{
+    Klondike::State state;
+    std::vector<Card> founded;
+    for (auto suit : { Suit::Spade, Suit::Club, Suit::Diamond })
+    {
+        for (auto face = 1; face <= 4; face++)
+        {
+            founded.push_back(Card((Face)face, suit));
+        }
+    }
+    founded.push_back(Card(Face::Ace, Suit::Heart));
+    FoundCards(state, founded);
+
+    // The rest of each suit is hidden in a column of its own, to be turned
+    // over in the order it's founded.
+    auto setColumn = [&](int column, Suit suit, int lowestHidden, std::vector<Card> hiddenOnTop, Card faceUp)
+    {
+        std::vector<Card> cards;
+        for (auto face = (int)Face::King; face >= lowestHidden; face--)
+        {
+            cards.push_back(Card((Face)face, suit));
+        }
+        cards.insert(cards.end(), hiddenOnTop.begin(), hiddenOnTop.end());
+        cards.push_back(faceUp);
+        state.SetColumn(column, cards.data(), (int)cards.size(), (int)cards.size() - 1);
+    };
+    setColumn(0, Suit::Heart, 4, { Card(Face::Two, Suit::Heart) }, Card(Face::Three, Suit::Heart));
+    setColumn(1, Suit::Diamond, 6, {}, Card(Face::Five, Suit::Diamond));
+    setColumn(2, Suit::Spade, 6, {}, Card(Face::Five, Suit::Spade));
+    setColumn(3, Suit::Club, 6, {}, Card(Face::Five, Suit::Club));
+    return state;
+}
+
+static void SolverSafeFoundationTrap()
+{
+    auto state = SafeFoundationTrap();
+    for (uint8_t rules : { Klondike::NoPruneRules, Klondike::SafeFoundationMoves, Klondike::KingsBetweenEmptyColumns, Klondike::RepeatColumnMoves, Klondike::AllPruneRules })
+    {
+        Klondike::SolveOptions options;
+        options.Pruning = rules;
+        options.TableBytes = 1 << 20;
+        CHECK(Klondike::Solver(options).Solve(state).Status == Klondike::SolveStatus::Winnable);
+        options.ThreadCount = 2;
+        CHECK(Klondike::ParallelSolver(options).Solve(state).Status == Klondike::SolveStatus::Winnable);
+    }
+}
+TEST("Solver/SafeFoundationTrap", SolverSafeFoundationTrap);
+
+// Deals every search option decides well inside the node budget, half of
+// them unwinnable.
+constexpr unsigned int DecidedSeeds[] = { 1, 2, 5, 8, 14, 16, 17, 19, 24, 27, 30, 36, 44, 45, 53, 56, 57, 58, 69, 77 };
+
+// Solves the deals both ways, which have to agree on every one.
+static void CheckSameStatus(Klondike::SolveOptions first, Klondike::SolveOptions second)
+{
+    Klondike::Solver firstSolver(first);
+    Klondike::Solver secondSolver(second);
+    for (auto seed : DecidedSeeds)
+    {
+        auto state = Klondike::Deal(Klondike::ShuffleSeed{ seed, 0, 0, 0 });
+        auto firstStatus = firstSolver.Solve(state).Status;
+        auto secondStatus = secondSolver.Solve(state).Status;
+        CHECK(firstStatus != Klondike::SolveStatus::Unknown);
+        CHECK(firstStatus == secondStatus);
+    }
+}
+
+static Klondike::SolveOptions SweepOptions()
+{
+    Klondike::SolveOptions options;
+    options.MaxNodes = 200000;
+    options.TableBytes = 8 << 20;
+    return options;
+}
+
+static void SolverPruningKeepsStatus()
+{
+    auto pruned = SweepOptions();
+    auto unpruned = SweepOptions();
+    unpruned.Pruning = Klondike::NoPruneRules;
+    CheckSameStatus(pruned, unpruned);
+}
+TEST("Solver/PruningKeepsStatus", SolverPruningKeepsStatus);
+
+static void SolverStockPlaysKeepStatus()
+{
+    auto plays = SweepOptions();
+    auto draws = SweepOptions();
+    draws.Stock = Klondike::StockMoves::Draws;
+    CheckSameStatus(plays, draws);
+}
+TEST("Solver/StockPlaysKeepStatus", SolverStockPlaysKeepStatus);
+
+int main(int argc, char** argv)
+{
+    char const* filter = argc > 1 ? argv[1] : "";
+    auto failedTests = 0;
+    auto testCount = 0;
+    for (auto& test : Tests())
+    {
+        if (std::strstr(test.Name, filter) == nullptr)
+        {
+            continue;
+        }
+        auto failures = s_failures;
+        test.Run();
+        testCount++;
+        if (s_failures != failures)
+        {
+            std::fprintf(stderr, "FAILED %s\n", test.Name);
+            failedTests++;
+        }
+    }
+    std::fprintf(stderr, "%d tests, %d failed\n", testCount, failedTests);
+    return failedTests == 0 ? 0 : 1;
+}